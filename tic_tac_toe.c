@@ -1,1337 +1,5695 @@
-#include <stdbool.h>
-#include <stdio.h>
-
-// Functions related to keyboard interrupts set-up
-void disable_A9_interrupts(void);
-void set_A9_IRQ_stack(void);
-void config_GIC(void);
-void config_KEYs(void);
-void enable_A9_interrupts(void);
-void keyboard_ISR(void);
-void config_interrupt(int, int);
-
-// Functions for drawing objects onto the screen
-void draw_player(int boardIndex);
-void draw_player_X(int boardIndex);
-void draw_player_O(int boardIndex);
-void initial_screen();
-void plot_pixel(int x, int y, short int line_color);
-void draw_line(int x0, int y0, int x1, int y1, short int line_color);
-void draw_selection_box(int x, int y, short int selection_colour);
-void swap(int *first, int *second);
-void draw_board(void);
-void write_text(int x, int y, char * text_ptr);
-void clear_screen();
-
-// Functions which handle the tic-tac-toe logic
-int check_winner();
-void clear_text ();
-void checkforStalemate();
-void AI_move();
-
-// Global variables
-int selection_x;
-int selection_y;
-bool isStalemate = false;
-char Turn;
-int board[9]; 
-volatile int pixel_buffer_start; // global variable, to draw 
-
-int main(void) {
-	clear_text();
-	
-	// First turn goes to X
-	Turn = 'X';
-	
-	// This is the top left corner of the first box
-	// Red selection box starts here initially
-	selection_x = 25;
-	selection_y = 25;
-	
-	volatile int * pixel_ctrl_ptr = (int *)0xFF203020;
-    
-	/* Read location of the pixel buffer from the pixel buffer controller */
-    pixel_buffer_start = *pixel_ctrl_ptr;
-	
-	clear_screen();
-	initial_screen();
-	
-	disable_A9_interrupts(); // disable interrupts in the A9 processor
-	set_A9_IRQ_stack(); // initialize the stack pointer for IRQ mode
-	config_GIC(); // configure the general interrupt controller
-	config_KEYs(); // configure pushbutton KEYs to generate interrupts
-	enable_A9_interrupts(); // enable interrupts in the A9 processor
-	
-	while (1); // wait for an interrupt
-}
-
-
-/* setup the PS/2 interrupts in the FPGA */
-void config_KEYs() {
-	volatile int * PS2_ptr = (int *) 0xFF200100; // PS/2 base address
-	*(PS2_ptr + 1) = 0x00000001; // set RE to 1 to enable interrupts
-}
-
-// Define the IRQ exception handler
-void __attribute__((interrupt)) __cs3_isr_irq(void) {
-	// Read the ICCIAR from the CPU Interface in the GIC
-	int interrupt_ID = *((int *)0xFFFEC10C);
-	if (interrupt_ID == 79) // check if interrupt is from the KEYs
-	keyboard_ISR();
-	else
-	while (1); // if unexpected, then stay here
-	// Write to the End of Interrupt Register (ICCEOIR)
-	*((int *)0xFFFEC110) = interrupt_ID;
-}
-
-// Define the remaining exception handlers
-void __attribute__((interrupt)) __cs3_reset(void) {
-	while (1);
-}
-
-void __attribute__((interrupt)) __cs3_isr_undef(void) {
-	while (1);
-}
-
-void __attribute__((interrupt)) __cs3_isr_swi(void) {
-	while (1);
-}
-
-void __attribute__((interrupt)) __cs3_isr_pabort(void) {
-	while (1);
-}
-
-void __attribute__((interrupt)) __cs3_isr_dabort(void) {
-	while (1);
-}
-
-void __attribute__((interrupt)) __cs3_isr_fiq(void) {
-	while (1);
-}
-
-//Initialize the banked stack pointer register for IRQ mode
-void set_A9_IRQ_stack(void) {
-	int stack, mode;
-	stack = 0xFFFFFFFF - 7; // top of A9 onchip memory, aligned to 8 bytes
-	/* change processor to IRQ mode with interrupts disabled */
-	mode = 0b11010010;
-	asm("msr cpsr, %[ps]" : : [ps] "r"(mode));
-	/* set banked stack pointer */
-	asm("mov sp, %[ps]" : : [ps] "r"(stack));
-	/* go back to SVC mode before executing subroutine return! */
-	mode = 0b11010011;
-	asm("msr cpsr, %[ps]" : : [ps] "r"(mode));
-}
-
-/*
-* Turn on interrupts in the ARM processor
-*/
-void enable_A9_interrupts(void) {
-	int status = 0b01010011;
-	asm("msr cpsr, %[ps]" : : [ps] "r"(status));
-}
-
-// Turn off interrupts in the ARM processor
-void disable_A9_interrupts(void) {
-	int status = 0b11010011;
-	asm("msr cpsr, %[ps]" : : [ps] "r"(status));
-}
-
-/*
-* Configure the Generic Interrupt Controller (GIC)
-*/
-void config_GIC(void) {
-	config_interrupt (79, 1); // configure the FPGA KEYs interrupt (73)
-	// Set Interrupt Priority Mask Register (ICCPMR). Enable interrupts of all
-	// priorities
-	*((int *) 0xFFFEC104) = 0xFFFF;
-	// Set CPU Interface Control Register (ICCICR). Enable signaling of
-	// interrupts
-	*((int *) 0xFFFEC100) = 1;
-	// Configure the Distributor Control Register (ICDDCR) to send pending
-	// interrupts to CPUs
-	*((int *) 0xFFFED000) = 1;
-}
-
-/*
-* Configure Set Enable Registers (ICDISERn) and Interrupt Processor Target
-* Registers (ICDIPTRn). The default (reset) values are used for other registers
-* in the GIC.
-*/
-void config_interrupt(int N, int CPU_target) {
-	int reg_offset, index, value, address;
-	/* Configure the Interrupt Set-Enable Registers (ICDISERn).
-	* reg_offset = (integer_div(N / 32) * 4
-	* value = 1 << (N mod 32) */
-	reg_offset = (N >> 3) & 0xFFFFFFFC;
-	index = N & 0x1F;
-	value = 0x1 << index;
-	address = 0xFFFED100 + reg_offset;
-	/* Now that we know the register address and value, set the appropriate bit */
-	*(int *)address |= value;
-
-	/* Configure the Interrupt Processor Targets Register (ICDIPTRn)
-	* reg_offset = integer_div(N / 4) * 4
-	* index = N mod 4 */
-	reg_offset = (N & 0xFFFFFFFC);
-	index = N & 0x3;
-	address = 0xFFFED800 + reg_offset + index;
-	/* Now that we know the register address and value, write to (only) the
-	* appropriate byte */
-	*(char *)address = (char)CPU_target;
-}
-
-void plot_pixel(int x, int y, short int line_color)
-{
-    *(short int *)(pixel_buffer_start + (y << 10) + (x << 1)) = line_color;
-}
-
-// Clear screen by writing black into the address
-void clear_screen (){
-	int y,x;
-	for(x=0;x<320;x++){
-		for(y=0;y<240;y++){
-			plot_pixel(x,y,0x0000);
-		}
-	}
-}
-
-// Clear any text on the screen by writing " " into the address
-void clear_text (){
-	int y,x;
-	for(x=0;x<80;x++){
-		for(y=0;y<60;y++){
-			char clear[1] = " \0";
-			write_text(x, y, clear);
-		}
-	}
-}
-
-// Function which handles what to do once a keyboard interrupt is given
-void keyboard_ISR(void) {
-
-	volatile int * PS2_ptr = (int *)0xFF200100; // Points to PS2 Base
-	unsigned char byte0 = 0;
-    
-	int PS2_data = *(PS2_ptr);
-	int RVALID = PS2_data & 0x8000;
-	
-	//Read Interrupt Register
-	int readInterruptReg;
-	readInterruptReg = *(PS2_ptr + 1 ); 
-	  
-	//Clear Interrupt 
-	*(PS2_ptr+1) = readInterruptReg; 
-
-	// when RVALID is 1, there is data 
-	if (RVALID != 0){
-               
-		byte0 = (PS2_data & 0xFF); //data in LSB	
-	
-		if(byte0 == 0x22){  //X, start game
-			clear_screen();
-			clear_text();
-			draw_board();
-			draw_selection_box(selection_x, selection_y, 0xF800);
-			isStalemate = false;
-			char player_status[150] = "                    Player X's Turn!                      \0";
-			write_text(14, 55, player_status);
-		}
-		
-		if(byte0 == 0x1D){  //UP, W
-			// Erase currently drawn selection box by drawing it black
-			draw_selection_box(selection_x, selection_y, 0x0000);
-			draw_board();
-			selection_y = selection_y - 63;
-			
-			// Loop back to the first box
-			if (selection_y == -38){
-				selection_y = 151;
-			}
-			
-			draw_selection_box(selection_x, selection_y, 0xF800);
-		}
-
-		if(byte0 == 0x1B){ //DOWN, S
-			// Erase currently drawn selection box by drawing it black
-			draw_selection_box(selection_x, selection_y, 0x0000);
-			draw_board();
-			selection_y = selection_y + 63;
-			
-			// Loop back to the first box
-			if (selection_y == 214){
-				selection_y = 25;
-			}
-			
-			draw_selection_box(selection_x, selection_y, 0xF800);
-		}
-	
-		if(byte0 == 0x1C){ //LEFT, A
-			// Erase currently drawn selection box by drawing it black
-			draw_selection_box(selection_x, selection_y, 0x0000);
-			draw_board();
-			selection_x = selection_x - 90;
-			
-			// Loop back to the first box
-			if (selection_x == -65){
-				selection_x = 205;
-			}
-			
-			draw_selection_box(selection_x, selection_y, 0xF800);
-		}
-
-		if(byte0 == 0x23){ //RIGHT, D
-			// Erase currently drawn selection box by drawing it black
-			draw_selection_box(selection_x, selection_y, 0x0000);
-			draw_board();
-			selection_x = selection_x + 90;
-			
-			// Loop back to the first box
-			if (selection_x == 295){
-				selection_x = 25;
-			}
-			
-			draw_selection_box(selection_x, selection_y, 0xF800);
-		}
-
-		if(byte0 == 0x29){  //SpaceBar , Restart Game
-			clear_screen(0,0,0x0000); 
-			clear_text();
-			draw_board();
-			
-			Turn = 'X';
-			memset(board, 0, sizeof(board));
-			
-			char clear_winner_status[150] = "                                                     \0";                             
-			write_text(14, 55, clear_winner_status);
-			
-			// Reinitialize selection box to the top left box
-			selection_x = 25;
-			selection_y = 25;
-			draw_selection_box(selection_x, selection_y, 0xF800);
-			
-			char player_status[150] = "                    Player X's Turn!                      \0";
-			write_text(14, 55, player_status);
-			isStalemate = false;
-
-		}  
-		
-		if(byte0 == 0x16){ //Select Box 1 
-			draw_selection_box(selection_x, selection_y, 0x0000);
-			draw_board();
-			
-			selection_x = 25;
-			selection_y = 25;
-			
-			draw_selection_box(selection_x, selection_y, 0xF800);
-		}
-		
-		if(byte0 == 0x1E){ //Select Box 2 
-			draw_selection_box(selection_x, selection_y, 0x0000);
-			draw_board();
-			
-			selection_x = 115;
-			selection_y = 25;
-			
-			draw_selection_box(selection_x, selection_y, 0xF800);
-
-		}
-		
-		if(byte0 == 0x26){ //Select Box 3 
-			draw_selection_box(selection_x, selection_y, 0x0000);
-			draw_board();
-			
-			selection_x = 205;
-			selection_y = 25;
-			
-			draw_selection_box(selection_x, selection_y, 0xF800);
-		}
-		
-		if(byte0 == 0x25){//Select Box 4
-			draw_selection_box(selection_x, selection_y, 0x0000);
-			draw_board();
-			
-			selection_x = 25;
-			selection_y = 88;
-			
-			draw_selection_box(selection_x, selection_y, 0xF800);
-		}
-		
-		if(byte0 == 0x2E){//Select Box 5
-			draw_selection_box(selection_x, selection_y, 0x0000);
-			draw_board();
-			
-			selection_x = 115;
-			selection_y = 88;
-			
-			draw_selection_box(selection_x, selection_y, 0xF800);
-		}
-		
-		if(byte0 == 0x36){//Select Box 6
-			draw_selection_box(selection_x, selection_y, 0x0000);
-			draw_board();
-			
-			selection_x = 205;
-			selection_y = 88;
-			
-			draw_selection_box(selection_x, selection_y, 0xF800);
-		}
-		
-		if(byte0 == 0x3D){//Select Box 7
-			draw_selection_box(selection_x, selection_y, 0x0000);
-			draw_board();
-			
-			selection_x = 25;
-			selection_y = 151;
-			
-			draw_selection_box(selection_x, selection_y, 0xF800);
-		}
-		
-		if(byte0 == 0x3E){//Select Box 8
-			draw_selection_box(selection_x, selection_y, 0x0000);
-			draw_board();
-			
-			selection_x = 115;
-			selection_y = 151;
-			
-			draw_selection_box(selection_x, selection_y, 0xF800);
-		}
-		
-		if(byte0 == 0x46){//Select Box 9
-			draw_selection_box(selection_x, selection_y, 0x0000);
-			draw_board();
-			
-			selection_x = 205;
-			selection_y = 151;
-			
-			draw_selection_box(selection_x, selection_y, 0xF800);
-		}
-		
-		if(byte0 == 0x33){//H-Help Screen
-			clear_screen();			
-			clear_text();
-			
-			char title[100] = "Tic-Tac-Toe Help Screen\0";
-			write_text(28, 3, title);
-			
-			char instructions[100] = "Try to get 3 consecutive boxes to win the game!\0";
-			write_text(8, 7, instructions);
-			
-			char controls[20] = "Game Controls: \0";
-			write_text(8, 10, controls);
-			
-			char number_keys[70] = "[1]-[9]: Select board index\0";
-			write_text(8, 13, number_keys);
-			
-			char selection_key_a[70] = "[A]: Move red selection box left\0";
-			write_text(8, 15, selection_key_a);
-			
-			char selection_key_d[70] = "[D]: Move red selection box right\0";
-			write_text(8, 17, selection_key_d);
-			
-			char selection_key_w[70] = "[W]: Move red selection box up\0";
-			write_text(8, 19, selection_key_w);
-			
-			char selection_key_s[70] = "[S]: Move red selection box down\0";
-			write_text(8, 21, selection_key_s);	
-			
-			char enter[70] = "[enter]: Place piece/ Make a move\0";
-			write_text(8, 23, enter);
-			
-			char help[70] = "[H]: Help screen\0";
-			write_text(8, 25, help);
-
-			char AI[70] = "[C]: Computer makes a move\0";
-			write_text(8, 27, AI);
-			
-			char spacebar[70] = "[spacebar]: Restart game\0";
-			write_text(8, 29, spacebar);	
-			
-			char resume[70] = "Press [ESC] to resume the game\0";
-			write_text(8, 31, resume);	
-		}
-		
-		if(byte0 == 0x76){ //Escape - Resume game
-			clear_screen();
-			clear_text();
-			draw_board();
-			draw_selection_box(selection_x, selection_y, 0xF800);
-			
-			for (int i = 0; i < 9; i++){
-				if (board[i] == 1){
-					draw_player_X(i+1);
-				} else if (board[i] == 2){
-					draw_player_O(i+1);
-				}
-			}
-			
-			if (Turn == 'X'){
-				Turn = 'O';
-				char player_status[150] = "                    Player O's Turn!                      \0";
-				write_text(14, 55, player_status);
-			} else {
-				Turn = 'X';
-				char player_status[150] = "                    Player X's Turn!                      \0";
-				write_text(14, 55, player_status);
-			}
-		}
-
-		if (byte0 == 0x21) { //C - AI makes a move if this is clicked
-			AI_move();
-
-			// check winner
-			int winner = check_winner();
-			
-			// No winner
-			if (winner == 0){
-				// Switch turn 
-				if (Turn == 'X'){
-					Turn = 'O';
-					char player_status[150] = "                    Player O's Turn!                      \0";
-					write_text(14, 55, player_status);
-				} else {
-					Turn = 'X';
-					char player_status[150] = "                    Player X's Turn!                      \0";
-					write_text(14, 55, player_status);
-				}
-				
-			// X wins
-			} else if (winner == 1){
-				// hide selection box
-				draw_selection_box(selection_x, selection_y, 0x0000);
-				draw_board();
-				
-				// show winner status & prompt new game
-				char winner_status[150] = "Player X Wins! Press [spacebar] to start a new game.\0";
-				write_text(14, 55, winner_status);
-				
-			// O wins
-			} else if (winner == 2){
-				// hide selection box
-				draw_selection_box(selection_x, selection_y, 0x0000);
-				draw_board();
-				
-				// show winner status & prompt new game
-				char winner_status[150] = "Player O Wins! Press [spacebar] to start a new game.\0";
-				write_text(14, 55, winner_status);
-			
-			// Stalemate
-			} else if (winner == 3){
-				// hide selection box
-				draw_selection_box(selection_x, selection_y, 0x0000);
-				draw_board();
-				
-				// show tie status & prompt new game
-				char winner_status[150] = "It's a tie! Press [spacebar] to start a new game.\0";
-				write_text(14, 55, winner_status);
-			}
-		}
-		
-		if(byte0 == 0x5A){ //Enter - place piece on board
-			// check which board index 
-			int boardIndex = 0; 
-			
-			if (selection_x == 25 & selection_y == 25){
-				boardIndex = 1; 
-			} else if (selection_x == 115 & selection_y == 25){
-				boardIndex = 2; 
-			} else if (selection_x == 205 & selection_y == 25){
-				boardIndex = 3; 
-			} else if (selection_x == 25 & selection_y == 88){
-				boardIndex = 4; 
-			} else if (selection_x == 115 & selection_y == 88){
-				boardIndex = 5; 
-			} else if (selection_x == 205 & selection_y == 88){
-				boardIndex = 6; 
-			} else if (selection_x == 25 & selection_y == 151){
-				boardIndex = 7; 
-			} else if (selection_x == 115 & selection_y == 151){
-				boardIndex = 8; 
-			} else if (selection_x == 205 & selection_y == 151){
-				boardIndex = 9; 
-			}
-			
-			// Only draw if box is empty
-			if (board[boardIndex - 1] == 0){
-				
-				// update array	
-				// 0 means empty, 1 means there is an X, 2 means there is an O
-				if (Turn == 'X'){
-					board[boardIndex - 1] = 1;
-				} else {
-					board[boardIndex - 1] = 2;
-				}
-				
-				// draw player
-				draw_player(boardIndex);
-				
-				// check winner
-				int winner = check_winner();
-				
-				// No winner
-				if (winner == 0){
-					// Switch turn 
-					if (Turn == 'X'){
-						Turn = 'O';
-						char player_status[150] = "                    Player O's Turn!                      \0";
-						write_text(14, 55, player_status);
-					} else {
-						Turn = 'X';
-						char player_status[150] = "                    Player X's Turn!                      \0";
-						write_text(14, 55, player_status);
-					}
-					
-				// X wins
-				} else if (winner == 1){
-					// hide selection box
-					draw_selection_box(selection_x, selection_y, 0x0000);
-					draw_board();
-					
-					// show winner status & prompt new game
-					char winner_status[150] = "Player X Wins! Press [spacebar] to start a new game.\0";
-					write_text(14, 55, winner_status);
-					
-				// O wins
-				} else if (winner == 2){
-					// hide selection box
-					draw_selection_box(selection_x, selection_y, 0x0000);
-					draw_board();
-					
-					// show winner status & prompt new game
-					char winner_status[150] = "Player O Wins! Press [spacebar] to start a new game.\0";
-					write_text(14, 55, winner_status);
-				
-				// Stalemate
-				} else if (winner == 3){
-					// hide selection box
-					draw_selection_box(selection_x, selection_y, 0x0000);
-					draw_board();
-					
-					// show tie status & prompt new game
-					char winner_status[150] = "It's a tie! Press [spacebar] to start a new game.\0";
-					write_text(14, 55, winner_status);
-				}
-			}
-		}
-				
-		if(byte0 == 0xF0) {
-			// Check for break
-			switch (PS2_data & 0xFF) {
-				case 0x1D:
-					break;
-				case 0x1B:
-					break;
-				case 0x1C:
-					break;
-				case 0x23:
-					break;
-				default:
-					break;
-			}	
-		}
-					
-	} 
-	return;
-}
-
-void draw_line(int x0, int y0, int x1, int y1, short int line_color) {
-    bool is_steep = ( abs(y1 - y0) > abs(x1 - x0) );
-	
-    if (is_steep) {
-        swap(&x0, &y0);
-        swap(&x1, &y1);
-    }
-   
-    if (x0 > x1) {
-        swap(&x0, &x1);
-        swap(&y0, &y1);
-    }
-    
-    int delta_x = x1 - x0;
-    int delta_y = abs(y1 - y0);
-    int error = -(delta_x / 2);
-    
-    int y = y0;
-    int y_step;
-    if (y0 < y1) 
-        y_step =1;
-    else 
-        y_step = -1;
-    
-    for(int x = x0; x <= x1; x++) {
-        if (is_steep) 
-            plot_pixel(y, x, line_color);
-        else 
-            plot_pixel(x, y, line_color);
-        
-        error += delta_y;
-        
-        if (error >= 0) {
-            y +=y_step;
-            error -= delta_x;
-        }
-    } 
-}
-
-void swap(int *first, int *second){
-	int temp = *first;
-    *first = *second;
-    *second = temp;   
-}
-
-void draw_board(void){
-	draw_line(114, 25, 114, 213, 0XFFFF);
-	draw_line(115, 25, 115, 213, 0XFFFF);
-	draw_line(116, 25, 116, 213, 0XFFFF);
-	
-	draw_line(204, 25, 204, 213, 0XFFFF);
-	draw_line(205, 25, 205, 213, 0XFFFF);
-	draw_line(206, 25, 206, 213, 0XFFFF);
-
-	draw_line(25, 87, 295, 87, 0XFFFF);
-	draw_line(25, 88, 295, 88, 0XFFFF);
-	draw_line(25, 89, 295, 89, 0XFFFF);
-	
-	draw_line(25, 150, 295, 150, 0XFFFF);
-	draw_line(25, 151, 295, 151, 0XFFFF);
-	draw_line(25, 152, 295, 152, 0XFFFF);
-	
-	char text_top_row[100] = "Welcome to Tic-Tac-Toe!\0";
-	write_text(28, 3, text_top_row);
-	
-	// Top left box 
-	char top_left_box_number[10] = "1\0";
-	write_text(8, 7, top_left_box_number);
-	
-	// Top middle box 
-	char top_middle_box_number[10] = "2\0";
-	write_text(30, 7, top_middle_box_number);
-	
-	// Top right box 
-	char top_right_box_number[10] = "3\0";
-	write_text(53, 7, top_right_box_number);
-	
-	// Middle left box 
-	char middle_left_box_number[10] = "4\0";
-	write_text(8, 24, middle_left_box_number);
-	
-	// Middle middle box 
-	char middle_middle_box_number[10] = "5\0";
-	write_text(30, 24, middle_middle_box_number);
-	
-	// Middle right box 
-	char middle_right_box_number[10] = "6\0";
-	write_text(53, 24, middle_right_box_number);
-	
-	// Bottom left box 
-	char bottom_left_box_number[10] = "7\0";
-	write_text(8, 39, bottom_left_box_number);
-	
-	// Bottom middle box 
-	char bottom_middle_box_number[10] = "8\0";
-	write_text(30, 39, bottom_middle_box_number);
-	
-	// Bottom right box 
-	char bottom_right_box_number[10] = "9\0";
-	write_text(53, 39, bottom_right_box_number);
-	
-	char winner_status[50] = "Press [H] for help screen.";
-	write_text(5, 57, winner_status);
-}
-
-void write_text(int x, int y, char * text_ptr) {
-	int offset;
-	volatile char * character_buffer = (char *)0xC9000000; // video character buffer
-	
-	/* assume that the text string fits on one line */
-	offset = (y << 7) + x;
-	
-	while (*(text_ptr)) {
-		*(character_buffer + offset) = *(text_ptr); // write to the character buffer
-		++text_ptr;
-		++offset;
-	}
-}
-
-
-void draw_selection_box(int x, int y, short int selection_colour) {
-	draw_line(x, y, x + 90, y, selection_colour);
-	draw_line(x + 90, y, x + 90, y + 63, selection_colour);
-	draw_line(x + 90, y + 63, x, y + 63, selection_colour);
-	draw_line(x, y + 63, x, y, selection_colour);
-}
-
-void draw_player(int boardIndex){
-	if(Turn == 'X'){
-		draw_player_X(boardIndex);
-	} else {
-		draw_player_O(boardIndex);
-	}
-}
-
-void draw_player_X(int boardIndex){
-	// left diagonal coordinates
-	int initial_left_X0 = 29, initial_left_Y0 = 29, initial_left_X1 = 111, initial_left_Y1 = 84;
-	// right diagonal coordinates
-	int initial_right_X0 = 111, initial_right_Y0 = 29, initial_right_X1 = 29, initial_right_Y1 = 84;
-	
-	if(boardIndex == 1){
-		draw_line(initial_left_X0, initial_left_Y0, initial_left_X1, initial_left_Y1, 0xFFFF);
-		draw_line(initial_right_X0, initial_right_Y0, initial_right_X1, initial_right_Y1, 0xFFFF);
-		
-	} else if(boardIndex == 2){
-		draw_line(initial_left_X0 + 90, initial_left_Y0, initial_left_X1 + 90, initial_left_Y1, 0xFFFF);
-		draw_line(initial_right_X0 + 90, initial_right_Y0, initial_right_X1 + 90, initial_right_Y1, 0xFFFF);	
-		
-	} else if(boardIndex == 3){
-		draw_line(initial_left_X0 + 180, initial_left_Y0, initial_left_X1 + 180, initial_left_Y1, 0xFFFF);
-		draw_line(initial_right_X0 + 180, initial_right_Y0, initial_right_X1 + 180, initial_right_Y1, 0xFFFF);	
-		
-	} else if(boardIndex == 4){
-		draw_line(initial_left_X0, initial_left_Y0 + 63, initial_left_X1, initial_left_Y1 + 63, 0xFFFF);
-		draw_line(initial_right_X0, initial_right_Y0 + 63, initial_right_X1, initial_right_Y1 + 63, 0xFFFF);
-	
-	} else if(boardIndex == 5){
-		draw_line(initial_left_X0 + 90, initial_left_Y0 + 63, initial_left_X1 + 90, initial_left_Y1 + 63, 0xFFFF);
-		draw_line(initial_right_X0 + 90, initial_right_Y0 + 63, initial_right_X1 + 90, initial_right_Y1 + 65, 0xFFFF);
-		
-	} else if(boardIndex == 6){
-		draw_line(initial_left_X0 + 180, initial_left_Y0 + 63, initial_left_X1 + 180, initial_left_Y1 + 63, 0xFFFF);
-		draw_line(initial_right_X0 + 180, initial_right_Y0 + 63, initial_right_X1 + 180, initial_right_Y1 + 63, 0xFFFF);
-		
-	} else if(boardIndex == 7){
-		draw_line(initial_left_X0, initial_left_Y0 + 126, initial_left_X1, initial_left_Y1 + 126, 0xFFFF);
-		draw_line(initial_right_X0, initial_right_Y0 + 126, initial_right_X1, initial_right_Y1 + 126, 0xFFFF);
-		
-	} else if(boardIndex == 8){
-		draw_line(initial_left_X0 + 90, initial_left_Y0 + 126, initial_left_X1 + 90, initial_left_Y1 + 126, 0xFFFF);
-		draw_line(initial_right_X0 + 90, initial_right_Y0 + 126, initial_right_X1 + 90, initial_right_Y1 + 126, 0xFFFF);
-		
-	} else if(boardIndex == 9){
-		draw_line(initial_left_X0 + 180, initial_left_Y0 + 126, initial_left_X1 + 180, initial_left_Y1 + 126, 0xFFFF);
-		draw_line(initial_right_X0 + 180, initial_right_Y0 + 126, initial_right_X1 + 180, initial_right_Y1 + 126, 0xFFFF);
-	}
-}
-	
-void draw_player_O(int boardIndex){
-	int UpLine_R_X = 98, UpLine_R_Y = 27, UpLine_L_X = 42, UpLine_L_Y = 27;
-	int BottomLine_R_X = 98, BottomLine_R_Y = 86, BottomLine_L_X = 42, BottomLine_L_Y = 86;
-	
-	int LeftLine_U_X = 30, LeftLine_U_Y = 31, LeftLine_B_X = 30, LeftLine_B_Y = 82; 
-	int RightLine_U_X = 110, RightLine_U_Y = 31, RightLine_B_X = 110, RightLine_B_Y = 82; 
-	
-	if(boardIndex == 1){
-		draw_line(UpLine_R_X, UpLine_R_Y, UpLine_L_X, UpLine_L_Y, 0xFFFF);
-		draw_line(UpLine_L_X, UpLine_L_Y, LeftLine_U_X, LeftLine_U_Y, 0xFFFF);
-		draw_line(LeftLine_U_X, LeftLine_U_Y, LeftLine_B_X, LeftLine_B_Y, 0xFFFF);
-		draw_line(LeftLine_B_X, LeftLine_B_Y, BottomLine_L_X, BottomLine_L_Y, 0xFFFF);
-		draw_line(BottomLine_L_X, BottomLine_L_Y, BottomLine_R_X, BottomLine_R_Y, 0xFFFF);
-		draw_line(BottomLine_R_X, BottomLine_R_Y, RightLine_B_X, RightLine_B_Y, 0xFFFF);
-		draw_line(RightLine_B_X, RightLine_B_Y, RightLine_U_X, RightLine_U_Y, 0xFFFF);
-		draw_line(RightLine_U_X, RightLine_U_Y, UpLine_R_X, UpLine_R_Y, 0xFFFF);
-		
-	} else if(boardIndex == 2){
-		draw_line(UpLine_R_X + 90, UpLine_R_Y, UpLine_L_X + 90, UpLine_L_Y, 0xFFFF);
-		draw_line(UpLine_L_X + 90, UpLine_L_Y, LeftLine_U_X + 90, LeftLine_U_Y, 0xFFFF);
-		draw_line(LeftLine_U_X + 90, LeftLine_U_Y, LeftLine_B_X + 90, LeftLine_B_Y, 0xFFFF);
-		draw_line(LeftLine_B_X + 90, LeftLine_B_Y, BottomLine_L_X + 90, BottomLine_L_Y, 0xFFFF);
-		draw_line(BottomLine_L_X + 90, BottomLine_L_Y, BottomLine_R_X + 90, BottomLine_R_Y, 0xFFFF);
-		draw_line(BottomLine_R_X + 90, BottomLine_R_Y, RightLine_B_X + 90, RightLine_B_Y, 0xFFFF);
-		draw_line(RightLine_B_X + 90, RightLine_B_Y, RightLine_U_X + 90, RightLine_U_Y, 0xFFFF);
-		draw_line(RightLine_U_X + 90, RightLine_U_Y, UpLine_R_X + 90, UpLine_R_Y, 0xFFFF);
-		
-	} else if(boardIndex == 3){
-		draw_line(UpLine_R_X + 180, UpLine_R_Y, UpLine_L_X + 180, UpLine_L_Y, 0xFFFF);
-		draw_line(UpLine_L_X + 180, UpLine_L_Y, LeftLine_U_X + 180, LeftLine_U_Y, 0xFFFF);
-		draw_line(LeftLine_U_X + 180, LeftLine_U_Y, LeftLine_B_X + 180, LeftLine_B_Y, 0xFFFF);
-		draw_line(LeftLine_B_X + 180, LeftLine_B_Y, BottomLine_L_X + 180, BottomLine_L_Y, 0xFFFF);
-		draw_line(BottomLine_L_X + 180, BottomLine_L_Y, BottomLine_R_X + 180, BottomLine_R_Y, 0xFFFF);
-		draw_line(BottomLine_R_X + 180, BottomLine_R_Y, RightLine_B_X + 180, RightLine_B_Y, 0xFFFF);
-		draw_line(RightLine_B_X + 180, RightLine_B_Y, RightLine_U_X + 180, RightLine_U_Y, 0xFFFF);
-		draw_line(RightLine_U_X + 180, RightLine_U_Y, UpLine_R_X + 180, UpLine_R_Y, 0xFFFF);
-				
-	} else if(boardIndex == 4){
-		draw_line(UpLine_R_X, UpLine_R_Y + 63, UpLine_L_X, UpLine_L_Y + 63, 0xFFFF);
-		draw_line(UpLine_L_X, UpLine_L_Y + 63, LeftLine_U_X, LeftLine_U_Y + 63, 0xFFFF);
-		draw_line(LeftLine_U_X, LeftLine_U_Y + 63, LeftLine_B_X, LeftLine_B_Y + 63, 0xFFFF);
-		draw_line(LeftLine_B_X, LeftLine_B_Y + 63, BottomLine_L_X, BottomLine_L_Y + 63, 0xFFFF);
-		draw_line(BottomLine_L_X, BottomLine_L_Y + 63, BottomLine_R_X, BottomLine_R_Y + 63, 0xFFFF);
-		draw_line(BottomLine_R_X, BottomLine_R_Y + 63, RightLine_B_X, RightLine_B_Y + 63, 0xFFFF);
-		draw_line(RightLine_B_X, RightLine_B_Y + 63, RightLine_U_X, RightLine_U_Y + 63, 0xFFFF);
-		draw_line(RightLine_U_X, RightLine_U_Y + 63, UpLine_R_X, UpLine_R_Y + 63, 0xFFFF);
-
-	} else if(boardIndex == 5){
-		draw_line(UpLine_R_X + 90, UpLine_R_Y + 63, UpLine_L_X + 90, UpLine_L_Y + 63, 0xFFFF);
-		draw_line(UpLine_L_X + 90, UpLine_L_Y + 63, LeftLine_U_X + 90, LeftLine_U_Y + 63, 0xFFFF);
-		draw_line(LeftLine_U_X + 90, LeftLine_U_Y + 63, LeftLine_B_X + 90, LeftLine_B_Y + 63, 0xFFFF);
-		draw_line(LeftLine_B_X + 90, LeftLine_B_Y + 63, BottomLine_L_X + 90, BottomLine_L_Y + 63, 0xFFFF);
-		draw_line(BottomLine_L_X + 90, BottomLine_L_Y + 63, BottomLine_R_X + 90, BottomLine_R_Y + 63, 0xFFFF);
-		draw_line(BottomLine_R_X + 90, BottomLine_R_Y + 63, RightLine_B_X + 90, RightLine_B_Y + 63, 0xFFFF);
-		draw_line(RightLine_B_X + 90, RightLine_B_Y + 63, RightLine_U_X + 90, RightLine_U_Y + 63, 0xFFFF);
-		draw_line(RightLine_U_X + 90, RightLine_U_Y + 63, UpLine_R_X + 90, UpLine_R_Y + 63, 0xFFFF);
-	
-	} else if(boardIndex == 6){
-		draw_line(UpLine_R_X + 180, UpLine_R_Y + 63, UpLine_L_X + 180, UpLine_L_Y + 63, 0xFFFF);
-		draw_line(UpLine_L_X + 180, UpLine_L_Y + 63, LeftLine_U_X + 180, LeftLine_U_Y + 63, 0xFFFF);
-		draw_line(LeftLine_U_X + 180, LeftLine_U_Y + 63, LeftLine_B_X + 180, LeftLine_B_Y + 63, 0xFFFF);
-		draw_line(LeftLine_B_X + 180, LeftLine_B_Y + 63, BottomLine_L_X + 180, BottomLine_L_Y + 63, 0xFFFF);
-		draw_line(BottomLine_L_X + 180, BottomLine_L_Y + 63, BottomLine_R_X + 180, BottomLine_R_Y + 63, 0xFFFF);
-		draw_line(BottomLine_R_X + 180, BottomLine_R_Y + 63, RightLine_B_X + 180, RightLine_B_Y + 63, 0xFFFF);
-		draw_line(RightLine_B_X + 180, RightLine_B_Y + 63, RightLine_U_X + 180, RightLine_U_Y + 63, 0xFFFF);
-		draw_line(RightLine_U_X + 180, RightLine_U_Y + 63, UpLine_R_X + 180, UpLine_R_Y + 63, 0xFFFF);
-		
-	} else if(boardIndex == 7){
-		draw_line(UpLine_R_X, UpLine_R_Y + 126, UpLine_L_X, UpLine_L_Y + 126, 0xFFFF);
-		draw_line(UpLine_L_X, UpLine_L_Y + 126, LeftLine_U_X, LeftLine_U_Y + 126, 0xFFFF);
-		draw_line(LeftLine_U_X, LeftLine_U_Y + 126, LeftLine_B_X, LeftLine_B_Y + 126, 0xFFFF);
-		draw_line(LeftLine_B_X, LeftLine_B_Y + 126, BottomLine_L_X, BottomLine_L_Y + 126, 0xFFFF);
-		draw_line(BottomLine_L_X, BottomLine_L_Y + 126, BottomLine_R_X, BottomLine_R_Y + 126, 0xFFFF);
-		draw_line(BottomLine_R_X, BottomLine_R_Y + 126, RightLine_B_X, RightLine_B_Y + 126, 0xFFFF);
-		draw_line(RightLine_B_X, RightLine_B_Y + 126, RightLine_U_X, RightLine_U_Y + 126, 0xFFFF);
-		draw_line(RightLine_U_X, RightLine_U_Y + 126, UpLine_R_X, UpLine_R_Y + 126, 0xFFFF);
-		
-	} else if(boardIndex == 8){
-		draw_line(UpLine_R_X + 90, UpLine_R_Y + 126, UpLine_L_X + 90, UpLine_L_Y + 126, 0xFFFF);
-		draw_line(UpLine_L_X + 90, UpLine_L_Y + 126, LeftLine_U_X + 90, LeftLine_U_Y + 126, 0xFFFF);
-		draw_line(LeftLine_U_X + 90, LeftLine_U_Y + 126, LeftLine_B_X + 90, LeftLine_B_Y + 126, 0xFFFF);
-		draw_line(LeftLine_B_X + 90, LeftLine_B_Y + 126, BottomLine_L_X + 90, BottomLine_L_Y + 126, 0xFFFF);
-		draw_line(BottomLine_L_X + 90, BottomLine_L_Y + 126, BottomLine_R_X + 90, BottomLine_R_Y + 126, 0xFFFF);
-		draw_line(BottomLine_R_X + 90, BottomLine_R_Y + 126, RightLine_B_X + 90, RightLine_B_Y + 126, 0xFFFF);
-		draw_line(RightLine_B_X + 90, RightLine_B_Y + 126, RightLine_U_X + 90, RightLine_U_Y + 126, 0xFFFF);
-		draw_line(RightLine_U_X + 90, RightLine_U_Y + 126, UpLine_R_X + 90, UpLine_R_Y + 126, 0xFFFF);
-		
-	} else if(boardIndex == 9){
-		draw_line(UpLine_R_X + 180, UpLine_R_Y + 126, UpLine_L_X + 180, UpLine_L_Y + 126, 0xFFFF);
-		draw_line(UpLine_L_X + 180, UpLine_L_Y + 126, LeftLine_U_X + 180, LeftLine_U_Y + 126, 0xFFFF);
-		draw_line(LeftLine_U_X + 180, LeftLine_U_Y + 126, LeftLine_B_X + 180, LeftLine_B_Y + 126, 0xFFFF);
-		draw_line(LeftLine_B_X + 180, LeftLine_B_Y + 126, BottomLine_L_X + 180, BottomLine_L_Y + 126, 0xFFFF);
-		draw_line(BottomLine_L_X + 180, BottomLine_L_Y + 126, BottomLine_R_X + 180, BottomLine_R_Y + 126, 0xFFFF);
-		draw_line(BottomLine_R_X + 180, BottomLine_R_Y + 126, RightLine_B_X + 180, RightLine_B_Y + 126, 0xFFFF);
-		draw_line(RightLine_B_X + 180, RightLine_B_Y + 126, RightLine_U_X + 180, RightLine_U_Y + 126, 0xFFFF);
-		draw_line(RightLine_U_X + 180, RightLine_U_Y + 126, UpLine_R_X + 180, UpLine_R_Y + 126, 0xFFFF);
-	}
-}
-
-void initial_screen(){
-	int offset = 20, offset2 = 15;
-	
-	for (int x = 0; x < 320; x++){
-		for (int y = 0; y < 240; y++){
-			plot_pixel(x, y, 0x00FF);
-		}
-	}
-
-	// W
-	draw_line(80, 40, 85, 70, 0xFFFF);
-	draw_line(85, 70, 90, 55, 0xFFFF);
-	draw_line(90, 55, 95, 70, 0xFFFF);
-	draw_line(95, 70, 100, 40, 0xFFFF);
-	
-	// E
-	draw_line(103, 40, 103, 70, 0xFFFF);
-	draw_line(103, 40, 115, 40, 0xFFFF);
-	draw_line(103, 70, 115, 70, 0xFFFF);
-	draw_line(103, 55, 110, 55, 0xFFFF);
-	
-	// L 
-	draw_line(118, 40, 118, 70, 0xFFFF);
-	draw_line(118, 70, 130, 70, 0xFFFF);
-
-	// C
-	draw_line(133, 40, 133, 70, 0xFFFF);
-	draw_line(133, 40, 145, 40, 0xFFFF);
-	draw_line(133, 70, 145, 70, 0xFFFF);
-
-	// O
-	draw_line(148, 40, 160, 40, 0xFFFF);
-	draw_line(148, 70, 160, 70, 0xFFFF);
-	draw_line(148, 40, 148, 70, 0xFFFF);
-	draw_line(160, 40, 160, 70, 0xFFFF);
-	
-	// M
-	draw_line(163, 40, 163, 70, 0xFFFF);
-	draw_line(163, 40, 170, 50, 0xFFFF);
-	draw_line(170, 50, 177, 40, 0xFFFF);
-	draw_line(177, 40, 177, 70, 0xFFFF);
-
-	// E
-	draw_line(180, 40, 180, 70, 0xFFFF);
-	draw_line(180, 40, 192, 40, 0xFFFF);
-	draw_line(180, 70, 192, 70, 0xFFFF);
-	draw_line(180, 55, 187, 55, 0xFFFF);
-	
-	// T
-	draw_line(204, 40, 220, 40, 0xFFFF);
-	draw_line(212, 40, 212, 70, 0xFFFF);
-	
-	// O
-	draw_line(224, 40, 236, 40, 0xFFFF);
-	draw_line(224, 70, 236, 70, 0xFFFF);
-	draw_line(224, 40, 224, 70, 0xFFFF);
-	draw_line(236, 40, 236, 70, 0xFFFF);
-	
-	// T
-	draw_line(42 + offset, 90, 57 + offset, 90, 0xFFFF);
-	draw_line(50 + offset, 90, 50 + offset, 120, 0xFFFF);
-	
-	// I 
-	draw_line(60 + offset, 90, 74 + offset, 90, 0xFFFF);
-	draw_line(60 + offset, 120, 74 + offset, 120, 0xFFFF);
-	draw_line(67 + offset, 90, 67 + offset, 120, 0xFFFF);
-
-	// C
-	draw_line(77 + offset, 90, 77 + offset, 120, 0xFFFF);
-	draw_line(77 + offset, 90, 89 + offset, 90, 0xFFFF);
-	draw_line(77 + offset, 120, 89 + offset, 120, 0xFFFF);
-
-	// - 
-	draw_line(100 + offset, 105, 111 + offset, 105, 0xFFFF);
-	
-	// T
-	draw_line(117 + offset, 90, 131 + offset, 90, 0xFFFF);
-	draw_line(124 + offset, 90, 124 + offset, 120, 0xFFFF);
-	
-	// A
-	draw_line(134 + offset, 90, 146 + offset, 90, 0xFFFF);
-	draw_line(134 + offset, 105, 146 + offset, 105, 0xFFFF);
-	draw_line(134 + offset, 90, 134 + offset, 120, 0xFFFF);
-	draw_line(146 + offset, 90, 146 + offset, 120, 0xFFFF);
-	
-	// C
-	draw_line(149 + offset, 90, 149 + offset, 120, 0xFFFF);
-	draw_line(149 + offset, 90, 161 + offset, 90, 0xFFFF);
-	draw_line(149 + offset, 120, 161 + offset, 120, 0xFFFF);
-	
-	// - 
-	draw_line(166 + offset, 105, 177 + offset, 105, 0xFFFF);
-		
-	// T
-	draw_line(183 + offset, 90, 197 + offset, 90, 0xFFFF);
-	draw_line(190 + offset, 90, 190 + offset, 120, 0xFFFF);
-		
-	// O
-	draw_line(200 + offset, 90, 212 + offset, 90, 0xFFFF);
-	draw_line(200 + offset, 120, 212 + offset, 120, 0xFFFF);
-	draw_line(200 + offset, 90, 200 + offset, 120, 0xFFFF);
-	draw_line(212 + offset, 90, 212 + offset, 120, 0xFFFF);
-		
-	// E
-	draw_line(215 + offset, 90, 215 + offset, 120, 0xFFFF);
-	draw_line(215 + offset, 90, 227 + offset, 90, 0xFFFF);
-	draw_line(215 + offset, 120, 227 + offset, 120, 0xFFFF);
-	draw_line(215 + offset, 105, 221 + offset, 105, 0xFFFF);
-	
-	// P
-	draw_line(20 + offset2, 160, 35 + offset2, 160, 0xFFFF); 
-	draw_line(20 + offset2, 160, 20 + offset2, 190, 0xFFFF); 
-	draw_line(20 + offset2, 173, 35 + offset2, 173, 0xFFFF); 
-	draw_line(35 + offset2, 160, 35 + offset2, 173, 0xFFFF); 
-	
-	// R
-	draw_line(38 + offset2, 160, 53 + offset2, 160, 0xFFFF); 
-	draw_line(38 + offset2, 160, 38 + offset2, 190, 0xFFFF); 
-	draw_line(38 + offset2, 173, 53 + offset2, 173, 0xFFFF); 
-	draw_line(53 + offset2, 160, 53 + offset2, 173, 0xFFFF); 
-	draw_line(38 + offset2, 173, 53 + offset2, 190, 0xFFFF); 
-	
-	// E
-	draw_line(56 + offset2, 160, 56 + offset2, 190, 0xFFFF);
-	draw_line(56 + offset2, 160, 68 + offset2, 160, 0xFFFF);
-	draw_line(56 + offset2, 190, 68 + offset2, 190, 0xFFFF);
-	draw_line(56 + offset2, 175, 62 + offset2, 175, 0xFFFF);
-	
-	// S
-	draw_line(71 + offset2, 160, 83 + offset2, 160, 0xFFFF);
-	draw_line(71 + offset2, 190, 83 + offset2, 190, 0xFFFF);
-	draw_line(71 + offset2, 160, 71 + offset2, 175, 0xFFFF);
-	draw_line(71 + offset2, 175, 83 + offset2, 175, 0xFFFF);
-	draw_line(83 + offset2, 175, 83 + offset2, 190, 0xFFFF);
-	
-	// S
-	draw_line(86 + offset2, 160, 98 + offset2, 160, 0xFFFF);
-	draw_line(86 + offset2, 190, 98 + offset2, 190, 0xFFFF);
-	draw_line(86 + offset2, 160, 86 + offset2, 175, 0xFFFF);
-	draw_line(86 + offset2, 175, 98 + offset2, 175, 0xFFFF);
-	draw_line(98 + offset2, 175, 98 + offset2, 190, 0xFFFF);
-	
-	// [X]
-	draw_line(111 + offset2, 158, 120 + offset2, 158, 0xFFFF); 
-	draw_line(111 + offset2, 158, 111 + offset2, 192, 0xFFFF);
-	draw_line(111 + offset2, 192, 120 + offset2, 192, 0xFFFF); 
-	
-	draw_line(123 + offset2, 163, 135 + offset2, 187, 0xFFFF);
-	draw_line(135 + offset2, 163, 123 + offset2, 187, 0xFFFF);
-	
-	draw_line(138 + offset2, 158, 147 + offset2, 158, 0xFFFF);
-	draw_line(138 + offset2, 192, 147 + offset2, 192, 0xFFFF);
-	draw_line(147 + offset2, 158, 147 + offset2, 192, 0xFFFF);
-
-	// T
-	draw_line(157 + offset2, 160, 172 + offset2, 160, 0xFFFF);
-	draw_line(164 + offset2, 160, 164 + offset2, 190, 0xFFFF);
-	
-	// O 
-	draw_line(175 + offset2, 160, 187 + offset2, 160, 0xFFFF);
-	draw_line(175 + offset2, 190, 187 + offset2, 190, 0xFFFF);
-	draw_line(175 + offset2, 160, 175 + offset2, 190, 0xFFFF);
-	draw_line(187 + offset2, 160, 187 + offset2, 190, 0xFFFF);
-	
-	// P
-	draw_line(200 + offset2, 160, 215 + offset2, 160, 0xFFFF); 
-	draw_line(200 + offset2, 160, 200 + offset2, 190, 0xFFFF); 
-	draw_line(200 + offset2, 173, 215 + offset2, 173, 0xFFFF); 
-	draw_line(215 + offset2, 160, 215 + offset2, 173, 0xFFFF); 
-	
-	// L
-	draw_line(218 + offset2, 160, 218 + offset2, 190, 0xFFFF);
-	draw_line(218 + offset2, 190, 230 + offset2, 190, 0xFFFF);
-	
-	// A
-	draw_line(233 + offset2, 160, 245 + offset2, 160, 0xFFFF);
-	draw_line(233 + offset2, 175, 245 + offset2, 175, 0xFFFF);
-	draw_line(233 + offset2, 160, 233 + offset2, 190, 0xFFFF);
-	draw_line(245 + offset2, 160, 245 + offset2, 190, 0xFFFF);
-	
-	// Y 
-	draw_line(248 + offset2, 160, 255 + offset2, 175, 0xFFFF);
-	draw_line(261 + offset2, 160, 255 + offset2, 175, 0xFFFF);
-	draw_line(255 + offset2, 175, 255 + offset2, 190, 0xFFFF);
-	
-	char developers[150] = "By Bikramjit Narwal & Nurin Fazil\0";
-	write_text(25, 53, developers);
-}
-
-// Functions checks every possibly win (3 in a row) for either player and returns the winner
-int check_winner(){
-	// First Column Win
-    if(1 == board[0] && 1 == board[3] && 1 == board[6]){
-		draw_line(69, 25, 69, 214, 0xF800);
-		draw_line(70, 25, 70, 214, 0xF800);
-		draw_line(71, 25, 71, 214, 0xF800);
-        return 1;
-    }
-
-    if(2 == board[0] && 2 == board[3] && 2 == board[6]){
-		draw_line(69, 25, 69, 214, 0xF800);
-		draw_line(70, 25, 70, 214, 0xF800);
-		draw_line(71, 25, 71, 214, 0xF800);
-        return 2;
-    }
-	
-	// Second Column Win 
-    if(1 == board[1] && 1 == board[4] && 1 == board[7]){
-		draw_line(159, 25, 159, 214, 0xF800);
-		draw_line(160, 25, 160, 214, 0xF800);
-		draw_line(161, 25, 161, 214, 0xF800);
-        return 1;
-    }
-
-    if(2 == board[1] && 2 == board[4] && 2 == board[7]){
-		draw_line(159, 25, 159, 214, 0xF800);
-		draw_line(160, 25, 160, 214, 0xF800);
-		draw_line(161, 25, 161, 214, 0xF800);
-        return 2;
-    }
-	
-	// Third column win 
-	if(1 == board[2] && 1 == board[5] && 1 == board[8]){
-		draw_line(249, 25, 249, 214, 0xF800);
-		draw_line(250, 25, 250, 214, 0xF800);
-		draw_line(251, 25, 251, 214, 0xF800);
-        return 1;
-    }
-
-    if(2 == board[2] && 2 == board[5] && 2 == board[8]){
-		draw_line(249, 25, 249, 214, 0xF800);
-		draw_line(250, 25, 250, 214, 0xF800);
-		draw_line(251, 25, 251, 214, 0xF800);        
-		return 2;
-    }
-	
-	// First row Win
-    if(1 == board[0] && 1 == board[1] && 1 == board[2]){
-		draw_line(25, 55, 295, 55, 0xF800);
-		draw_line(25, 56, 295, 56, 0xF800);
-		draw_line(25, 57, 295, 57, 0xF800);
-        return 1;
-    }
-
-    if(2 == board[0] && 2 == board[1] && 2 == board[2]){
-		draw_line(25, 55, 295, 55, 0xF800);
-		draw_line(25, 56, 295, 56, 0xF800);
-		draw_line(25, 57, 295, 57, 0xF800);
-        return 2;
-    }
-	
-	// Second row Win 
-    if(1 == board[3] && 1 == board[4] && 1 == board[5]){
-		draw_line(25, 118, 295, 118, 0xF800);
-		draw_line(25, 119, 295, 119, 0xF800);
-		draw_line(25, 120, 295, 120, 0xF800);
-        return 1;
-    }
-
-    if(2 == board[3] && 2 == board[4] && 2 == board[5]){
-		draw_line(25, 118, 295, 118, 0xF800);
-		draw_line(25, 119, 295, 119, 0xF800);
-		draw_line(25, 120, 295, 120, 0xF800);
-        return 2;
-    }
-	
-	// Third row win 
-	if(1 == board[6] && 1 == board[7] && 1 == board[8]){
-		draw_line(25, 181, 295, 181, 0xF800);
-		draw_line(25, 182, 295, 182, 0xF800);
-		draw_line(25, 183, 295, 183, 0xF800);
-        return 1;
-    }
-
-    if(2 == board[6] && 2 == board[7] && 2 == board[8]){
-		draw_line(25, 181, 295, 181, 0xF800);
-		draw_line(25, 182, 295, 182, 0xF800);
-		draw_line(25, 183, 295, 183, 0xF800);
-        return 2;
-    }
-	
-	// Left diagonal win
-    if(1 == board[0] && 1 == board[4] && 1 == board[8]){
-		draw_line(24, 24, 294, 213, 0xF800);
-		draw_line(25, 25, 295, 214, 0xF800);
-		draw_line(26, 26, 296, 215, 0xF800);
-        return 1;
-    }
-
-    if(2 == board[0] && 2 == board[4] && 2 == board[8]){
-		draw_line(24, 24, 294, 213, 0xF800);
-		draw_line(25, 25, 295, 214, 0xF800);
-		draw_line(26, 26, 296, 215, 0xF800);
-        return 2;
-    }
-    
-	// Right diagonal win
-    if(1 == board[2] && 1 == board[4] && 1 == board[6]){
-		draw_line(294, 24, 24, 213, 0xF800);
-		draw_line(295, 25, 25, 214, 0xF800);
-		draw_line(296, 26, 26, 215, 0xF800);
-        return 1;
-    }
-    
-    if (2 == board[2] && 2 == board[4] && 2 == board[6]){
-		draw_line(294, 24, 24, 213, 0xF800);
-		draw_line(295, 25, 25, 214, 0xF800);
-		draw_line(296, 26, 26, 215, 0xF800);
-        return 2;
-    }
-	
-	checkforStalemate();
-	if (isStalemate){
-		return 3;
-	}
-	
-	return 0;
-}
-
-// Checks if every position has been filled
-void checkforStalemate(){
-    for(int index = 0; index < 9; index++){
-        // 0 means no one has claimed that position
-        if(board[index] == 0){
-            isStalemate = false;
-			return;
-        }
-    }
-	isStalemate = true;
-}
-
-void AI_move(){	
-	// AI can only move if there is a possible spot on the board to move 
-	if(isStalemate == false){
-		srand(time(0));
-		int AI_Index = rand() % 9; // generate number from 0 to 8
-		
-		while(board[AI_Index] != 0){ // If box is full, find another box that is empty
-			AI_Index = rand() % 9;
-		}
-		
-		if(AI_Index == 0){
-			draw_selection_box(selection_x, selection_y, 0x0000);
-			draw_board();
-			
-			selection_x = 25;
-			selection_y = 25;
-			
-			draw_selection_box(selection_x, selection_y, 0xF800);
-
-		} else if(AI_Index == 1){
-			draw_selection_box(selection_x, selection_y, 0x0000);
-			draw_board();
-			
-			selection_x = 115;
-			selection_y = 25;
-			
-			draw_selection_box(selection_x, selection_y, 0xF800);
-
-		} else if(AI_Index == 2){
-			draw_selection_box(selection_x, selection_y, 0x0000);
-			draw_board();
-			
-			selection_x = 205;
-			selection_y = 25;
-			
-			draw_selection_box(selection_x, selection_y, 0xF800);
-			
-		} else if(AI_Index == 3){
-			draw_selection_box(selection_x, selection_y, 0x0000);
-			draw_board();
-			
-			selection_x = 25;
-			selection_y = 88;
-			
-			draw_selection_box(selection_x, selection_y, 0xF800);
-			
-		} else if(AI_Index == 4){
-			draw_selection_box(selection_x, selection_y, 0x0000);
-			draw_board();
-			
-			selection_x = 115;
-			selection_y = 88;
-			
-			draw_selection_box(selection_x, selection_y, 0xF800);
-			
-		} else if(AI_Index == 5){
-			draw_selection_box(selection_x, selection_y, 0x0000);
-			draw_board();
-			
-			selection_x = 205;
-			selection_y = 88;
-			
-			draw_selection_box(selection_x, selection_y, 0xF800);
-
-		} else if(AI_Index == 6){
-			draw_selection_box(selection_x, selection_y, 0x0000);
-			draw_board();
-			
-			selection_x = 25;
-			selection_y = 151;
-			
-			draw_selection_box(selection_x, selection_y, 0xF800);
-			
-		} else if(AI_Index == 7){
-			draw_selection_box(selection_x, selection_y, 0x0000);
-			draw_board();
-			
-			selection_x = 115;
-			selection_y = 151;
-			
-			draw_selection_box(selection_x, selection_y, 0xF800);
-		}
-		
-		if (Turn == 'X'){
-			board[AI_Index] = 1;
-			draw_player_X(AI_Index + 1);
-		} else {
-			board[AI_Index] = 2;
-			draw_player_O(AI_Index + 1);
-		}
-	}
-}
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Build with -DHOST_BUILD to compile the game logic on a desktop machine (see
+// tools/). The hardware set-up, interrupt handlers and main are left out.
+#ifdef HOST_BUILD
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+// Search state is per thread so host tools can search several boards at once
+#define THREAD_LOCAL __thread
+#else
+#define THREAD_LOCAL
+#endif
+
+// Search engine limits. Boards up to 15x15 are supported by the engine, the
+// game itself plays on 3x3.
+#define MAX_ROWS 15
+#define MAX_COLS 15
+#define MAX_CELLS (MAX_ROWS * MAX_COLS)
+#define MAX_K 8
+#define MAX_LINES (4 * MAX_CELLS) // every cell starts at most one line per direction
+#define MAX_CELL_LINES (4 * MAX_K) // lines through one cell
+#ifdef HOST_BUILD
+#define MAX_SHAPES 16 // board sizes in use at once, each with its own line tables
+#else
+#define MAX_SHAPES 4
+#endif
+#define MAX_DEPTH 32
+#define WIN_SCORE 100000000
+#define INFINITY_SCORE 1000000000
+#define ASPIRATION_WINDOW 50
+
+// Line weights fitted by tools/tune_weights, for example
+// -DTUNED_WEIGHTS_HEADER='"tuned_weights.h"'. It defines TUNED_K and
+// TUNED_LINE_WEIGHTS, the weights of lines holding 0 to TUNED_K - 1 stones.
+#ifdef TUNED_WEIGHTS_HEADER
+#include TUNED_WEIGHTS_HEADER
+#endif
+
+// Splash screen converted by tools/png2rle, for example
+// -DSPLASH_HEADER='"splash.h"'. It defines SPLASH_WIDTH, SPLASH_HEIGHT and
+// splash_rle, pairs of run length and RGB565 colour that never cross the end
+// of a row. Without it the welcome screen is drawn from lines.
+#ifdef SPLASH_HEADER
+#include SPLASH_HEADER
+#endif
+
+// The A9 private timer counts down at 200 MHz
+#define TIMER_HZ 200000000
+// Time the AI is given to answer a [C] request, one 60 Hz frame
+#define AI_BUDGET_TICKS (TIMER_HZ / 60)
+
+// The game's board and the screen it is drawn on
+#define GAME_ROWS 3
+#define GAME_COLS 3
+#define GAME_K 3
+#define GAME_CELLS (GAME_ROWS * GAME_COLS)
+#define SCREEN_WIDTH 320 // used when the pixel controller can't be read
+#define SCREEN_HEIGHT 240
+#define MAX_SCREEN_WIDTH 640
+#define MAX_SCREEN_HEIGHT 480
+#define TEXT_COLUMNS 80 // the character buffer is 80x60 at every resolution
+#define TEXT_ROWS 60
+#define BOARD_MARGIN 25 // pixels between the screen edge and the board
+#define FONT_FIRST 32 // ' ', the first character in the font
+#define FONT_GLYPHS 95 // ' ' to '~'
+#define FONT_SIZE 8 // glyphs are 8x8 pixels before scaling
+#define BANNER_SCALE 2 // the result banner's glyph pixels, small enough for BOARD_MARGIN
+#define MAX_TEXT_CHARS 80
+#define MAX_TEXT_WORDS (MAX_SCREEN_WIDTH / 32) // 32 pixel words in a laid out row
+#define TEXT_CACHE_SIZE 16 // laid out strings kept, a power of two
+
+// Pixel format the drawing code is compiled for, 16 (RGB565) or 8 (RGB332).
+// Colours are always given as RGB565 and converted at compile time.
+#ifndef PIXEL_BITS
+#define PIXEL_BITS 16
+#endif
+#if PIXEL_BITS == 8
+typedef unsigned char pixel_value;
+#define PIXEL_COLOUR(c) ((((c) >> 8) & 0xE0) | (((c) >> 6) & 0x1C) | (((c) >> 3) & 0x03))
+#else
+typedef unsigned short pixel_value;
+#define PIXEL_COLOUR(c) ((pixel_value) (c))
+#endif
+
+// Largest board layout_init lays out
+#define MAX_LAYOUT_ROWS 9
+#define MAX_LAYOUT_COLS 9
+#define MAX_LAYOUT_CELLS (MAX_LAYOUT_ROWS * MAX_LAYOUT_COLS)
+#define MAX_LAYOUT_LINES (4 * MAX_LAYOUT_CELLS)
+
+// Directions the selection box moves in, indexes of board_layout.neighbour
+#define MOVE_UP 0
+#define MOVE_DOWN 1
+#define MOVE_LEFT 2
+#define MOVE_RIGHT 3
+
+// Strategies the [C] move can use
+#define AI_STRATEGY_SEARCH 0 // iterative deepening alpha-beta
+#define AI_STRATEGY_PROOF 1 // proof-number solver, falls back to search
+
+// Proof-number solver limits. The transposition table is the solver's only
+// memory so its size is the memory cap. The host build solves with threads.
+#define PNS_INFINITY 0x3FFFFFFF
+#define PNS_MAX_PLY 64
+#ifndef PNS_TABLE_SIZE
+#ifdef HOST_BUILD
+#define PNS_TABLE_SIZE (1 << 20) // 24 MB
+#else
+#define PNS_TABLE_SIZE (1 << 16) // 1.5 MB of DDR
+#endif
+#endif
+#ifndef PNS_THREADS
+#ifdef HOST_BUILD
+#define PNS_THREADS 4
+#else
+#define PNS_THREADS 1
+#endif
+#endif
+
+// Every game is appended to a log, buffered in GAME_LOG_BUFFER_SIZE bytes.
+// The host build writes a file, the board a region of SDRAM.
+#define GAME_LOG_BUFFER_SIZE 512
+#ifdef HOST_BUILD
+#ifndef GAME_LOG_PATH
+#define GAME_LOG_PATH "games.log"
+#endif
+#else
+#define GAME_LOG_BASE 0xC1000000
+#define GAME_LOG_SIZE 0x01000000 // 16 MB
+#endif
+
+// Snapshots of the game and help screens. On the board they live in SDRAM
+// after the game log, two of them at the largest resolution.
+#define CHARACTER_BUFFER_BYTES (60 * 128)
+#ifndef HOST_BUILD
+#define SCREEN_CACHE_BASE 0xC2000000
+#define SCREEN_CACHE_SLOT (MAX_SCREEN_HEIGHT * 1024 * sizeof(pixel_value) + CHARACTER_BUFFER_BYTES)
+#endif
+
+// Sound effects. Clips are generated at AUDIO_RATE (CPUlator's audio device
+// plays 8 kHz, the board's codec can be set to 48 kHz), mixed up to
+// AUDIO_LEAD samples ahead onto a ring and moved into the audio core's write
+// FIFO by its interrupt, which fires once the FIFO is three quarters empty.
+#ifndef AUDIO_RATE
+#define AUDIO_RATE 8000
+#endif
+#define AUDIO_BASE 0xFF203040
+#define AUDIO_IRQ 78
+#define AUDIO_FIFO_SIZE 128
+#define AUDIO_RING_SIZE 1024 // samples, a power of two
+#define AUDIO_LEAD 512 // samples mixed ahead, bounds the delay before a sound starts
+#define AUDIO_MIX_CHUNK 64
+#define AUDIO_VOICES 4
+#define AUDIO_CLIP_SAMPLES AUDIO_RATE // a second, room for every clip
+#define AUDIO_CLICK 0 // a move
+#define AUDIO_WIN 1
+#define AUDIO_TIE 2
+#define AUDIO_CLIPS 3
+
+// Interrupt registry. GIC priorities are 0 (highest) to 248 in steps of 8;
+// a handler registered as nested can be preempted by sources of a higher
+// priority than its own.
+#define MAX_IRQ_SOURCES 8
+#define MAX_IRQ_ID 256
+#define IRQ_PRIORITY_AUDIO 0x40 // short and must not be held up
+#define IRQ_PRIORITY_KEYBOARD 0xA0 // runs the AI, so it is nested
+#define IRQ_REPORT_ROW 48 // first character row of the report on the help screen
+
+// Stack checking. The IRQ stack is the top IRQ_STACK_SIZE bytes of the A9's
+// 64 KB on-chip memory; the SVC stack, which main, the AI and the nested
+// handlers run on, is checked for SVC_STACK_SIZE bytes below main. Both are
+// painted at boot: the deepest either has been is the lowest word no longer
+// holding STACK_PAINT, and a changed word in the guard at the bottom means it
+// overflowed. tools/stack_report gives the worst case from the compiler's
+// frame sizes.
+#ifndef IRQ_STACK_SIZE
+#define IRQ_STACK_SIZE 4096 // bytes
+#endif
+#ifndef SVC_STACK_SIZE
+#define SVC_STACK_SIZE 0x10000
+#endif
+#if IRQ_STACK_SIZE % 8 != 0 || IRQ_STACK_SIZE > 0x10000
+#error IRQ_STACK_SIZE must be a multiple of 8 that fits in on-chip memory
+#endif
+#define IRQ_STACK_TOP 0xFFFFFFF8 // top of A9 on-chip memory, aligned to 8 bytes
+#define STACK_PAINT 0xDEADBEEF
+#define STACK_GUARD_WORDS 8
+#define STACK_PAINT_MARGIN 64 // words left alone below the painting function
+
+// Performance HUD. [F] cycles it between off, the HEX displays and the HEX
+// displays plus a corner of the character buffer. Handlers only store their
+// times; hud_poll, in the main loop, puts them on the displays once a frame.
+// LEDR lights for each kind of deadline missed since the HUD was turned on.
+#define HEX3_HEX0_BASE 0xFF200020
+#define HEX5_HEX4_BASE 0xFF200030
+#define LEDR_BASE 0xFF200000
+#define HUD_FRAME_TICKS (TIMER_HZ / 60)
+#define HUD_ROTATE_FRAMES 90 // the HEX displays show each value for 1.5 s
+#define HUD_TEXT_COL 62
+#define HUD_TEXT_ROW 0
+#define HUD_OFF 0
+#define HUD_HEX 1
+#define HUD_HEX_TEXT 2
+#define HUD_MODES 3
+#define HUD_LATE_FRAME 0x1 // LEDR0: a key took more than a frame to handle and draw
+#define HUD_LATE_AUDIO 0x2 // LEDR1: the audio ring ran dry during a clip
+#define HUD_LATE_POLL 0x4 // LEDR2: the main loop was kept out for over two frames
+
+// Analysis overlay. [E] writes the engine's value of playing each empty cell
+// in the cell's label position. Positions searched are kept in a table, so
+// after a move the new values mostly come from grandchildren already in it.
+// Values are exact where the search reaches the end of the game, always on
+// 3x3. An update out of time shows ? and carries on from the table next key.
+#define ANALYSIS_TABLE_SIZE 8192 // entries, a power of two
+#define ANALYSIS_DEPTH 8 // plies below each cell
+#define ANALYSIS_BUDGET_TICKS AI_BUDGET_TICKS
+#define ANALYSIS_EXACT 0
+#define ANALYSIS_LOWER 1 // value is at least this
+#define ANALYSIS_UPPER 2 // value is at most this
+
+// Exhibition mode. [G] puts EXHIBITION_BOARDS games on screen at once, the
+// engine playing O on every one against a challenger making random moves.
+// Every frame the main loop lets the challengers move, answers all the boards
+// waiting on the engine as one batch and then draws what changed on every
+// board in one pass.
+#define MAX_EXHIBITION_BOARDS 16
+#define EXHIBITION_BOARDS 9
+#define EXHIBITION_MARGIN 4 // pixels around each board
+#define EXHIBITION_FRAME_TICKS (TIMER_HZ / 60)
+#define EXHIBITION_AI_TICKS (EXHIBITION_FRAME_TICKS / 2) // the engine's share of a frame
+#define EXHIBITION_THINK_FRAMES 20 // challenger's pause before each move
+#define EXHIBITION_RESTART_FRAMES 90 // a finished game stays up this long
+#define EXHIBITION_REPORT_FRAMES 60 // frames per line of the frame time report
+#define EXHIBITION_REPORT_ROW 59
+#if GAME_CELLS > 32
+#error exhibition boards keep a dirty bit per cell in a word
+#endif
+
+// Ultimate tic-tac-toe, [V]: nine 3x3 boards in a 3x3 meta-board. The cell
+// a move is played in sends the opponent to the board in the same position,
+// or anywhere open if that board is already won or full. The engine plays O
+// with a Monte Carlo tree search of random playouts.
+#define ULTIMATE_CELLS 81 // board * 9 + cell
+#define ULTIMATE_TREE_SIZE 32768 // search tree nodes
+#define ULTIMATE_EXPLORATION 0.8f // UCT exploration constant, for log2 rather than ln
+#define ULTIMATE_STATUS_ROW 55
+
+// Qubic, [Q]: four in a row on a 4x4x4 cube, against the engine. Each side's
+// stones are one 64-bit word and each of the 76 lines a mask.
+#define QUBIC_CELLS 64 // layer * 16 + row * 4 + col
+#define QUBIC_LINES 76
+#define QUBIC_MAX_LINES_PER_CELL 7 // corners and the eight centre cells
+#define QUBIC_MAX_DEPTH 24
+#define QUBIC_WIN_SCORE 1000000
+#define QUBIC_LAYER_GAP 8 // pixels between the layers on screen
+
+// Command console on the JTAG UART. Lines received are run as commands by
+// its interrupt handler, nested at the keyboard's priority so the two never
+// run at once; output waits in a ring that the write interrupt drains.
+#define JTAG_UART_BASE 0xFF201000
+#define JTAG_UART_IRQ 80
+#define CONSOLE_RX_SIZE 256 // bytes, a power of two
+#define CONSOLE_TX_SIZE 4096
+#define CONSOLE_LINE 80
+
+// Book moves need at least this many games through the resulting position
+#define BOOK_MIN_GAMES 4
+
+// Endgame database values, for the side to move, stored in 2 bits each
+#define MAX_DB_CELLS 25
+#define ENDGAME_UNKNOWN 0 // also positions that can't be reached
+#define ENDGAME_LOSS 1
+#define ENDGAME_DRAW 2
+#define ENDGAME_WIN 3
+
+// Functions related to keyboard interrupts set-up
+void disable_A9_interrupts(void);
+void set_A9_IRQ_stack(void);
+void config_GIC(void);
+void config_KEYs(void);
+void enable_A9_interrupts(void);
+void keyboard_ISR(void);
+void keyboard_byte(unsigned char byte);
+void handle_key(unsigned char byte0);
+void config_interrupt(int, int, int, bool);
+
+// Functions for drawing objects onto the screen
+void draw_player(int boardIndex);
+void draw_player_X(int boardIndex);
+void draw_player_O(int boardIndex);
+void initial_screen();
+void draw_welcome_art(void);
+void draw_rle_image(const unsigned short *runs, int width, int height, int x, int y);
+void plot_pixel(int x, int y, short int line_color);
+void draw_line(int x0, int y0, int x1, int y1, short int line_color);
+void draw_selection_box(int cell, short int selection_colour);
+void swap(int *first, int *second);
+void draw_board(void);
+void draw_thick_segment(int x0, int y0, int x1, int y1, short int line_color);
+void write_text(int x, int y, char * text_ptr);
+void clear_screen();
+void fill_rect(int x, int y, int width, int height, short int colour);
+
+void draw_text(int x, int y, const char *text, int scale, short int colour);
+int text_width(const char *text, int scale);
+void draw_result_banner(int winner);
+
+// Functions for sound effects
+void audio_init(void);
+void audio_play(int clip);
+void audio_pump(void);
+void audio_mix(int count);
+int audio_drain(short *samples, int space);
+bool audio_playing(void);
+#ifdef HOST_BUILD
+bool audio_wav_open(const char *path);
+void audio_host_tick(int space);
+void audio_wav_close(void);
+#else
+void audio_ISR(void);
+#endif
+
+// Functions for the interrupt registry
+bool irq_register(int id, void (*handler)(void), int priority, bool edge, bool nested, const char *name);
+unsigned int irq_latency_bound(int slot);
+int irq_report(int row);
+
+// Functions for the performance HUD
+void hud_init(void);
+void hud_toggle(void);
+void hud_poll(void);
+void hud_key_done(unsigned int start);
+void hud_search_done(void);
+
+// Functions for exhibition mode
+void exhibition_start(int boards);
+void exhibition_stop(void);
+void exhibition_poll(void);
+void exhibition_frame(void);
+
+// Functions for the command console
+void console_init(void);
+void console_receive(char c);
+void console_poll(void);
+void console_command(char *line);
+void console_write(const char *text);
+void console_printf(const char *format, ...);
+void console_flush(void);
+#ifndef HOST_BUILD
+void console_ISR(void);
+#endif
+
+// Functions for switching between the game and help screens
+void snapshot_init(void);
+void game_view_changed(void);
+void draw_help_screen(void);
+void draw_game_view(void);
+void show_help(void);
+void hide_help(void);
+
+// Functions which handle the tic-tac-toe logic
+int check_winner();
+int winning_line(void);
+void finish_move(int cell);
+void undo_move(void);
+void redo_move(void);
+void clear_text ();
+void checkforStalemate();
+void AI_move();
+
+// The pixel buffer drawn to: where it is, its size and the distance between
+// rows, which is more than width pixels when the controller uses x-y addressing
+typedef struct {
+	char *base;
+	int width, height;
+	int pitch; // bytes
+	int bpp; // bytes per pixel
+	int char_width, char_height; // pixels under one character buffer cell
+} surface;
+
+// A copy of the pixel and character buffers, so a screen can be put back
+// with one copy of each instead of being drawn again
+typedef struct {
+	char *pixels;
+	char *text;
+	bool valid;
+} screen_snapshot;
+
+// Time taken to switch between screens, in timer ticks
+typedef struct {
+	unsigned int count;
+	unsigned int last_ticks, max_ticks;
+	unsigned long long total_ticks;
+} toggle_stats;
+
+// A string laid out for draw_text: a bit for every pixel of each glyph row,
+// already widened by the scale, 32 pixels to a word
+typedef struct {
+	char text[MAX_TEXT_CHARS + 1];
+	int scale; // 0 while the cache slot is empty
+	int width; // pixels
+	unsigned int bits[FONT_SIZE][MAX_TEXT_WORDS];
+} text_layout;
+
+// A clip being mixed
+typedef struct {
+	const short *samples; // NULL when the voice is free
+	int length;
+	int position;
+} audio_voice;
+
+// Counts kept by the audio interrupt and the mixer
+typedef struct {
+	unsigned int interrupts;
+	unsigned int samples; // moved off the ring
+	unsigned int ring_underruns; // interrupts that found the ring short while a clip was playing
+	unsigned int missing_samples; // how short it was
+	unsigned int fifo_underruns; // interrupts that found the write FIFO already empty
+	unsigned int mixed; // samples mixed
+	unsigned int mix_ticks; // time spent mixing
+} audio_counters;
+
+// An interrupt source: how the GIC is set up for it, its handler and what it
+// has cost so far. Times are in A9 private timer ticks.
+typedef struct {
+	int id; // GIC interrupt ID
+	void (*handler)(void);
+	int priority;
+	bool edge; // edge triggered, otherwise level sensitive
+	bool nested; // the handler runs with interrupts enabled
+	const char *name;
+	unsigned int count;
+	unsigned int max_dispatch; // from the IRQ exception to the handler starting
+	unsigned int max_ticks; // longest run, counting anything that preempted it
+} irq_source;
+
+// Console traffic
+typedef struct {
+	unsigned int rx_bytes;
+	unsigned int rx_dropped; // the receive ring was full
+	unsigned int lines;
+	unsigned int tx_bytes;
+	unsigned int tx_dropped; // the transmit ring was full
+} console_counters;
+
+// A drawing routine the console's bench command can time
+typedef struct {
+	const char *name;
+	void (*run)(void);
+} console_bench;
+
+// What the HUD shows, stored by the handlers as it happens. Times are in
+// timer ticks.
+typedef struct {
+	unsigned int isr_ticks; // longest handler run since the last poll
+	unsigned int frame_ticks; // last key, from its scancode to the screen drawn
+	unsigned int ai_nodes, ai_ticks; // last search
+	unsigned int late; // HUD_LATE_ bits of the deadlines missed
+	unsigned int late_count;
+} hud_counters;
+
+// Analysis table entry: a position's value for the side to move, searched
+// depth plies deep. Wins and losses count plies from the position itself.
+typedef struct {
+	unsigned long long key; // hash of the stones and side to move
+	int value;
+	unsigned char depth;
+	unsigned char bound; // ANALYSIS_EXACT, ANALYSIS_LOWER or ANALYSIS_UPPER
+} analysis_entry;
+
+// Work done by the analysis overlay
+typedef struct {
+	unsigned int updates;
+	unsigned int nodes;
+	unsigned int table_hits;
+	unsigned int repaints; // labels written because their text changed
+	unsigned int aborted; // updates that ran out of time
+	unsigned int last_ticks;
+} analysis_counters;
+
+// A painted stack: words from bottom up to end were filled with STACK_PAINT,
+// the ones from end to top were in use at the time
+typedef struct {
+	const char *name;
+	unsigned int *bottom, *end, *top; // top is one past the highest word
+	unsigned int overflows;
+	const char *overflow_by; // handler that had just run when the last one was seen
+} stack_region;
+
+// A straight line on the screen
+typedef struct {
+	short x0, y0, x1, y1;
+} segment;
+
+// Screen geometry of a board, generated by layout_init for any board size
+// and screen rectangle so drawing and cursor movement are table lookups
+typedef struct {
+	int rows, cols, k;
+	int cells;
+	int left, top; // top left corner of the board
+	int cell_width, cell_height;
+	short cell_x[MAX_LAYOUT_CELLS], cell_y[MAX_LAYOUT_CELLS]; // top left of every cell
+	unsigned char neighbour[MAX_LAYOUT_CELLS][4]; // cell in each MOVE_ direction, wrapping around
+	unsigned char label_x[MAX_LAYOUT_CELLS], label_y[MAX_LAYOUT_CELLS]; // character position of cell numbers
+	char label[MAX_LAYOUT_CELLS][4];
+	int grid_total;
+	segment grid[MAX_LAYOUT_ROWS + MAX_LAYOUT_COLS]; // centres of the 3 pixel wide grid strokes
+	segment x_mark[2]; // relative to the cell's top left
+	segment o_mark[8];
+	int line_total;
+	unsigned char line_cell[MAX_LAYOUT_LINES][MAX_K]; // cells of every k in a row
+	segment win_line[MAX_LAYOUT_LINES]; // stroke drawn over a completed line
+} board_layout;
+
+// Line geometry of one board size, built the first time engine_init is asked
+// for it and then shared by every board of that size
+typedef struct {
+	int rows, cols, k;
+	int line_total;
+	short line_cells[MAX_LINES][MAX_K]; // cells of every k long line
+	short cell_lines[MAX_CELLS][MAX_CELL_LINES]; // lines through every cell
+	unsigned char cell_line_total[MAX_CELLS];
+	int line_weight[MAX_K + 1]; // value of a line holding c stones of one player only
+} mnk_shape;
+
+// An m,n,k board used by the search engine and the game. The line counts,
+// neighbour counts and score are kept up to date by engine_play/engine_undo so
+// the search never has to rescan the board, and the moves are kept as a stack
+// the game undoes and redoes.
+typedef struct {
+	int rows, cols, k;
+	int cells; // rows * cols
+	const mnk_shape *shape;
+	char cell[MAX_CELLS]; // 0 means empty, 1 means X, 2 means O (same as board[])
+	int stones;
+	unsigned char line_count[MAX_LINES][2]; // X and O stones in every line
+	unsigned char near[MAX_CELLS]; // stones within 2 cells, used by generate_moves
+	short open_lines[2][MAX_K + 1]; // lines holding c stones of X (O) and none of O (X)
+	int score; // evaluation from X's point of view
+	unsigned long long hash; // Zobrist hash of the stones
+	unsigned char history[MAX_CELLS]; // cells in the order they were played
+	unsigned char history_player[MAX_CELLS];
+	int history_total; // moves from stones on can be redone
+} mnk_board;
+
+// One exhibition game. Its board is exhibition_layout moved to left, top.
+typedef struct {
+	mnk_board position;
+	int left, top;
+	int player; // to move, the engine is 2
+	int wait; // frames before the challenger moves or the next game starts
+	int result; // 0 while playing, then 1 or 2 for the winner or 3 for a tie
+	int line; // exhibition_layout line that won, -1 if none
+	unsigned int dirty; // a bit per cell to draw again
+	bool redraw; // the whole board
+} exhibition_board;
+
+// Exhibition frame times, in timer ticks
+typedef struct {
+	unsigned int frames;
+	unsigned int moves, games;
+	unsigned int deferred; // engine moves left for the next frame by the budget
+	unsigned int max_ticks;
+	unsigned long long total_ticks, ai_ticks, draw_ticks;
+} exhibition_counters;
+
+// An ultimate tic-tac-toe position, as bit masks of cells and boards
+typedef struct {
+	unsigned short cells[2][9]; // X's and O's stones on each board, bit per cell
+	unsigned short won[2]; // boards won by X and O: the meta-board
+	unsigned short closed; // boards won or full
+	signed char next; // board the next move must be on, -1 for any open one
+	unsigned char player; // 1 or 2 to move
+	unsigned char result; // same as check_winner: 0 unfinished, 1 X won, 2 O won, 3 tie
+	unsigned char moves;
+} ultimate_board;
+
+// A node of the ultimate search tree, for the move that led to it
+typedef struct {
+	int first_child; // children are consecutive, -1 until expanded
+	unsigned int visits;
+	unsigned int score; // two points a win, one a tie, for the side that played move
+	unsigned char move;
+	unsigned char child_total;
+} ultimate_node;
+
+// Work done by the ultimate engine's searches
+typedef struct {
+	unsigned int searches;
+	unsigned int playouts, nodes, ticks; // last search
+	unsigned long long total_playouts, total_ticks;
+} ultimate_counters;
+
+// A Qubic position
+typedef struct {
+	unsigned long long stones[2]; // X's and O's, bit per cell
+	int player; // 1 or 2 to move
+	int result; // same as check_winner: 0 unfinished, 1 X won, 2 O won, 3 tie
+	int moves;
+	int line; // line that won, -1 if none
+} qubic_board;
+
+// Work done by the Qubic engine's last search
+typedef struct {
+	unsigned int searches;
+	unsigned int nodes, ticks;
+	int depth; // last depth completed
+	int score;
+	unsigned long long total_nodes, total_ticks;
+} qubic_counters;
+
+// Statistics of one iteration of the iterative deepening search
+typedef struct {
+	unsigned int nodes;
+	unsigned int ticks; // A9 private timer ticks spent on this depth
+	int score;
+	int best_move;
+	bool completed;
+} depth_stats;
+
+// Proof-number solver transposition table entry. Proof (pn) and disproof (dn)
+// numbers are from the attacker's point of view. Entries stamped with an
+// older pns_generation are empty, so a new solve needn't clear the table.
+typedef struct {
+	unsigned long long hash;
+	unsigned int pn, dn;
+	unsigned int work; // nodes spent below this entry, used for replacement
+	unsigned int generation; // in the padding after work
+} pns_entry;
+
+// One solver thread. Each worker proves the attacker's root moves whose index
+// modulo PNS_THREADS is its own and uses its own slice of pns_table.
+typedef struct {
+	mnk_board board;
+	int attacker;
+	int worker;
+	pns_entry *table;
+	unsigned int table_size;
+	unsigned int nodes;
+	unsigned int table_used; // entries of the slice this solve has filled
+	int winning_move; // proven root move or -1
+	unsigned char moves[PNS_MAX_PLY + 1][MAX_CELLS];
+} pns_context;
+
+// Statistics of the last proof-number solve
+typedef struct {
+	unsigned int nodes;
+	unsigned int ticks;
+	unsigned int positions_per_second;
+	unsigned int proof_size; // nodes in the proof tree of a proven win
+	unsigned int table_used; // occupied transposition table entries
+	int result; // 1 proven win, 0 disproven, -1 unknown (out of time)
+} solver_stats;
+
+// Header at the start of an endgame database file. The values follow it,
+// 4 positions per byte, in the order given by endgame_rank.
+typedef struct {
+	char magic[8]; // "TTTEGDB"
+	int rows, cols, k;
+	int reserved;
+	unsigned long long total; // number of ranked positions
+} endgame_header;
+
+// An endgame database attached in memory. Positions are ranked first by
+// number of stones, then by the set of X cells, then by the set of O cells
+// among the cells X doesn't hold.
+typedef struct {
+	int rows, cols, k;
+	int cells;
+	unsigned long long layer_offset[MAX_DB_CELLS + 2]; // first index of each stone count
+	unsigned long long total;
+	const unsigned char *values; // NULL when no database is attached
+} endgame_db;
+
+// A finished (or abandoned) game. In the log a record is 3 header bytes
+// (rows << 4 | cols, k << 4 | result << 2, number of moves) followed by the
+// moves packed at the fewest bits that hold a cell index, 4 bits on 3x3.
+typedef struct {
+	int rows, cols, k;
+	int result; // same as check_winner: 0 unfinished, 1 X won, 2 O won, 3 tie
+	int move_total;
+	unsigned char moves[MAX_CELLS];
+} game_record;
+
+// Header at the start of an opening book file, followed by count entries
+// sorted by key
+typedef struct {
+	char magic[8]; // "TTTBOOK"
+	int rows, cols, k;
+	int reserved;
+	unsigned long long count;
+} book_header;
+
+// Self-play results of one position, reduced over the board's symmetries
+typedef struct {
+	unsigned long long key; // canonical_key of the position
+	unsigned int games;
+	int score; // wins minus losses for the player who moved into the position
+} book_entry;
+
+// An opening book attached in memory
+typedef struct {
+	int rows, cols, k;
+	unsigned long long count;
+	const book_entry *entries; // NULL when no book is attached
+	unsigned int lookups; // book_move calls on a matching board
+	unsigned int hits; // calls that returned a move
+} opening_book;
+
+// Functions for checking the stacks
+void stack_paint(stack_region *stack, const char *name, unsigned int *bottom, unsigned int *top, unsigned int *end);
+unsigned int stack_used(const stack_region *stack);
+bool stack_check(stack_region *stack, const char *by);
+void stack_report(int row);
+#ifndef HOST_BUILD
+void stack_init(void);
+#endif
+
+// Functions for the frame buffer
+bool surface_init(surface *s);
+void surface_attach(surface *s, void *base, int width, int height, int pitch);
+
+// Functions for pixel text
+const text_layout *text_layout_get(const char *text, int scale);
+
+// Functions for the board layout
+void layout_init(board_layout *l, int rows, int cols, int k, int left, int top, int width, int height);
+void draw_mark(const board_layout *l, int x, int y, int cell, int player);
+void draw_layout_box(const board_layout *l, int cell, short int colour);
+
+// Functions for the search engine
+void config_timer(void);
+unsigned int read_timer(void);
+const mnk_shape *engine_shape(int rows, int cols, int k);
+void engine_init(mnk_board *b, int rows, int cols, int k);
+void engine_play(mnk_board *b, int cell, int player);
+void engine_undo(mnk_board *b, int cell);
+int engine_undo_last(mnk_board *b);
+int engine_redo(mnk_board *b);
+bool engine_is_win(mnk_board *b, int cell);
+int engine_evaluate(mnk_board *b, int player);
+int engine_rescore(mnk_board *b);
+int generate_moves(mnk_board *b, unsigned char *moves);
+int negamax(mnk_board *b, int depth, int alpha, int beta, int player, int ply);
+int search_best_move(mnk_board *b, int player, unsigned int budget_ticks);
+int threat_moves(mnk_board *b, int attacker, bool attacker_to_move, int last, unsigned char *moves, int *outcome);
+void pns_mid(pns_context *ctx, int ply, int last, unsigned int threshold_pn, unsigned int threshold_dn);
+unsigned int pns_proof_size(pns_context *ctx, int ply, int last);
+void *pns_worker(void *arg);
+int pns_solve(mnk_board *b, int attacker, unsigned int budget_ticks);
+
+// Functions for the analysis overlay
+void analysis_toggle(void);
+void analysis_update(void);
+int analysis_cell(mnk_board *b, int cell, int player);
+void analysis_clear(void);
+
+// Functions for ultimate tic-tac-toe
+void ultimate_init(ultimate_board *u);
+int ultimate_moves(const ultimate_board *u, unsigned char *moves);
+void ultimate_play(ultimate_board *u, int move);
+int ultimate_playout(ultimate_board *u, unsigned int *seed);
+int ultimate_search(const ultimate_board *root, unsigned int budget_ticks);
+void ultimate_toggle(void);
+void ultimate_key(unsigned char byte0);
+void ultimate_draw(void);
+
+// Functions for Qubic
+void qubic_init(qubic_board *b);
+bool qubic_is_win(unsigned long long stones, int cell);
+void qubic_play(qubic_board *b, int cell);
+unsigned long long qubic_open_cells(unsigned long long mine, unsigned long long theirs, int count);
+int qubic_evaluate(unsigned long long mine, unsigned long long theirs);
+int qubic_negamax(unsigned long long mine, unsigned long long theirs, int depth, int alpha, int beta, int ply);
+int qubic_search(const qubic_board *b, unsigned int budget_ticks);
+void qubic_toggle(void);
+void qubic_key(unsigned char byte0);
+void qubic_draw(void);
+
+// Functions for the game log
+int move_bits(int cells);
+int game_record_encode(game_record *g, unsigned char *out);
+int game_record_decode(const unsigned char *in, game_record *g);
+void game_log_append(game_record *g);
+void game_log_flush(void);
+void start_game_record(void);
+void record_move(int index);
+void record_result(int winner);
+void unrecord_move(void);
+
+// Functions for the opening book
+int symmetry_cell(int cell, int symmetry, int rows, int cols);
+unsigned long long canonical_key(mnk_board *b);
+bool book_attach(opening_book *book, const void *image);
+const book_entry *book_find(opening_book *book, unsigned long long key);
+int book_move(opening_book *book, mnk_board *b);
+#ifdef HOST_BUILD
+bool book_open(opening_book *book, const char *path);
+#endif
+
+// Functions for the endgame database
+void endgame_layout(endgame_db *db, int rows, int cols, int k);
+unsigned long long endgame_rank(endgame_db *db, const char *cell);
+int endgame_value(endgame_db *db, unsigned long long index);
+bool endgame_attach(endgame_db *db, const void *image);
+int endgame_best_move(endgame_db *db, mnk_board *b);
+#ifdef HOST_BUILD
+bool endgame_open(endgame_db *db, const char *path);
+#endif
+
+#ifdef HOST_BUILD
+// Functions for mapping files on the host
+void *map_read(const char *path, size_t *size);
+void *map_create(const char *path, size_t size);
+#endif
+
+// Global variables
+int selection_cell; // index into board[] of the red selection box
+bool isStalemate = false;
+char Turn;
+int board[GAME_CELLS]; 
+board_layout game_layout;
+mnk_board game_position; // the moves of the game, undone and redone with [U] and [R]
+bool break_pending; // the last byte was 0xF0, so the next is a released key
+
+// Cell (plus one) selected by each number key's scancode, 0 for other keys
+const signed char number_key_cell[256] = {
+	[0x16] = 1, [0x1E] = 2, [0x26] = 3, [0x25] = 4, [0x2E] = 5,
+	[0x36] = 6, [0x3D] = 7, [0x3E] = 8, [0x46] = 9
+};
+
+#ifdef HOST_BUILD
+// Memory standing in for the pixel and character buffers on the host, laid
+// out like the hardware (512 pixel rows at 320x240, 128 character rows)
+pixel_value host_pixel_buffer[MAX_SCREEN_HEIGHT * 1024];
+char host_character_buffer[60][128];
+surface screen = {(char *) host_pixel_buffer, SCREEN_WIDTH, SCREEN_HEIGHT, 512 * sizeof(pixel_value),
+	sizeof(pixel_value), SCREEN_WIDTH / TEXT_COLUMNS, SCREEN_HEIGHT / TEXT_ROWS};
+#else
+surface screen; // set up by surface_init
+#endif
+
+// Text renderer state. The font is the 8x8 PC font from ' ' to '~', one
+// byte per row with the leftmost pixel in bit 0.
+const unsigned char font_8x8[FONT_GLYPHS][FONT_SIZE] = {
+	{0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00}, // space
+	{0x18, 0x3C, 0x3C, 0x18, 0x18, 0x00, 0x18, 0x00}, // !
+	{0x36, 0x36, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00}, // "
+	{0x36, 0x36, 0x7F, 0x36, 0x7F, 0x36, 0x36, 0x00}, // #
+	{0x0C, 0x3E, 0x03, 0x1E, 0x30, 0x1F, 0x0C, 0x00}, // $
+	{0x00, 0x63, 0x33, 0x18, 0x0C, 0x66, 0x63, 0x00}, // %
+	{0x1C, 0x36, 0x1C, 0x6E, 0x3B, 0x33, 0x6E, 0x00}, // &
+	{0x06, 0x06, 0x03, 0x00, 0x00, 0x00, 0x00, 0x00}, // '
+	{0x18, 0x0C, 0x06, 0x06, 0x06, 0x0C, 0x18, 0x00}, // (
+	{0x06, 0x0C, 0x18, 0x18, 0x18, 0x0C, 0x06, 0x00}, // )
+	{0x00, 0x66, 0x3C, 0xFF, 0x3C, 0x66, 0x00, 0x00}, // *
+	{0x00, 0x0C, 0x0C, 0x3F, 0x0C, 0x0C, 0x00, 0x00}, // +
+	{0x00, 0x00, 0x00, 0x00, 0x00, 0x0C, 0x0C, 0x06}, // ,
+	{0x00, 0x00, 0x00, 0x3F, 0x00, 0x00, 0x00, 0x00}, // -
+	{0x00, 0x00, 0x00, 0x00, 0x00, 0x0C, 0x0C, 0x00}, // .
+	{0x60, 0x30, 0x18, 0x0C, 0x06, 0x03, 0x01, 0x00}, // /
+	{0x3E, 0x63, 0x73, 0x7B, 0x6F, 0x67, 0x3E, 0x00}, // 0
+	{0x0C, 0x0E, 0x0C, 0x0C, 0x0C, 0x0C, 0x3F, 0x00}, // 1
+	{0x1E, 0x33, 0x30, 0x1C, 0x06, 0x33, 0x3F, 0x00}, // 2
+	{0x1E, 0x33, 0x30, 0x1C, 0x30, 0x33, 0x1E, 0x00}, // 3
+	{0x38, 0x3C, 0x36, 0x33, 0x7F, 0x30, 0x78, 0x00}, // 4
+	{0x3F, 0x03, 0x1F, 0x30, 0x30, 0x33, 0x1E, 0x00}, // 5
+	{0x1C, 0x06, 0x03, 0x1F, 0x33, 0x33, 0x1E, 0x00}, // 6
+	{0x3F, 0x33, 0x30, 0x18, 0x0C, 0x0C, 0x0C, 0x00}, // 7
+	{0x1E, 0x33, 0x33, 0x1E, 0x33, 0x33, 0x1E, 0x00}, // 8
+	{0x1E, 0x33, 0x33, 0x3E, 0x30, 0x18, 0x0E, 0x00}, // 9
+	{0x00, 0x0C, 0x0C, 0x00, 0x00, 0x0C, 0x0C, 0x00}, // :
+	{0x00, 0x0C, 0x0C, 0x00, 0x00, 0x0C, 0x0C, 0x06}, // ;
+	{0x18, 0x0C, 0x06, 0x03, 0x06, 0x0C, 0x18, 0x00}, // <
+	{0x00, 0x00, 0x3F, 0x00, 0x00, 0x3F, 0x00, 0x00}, // =
+	{0x06, 0x0C, 0x18, 0x30, 0x18, 0x0C, 0x06, 0x00}, // >
+	{0x1E, 0x33, 0x30, 0x18, 0x0C, 0x00, 0x0C, 0x00}, // ?
+	{0x3E, 0x63, 0x7B, 0x7B, 0x7B, 0x03, 0x1E, 0x00}, // @
+	{0x0C, 0x1E, 0x33, 0x33, 0x3F, 0x33, 0x33, 0x00}, // A
+	{0x3F, 0x66, 0x66, 0x3E, 0x66, 0x66, 0x3F, 0x00}, // B
+	{0x3C, 0x66, 0x03, 0x03, 0x03, 0x66, 0x3C, 0x00}, // C
+	{0x1F, 0x36, 0x66, 0x66, 0x66, 0x36, 0x1F, 0x00}, // D
+	{0x7F, 0x46, 0x16, 0x1E, 0x16, 0x46, 0x7F, 0x00}, // E
+	{0x7F, 0x46, 0x16, 0x1E, 0x16, 0x06, 0x0F, 0x00}, // F
+	{0x3C, 0x66, 0x03, 0x03, 0x73, 0x66, 0x7C, 0x00}, // G
+	{0x33, 0x33, 0x33, 0x3F, 0x33, 0x33, 0x33, 0x00}, // H
+	{0x1E, 0x0C, 0x0C, 0x0C, 0x0C, 0x0C, 0x1E, 0x00}, // I
+	{0x78, 0x30, 0x30, 0x30, 0x33, 0x33, 0x1E, 0x00}, // J
+	{0x67, 0x66, 0x36, 0x1E, 0x36, 0x66, 0x67, 0x00}, // K
+	{0x0F, 0x06, 0x06, 0x06, 0x46, 0x66, 0x7F, 0x00}, // L
+	{0x63, 0x77, 0x7F, 0x7F, 0x6B, 0x63, 0x63, 0x00}, // M
+	{0x63, 0x67, 0x6F, 0x7B, 0x73, 0x63, 0x63, 0x00}, // N
+	{0x1C, 0x36, 0x63, 0x63, 0x63, 0x36, 0x1C, 0x00}, // O
+	{0x3F, 0x66, 0x66, 0x3E, 0x06, 0x06, 0x0F, 0x00}, // P
+	{0x1E, 0x33, 0x33, 0x33, 0x3B, 0x1E, 0x38, 0x00}, // Q
+	{0x3F, 0x66, 0x66, 0x3E, 0x36, 0x66, 0x67, 0x00}, // R
+	{0x1E, 0x33, 0x07, 0x0E, 0x38, 0x33, 0x1E, 0x00}, // S
+	{0x3F, 0x2D, 0x0C, 0x0C, 0x0C, 0x0C, 0x1E, 0x00}, // T
+	{0x33, 0x33, 0x33, 0x33, 0x33, 0x33, 0x3F, 0x00}, // U
+	{0x33, 0x33, 0x33, 0x33, 0x33, 0x1E, 0x0C, 0x00}, // V
+	{0x63, 0x63, 0x63, 0x6B, 0x7F, 0x77, 0x63, 0x00}, // W
+	{0x63, 0x63, 0x36, 0x1C, 0x1C, 0x36, 0x63, 0x00}, // X
+	{0x33, 0x33, 0x33, 0x1E, 0x0C, 0x0C, 0x1E, 0x00}, // Y
+	{0x7F, 0x63, 0x31, 0x18, 0x4C, 0x66, 0x7F, 0x00}, // Z
+	{0x1E, 0x06, 0x06, 0x06, 0x06, 0x06, 0x1E, 0x00}, // [
+	{0x03, 0x06, 0x0C, 0x18, 0x30, 0x60, 0x40, 0x00}, // backslash
+	{0x1E, 0x18, 0x18, 0x18, 0x18, 0x18, 0x1E, 0x00}, // ]
+	{0x08, 0x1C, 0x36, 0x63, 0x00, 0x00, 0x00, 0x00}, // ^
+	{0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF}, // _
+	{0x0C, 0x0C, 0x18, 0x00, 0x00, 0x00, 0x00, 0x00}, // `
+	{0x00, 0x00, 0x1E, 0x30, 0x3E, 0x33, 0x6E, 0x00}, // a
+	{0x07, 0x06, 0x06, 0x3E, 0x66, 0x66, 0x3B, 0x00}, // b
+	{0x00, 0x00, 0x1E, 0x33, 0x03, 0x33, 0x1E, 0x00}, // c
+	{0x38, 0x30, 0x30, 0x3E, 0x33, 0x33, 0x6E, 0x00}, // d
+	{0x00, 0x00, 0x1E, 0x33, 0x3F, 0x03, 0x1E, 0x00}, // e
+	{0x1C, 0x36, 0x06, 0x0F, 0x06, 0x06, 0x0F, 0x00}, // f
+	{0x00, 0x00, 0x6E, 0x33, 0x33, 0x3E, 0x30, 0x1F}, // g
+	{0x07, 0x06, 0x36, 0x6E, 0x66, 0x66, 0x67, 0x00}, // h
+	{0x0C, 0x00, 0x0E, 0x0C, 0x0C, 0x0C, 0x1E, 0x00}, // i
+	{0x30, 0x00, 0x30, 0x30, 0x30, 0x33, 0x33, 0x1E}, // j
+	{0x07, 0x06, 0x66, 0x36, 0x1E, 0x36, 0x67, 0x00}, // k
+	{0x0E, 0x0C, 0x0C, 0x0C, 0x0C, 0x0C, 0x1E, 0x00}, // l
+	{0x00, 0x00, 0x33, 0x7F, 0x7F, 0x6B, 0x63, 0x00}, // m
+	{0x00, 0x00, 0x1F, 0x33, 0x33, 0x33, 0x33, 0x00}, // n
+	{0x00, 0x00, 0x1E, 0x33, 0x33, 0x33, 0x1E, 0x00}, // o
+	{0x00, 0x00, 0x3B, 0x66, 0x66, 0x3E, 0x06, 0x0F}, // p
+	{0x00, 0x00, 0x6E, 0x33, 0x33, 0x3E, 0x30, 0x78}, // q
+	{0x00, 0x00, 0x3B, 0x6E, 0x66, 0x06, 0x0F, 0x00}, // r
+	{0x00, 0x00, 0x3E, 0x03, 0x1E, 0x30, 0x1F, 0x00}, // s
+	{0x08, 0x0C, 0x3E, 0x0C, 0x0C, 0x2C, 0x18, 0x00}, // t
+	{0x00, 0x00, 0x33, 0x33, 0x33, 0x33, 0x6E, 0x00}, // u
+	{0x00, 0x00, 0x33, 0x33, 0x33, 0x1E, 0x0C, 0x00}, // v
+	{0x00, 0x00, 0x63, 0x6B, 0x7F, 0x7F, 0x36, 0x00}, // w
+	{0x00, 0x00, 0x63, 0x36, 0x1C, 0x36, 0x63, 0x00}, // x
+	{0x00, 0x00, 0x33, 0x33, 0x33, 0x3E, 0x30, 0x1F}, // y
+	{0x00, 0x00, 0x3F, 0x19, 0x0C, 0x26, 0x3F, 0x00}, // z
+	{0x38, 0x0C, 0x0C, 0x07, 0x0C, 0x0C, 0x38, 0x00}, // {
+	{0x18, 0x18, 0x18, 0x00, 0x18, 0x18, 0x18, 0x00}, // |
+	{0x07, 0x0C, 0x0C, 0x38, 0x0C, 0x0C, 0x07, 0x00}, // }
+	{0x6E, 0x3B, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00}, // ~
+};
+text_layout text_cache[TEXT_CACHE_SIZE];
+unsigned int text_cache_hits, text_cache_misses;
+
+// Interrupt registry state
+irq_source irq_sources[MAX_IRQ_SOURCES];
+int irq_source_total;
+unsigned char irq_slot[MAX_IRQ_ID]; // index into irq_sources plus one, 0 if unregistered
+unsigned int irq_unexpected; // interrupts nothing was registered for
+int irq_last_unexpected;
+
+// Stack checking state, unpainted (bottom NULL) until stack_init
+stack_region irq_stack, svc_stack;
+
+// Performance HUD state. Segment a is bit 0, g bit 6.
+const unsigned char hex_digit_segments[10] = {0x3F, 0x06, 0x5B, 0x4F, 0x66, 0x6D, 0x7D, 0x07, 0x7F, 0x6F};
+const unsigned char hud_value_letter[3] = {0x76, 0x71, 0x54}; // H(andler), F(rame), n(odes)
+unsigned short hex_digit_pairs[100]; // segments of 00 to 99, tens in the high byte
+int hud_mode;
+volatile hud_counters hud;
+unsigned int hud_isr_shown; // longest handler run in the frame before the last poll
+unsigned int hud_last_poll, hud_frames;
+unsigned int hud_ring_underruns; // audio_stats.ring_underruns at the last poll
+unsigned int hud_hex[2], hud_ledr; // what the displays were last set to
+char hud_text[3][20];
+
+// Analysis overlay state
+analysis_entry analysis_table[ANALYSIS_TABLE_SIZE];
+analysis_counters analysis_stats;
+bool analysis_showing;
+bool analysis_current; // analysis_key's values are all on screen
+unsigned long long analysis_key;
+char analysis_label[MAX_LAYOUT_CELLS][4]; // what each cell's label position shows while the overlay is on
+mnk_board analysis_board; // kept off the stack
+unsigned char analysis_moves[MAX_DEPTH + 1][MAX_CELLS];
+unsigned int analysis_start, analysis_budget = ANALYSIS_BUDGET_TICKS;
+bool analysis_aborted;
+
+// Exhibition state. Once it has started only the main loop touches it; keys
+// ask for a start or stop through exhibition_request.
+exhibition_board exhibition_boards[MAX_EXHIBITION_BOARDS];
+int exhibition_total; // boards, 0 when there is no exhibition
+board_layout exhibition_layout; // cells relative to a board's top left
+volatile int exhibition_request = -1; // boards to start, 0 to stop, -1 for nothing
+unsigned int exhibition_last_frame;
+exhibition_counters exhibition_stats; // whole run
+exhibition_counters exhibition_window; // frames since the last report line
+
+// Ultimate tic-tac-toe state. ultimate_wins is shared by the engine's boards
+// and meta-board: whether a 3x3 mask of cells holds a line.
+bool ultimate_wins[512];
+ultimate_node ultimate_tree[ULTIMATE_TREE_SIZE];
+int ultimate_tree_total;
+ultimate_counters ultimate_stats;
+unsigned int ultimate_seed = 1;
+ultimate_board ultimate_game;
+bool ultimate_showing;
+int ultimate_pick = -1; // board chosen with a number key when any open one may be played
+board_layout ultimate_layout; // the 81 cells
+board_layout ultimate_meta_layout; // the nine boards, over the same rectangle
+
+// Qubic state. Lines are listed by cell too, so a move's win test only looks
+// at the four to seven lines through it.
+unsigned long long qubic_line[QUBIC_LINES];
+unsigned char qubic_cell_lines[QUBIC_CELLS][QUBIC_MAX_LINES_PER_CELL];
+unsigned char qubic_cell_line_total[QUBIC_CELLS];
+unsigned long long qubic_strong; // cells on seven lines
+qubic_counters qubic_stats;
+unsigned int qubic_start, qubic_budget;
+bool qubic_aborted;
+qubic_board qubic_game;
+bool qubic_showing;
+int qubic_cursor;
+board_layout qubic_layer_layout[4]; // one per layer, stacked top to bottom
+
+// Console state. Only the console's interrupt handler moves the receive
+// ring's tail and the transmit ring's head.
+char console_rx[CONSOLE_RX_SIZE];
+char console_tx[CONSOLE_TX_SIZE];
+unsigned int console_rx_head, console_rx_tail; // free running byte counts
+unsigned int console_tx_head, console_tx_tail;
+char console_line[CONSOLE_LINE + 1];
+int console_line_length;
+console_counters console_stats;
+
+// Audio state. The keyboard interrupt bumps audio_requested and audio_pump,
+// in the main loop, starts the clips and advances audio_head; the audio
+// interrupt only advances audio_tail, so neither side needs a lock.
+short audio_clip_data[AUDIO_CLIP_SAMPLES];
+const short *audio_clip_start[AUDIO_CLIPS];
+int audio_clip_length[AUDIO_CLIPS];
+volatile unsigned char audio_requested[AUDIO_CLIPS];
+unsigned char audio_started[AUDIO_CLIPS];
+audio_voice audio_voices[AUDIO_VOICES];
+short audio_ring[AUDIO_RING_SIZE];
+volatile unsigned int audio_head, audio_tail; // free running sample counts
+audio_counters audio_stats;
+#ifdef HOST_BUILD
+FILE *audio_wav;
+unsigned int audio_wav_samples;
+#endif
+
+// Screen snapshot state
+screen_snapshot game_snapshot; // invalidated by game_view_changed
+screen_snapshot help_snapshot;
+bool help_showing;
+toggle_stats help_open_stats, help_close_stats;
+
+// Search engine state
+THREAD_LOCAL depth_stats search_stats[MAX_DEPTH + 1]; // indexed by depth
+THREAD_LOCAL int search_depth_reached; // deepest completed iteration of the last search
+THREAD_LOCAL unsigned int search_nodes;
+THREAD_LOCAL unsigned int search_start;
+THREAD_LOCAL unsigned int search_budget;
+THREAD_LOCAL bool search_aborted;
+THREAD_LOCAL unsigned char move_list[MAX_DEPTH + 1][MAX_CELLS]; // kept off the IRQ stack
+THREAD_LOCAL int pv_table[MAX_DEPTH + 1][MAX_DEPTH + 1]; // principal variation per ply
+THREAD_LOCAL int pv_length[MAX_DEPTH + 1];
+THREAD_LOCAL int previous_pv[MAX_DEPTH + 1]; // PV of the last completed iteration
+THREAD_LOCAL int previous_pv_length;
+THREAD_LOCAL bool search_on_pv; // the node being entered was reached along previous_pv
+
+// Board shapes state. A shape is filled in before shape_total counts it, and
+// only engine_shape adds them, under shape_lock on the host. On the board
+// main builds the game's shape before interrupts are on.
+mnk_shape shapes[MAX_SHAPES];
+int shape_total;
+unsigned long long zobrist[MAX_CELLS][2]; // random keys for position hashes, built with the first shape
+#ifdef HOST_BUILD
+pthread_mutex_t shape_lock = PTHREAD_MUTEX_INITIALIZER;
+#endif
+
+// Proof-number solver state
+int ai_strategy = AI_STRATEGY_SEARCH; // toggled with [P]
+pns_entry pns_table[PNS_TABLE_SIZE]; // shared out equally between the workers
+pns_context pns_workers[PNS_THREADS];
+solver_stats pns_stats;
+volatile bool pns_stop;
+unsigned int pns_start;
+unsigned int pns_budget;
+unsigned int pns_generation; // stamp of the current solve's table entries, never 0
+
+// Game log state
+game_record current_game;
+unsigned char game_log_buffer[GAME_LOG_BUFFER_SIZE];
+int game_log_buffered; // bytes waiting in game_log_buffer
+unsigned int game_log_length; // bytes written to the log
+#ifdef HOST_BUILD
+char *game_log_path = GAME_LOG_PATH;
+#endif
+
+// Opening book state
+opening_book book;
+
+// Endgame database state
+endgame_db endgame;
+unsigned long long binomial[MAX_DB_CELLS + 1][MAX_DB_CELLS + 1];
+
+#ifndef HOST_BUILD
+int main(void) {
+	clear_text();
+	
+	// First turn goes to X
+	Turn = 'X';
+	
+	// Location, resolution and row pitch of the pixel buffer
+	surface_init(&screen);
+	
+	// Drawing in another pixel format would only put garbage on the screen
+	if (screen.bpp != sizeof(pixel_value)){
+		char message[MAX_TEXT_CHARS];
+		sprintf(message, "Pixel buffer has %d bytes a pixel, built for PIXEL_BITS %d", screen.bpp, PIXEL_BITS);
+		write_text(1, 1, message);
+		while (1);
+	}
+	
+	// Screen positions of everything on the board
+	layout_init(&game_layout, GAME_ROWS, GAME_COLS, GAME_K, BOARD_MARGIN, BOARD_MARGIN,
+		screen.width - 2 * BOARD_MARGIN, screen.height - 2 * BOARD_MARGIN);
+	
+	// Red selection box starts in the top left box
+	selection_cell = 0;
+	engine_init(&game_position, GAME_ROWS, GAME_COLS, GAME_K);
+	
+	clear_screen();
+	initial_screen();
+	snapshot_init();
+	audio_init();
+	config_timer(); // free running timer used by the AI deadline
+	hud_init();
+	start_game_record();
+	
+#ifdef OPENING_BOOK_ADDRESS
+	// Opening book file loaded into memory together with the program
+	book_attach(&book, (const void *) OPENING_BOOK_ADDRESS);
+#endif
+#ifdef ENDGAME_DB_ADDRESS
+	// Endgame database file loaded into memory together with the program
+	endgame_attach(&endgame, (const void *) ENDGAME_DB_ADDRESS);
+#endif
+	
+	// The audio core outranks the keyboard, whose handler runs the AI
+	irq_register(79, keyboard_ISR, IRQ_PRIORITY_KEYBOARD, false, true, "PS/2 keyboard");
+	irq_register(AUDIO_IRQ, audio_ISR, IRQ_PRIORITY_AUDIO, false, false, "audio");
+	irq_register(JTAG_UART_IRQ, console_ISR, IRQ_PRIORITY_KEYBOARD, false, true, "JTAG UART");
+	console_init();
+	
+	disable_A9_interrupts(); // disable interrupts in the A9 processor
+	stack_init(); // paint both stacks for the watermark and overflow checks
+	set_A9_IRQ_stack(); // initialize the stack pointer for IRQ mode
+	config_GIC(); // configure the general interrupt controller
+	config_KEYs(); // configure pushbutton KEYs to generate interrupts
+	enable_A9_interrupts(); // enable interrupts in the A9 processor
+	
+	// Interrupts do the rest, the main loop keeps the sound mixed ahead, the
+	// HUD up to date and an exhibition running
+	while (1){
+		audio_pump();
+		hud_poll();
+		exhibition_poll();
+	}
+}
+
+
+/* setup the PS/2 interrupts in the FPGA */
+void config_KEYs() {
+	volatile int * PS2_ptr = (int *) 0xFF200100; // PS/2 base address
+	*(PS2_ptr + 1) = 0x00000001; // set RE to 1 to enable interrupts
+}
+
+/* setup the A9 private timer as a free running down counter */
+void config_timer(void) {
+	volatile int * timer_ptr = (int *) 0xFFFEC600; // MPCORE_PRIV_TIMER
+	*(timer_ptr) = 0xFFFFFFFF; // load value
+	*(timer_ptr + 2) = 0b011; // auto reload, enable, no interrupt, prescaler 0
+}
+
+// Returns the current value of the A9 private timer counter
+unsigned int read_timer(void) {
+	volatile int * timer_ptr = (int *) 0xFFFEC600;
+	return (unsigned int) *(timer_ptr + 1);
+}
+
+// Runs a handler in SVC mode with IRQs enabled. The GIC only signals
+// interrupts of a higher priority than the one acknowledged until its end
+// of interrupt is written, so those are the ones that can preempt it. SPSR_irq
+// and the interrupted code's LR_svc are kept on the stacks around the call.
+static void irq_call_nested(void (*handler)(void)) {
+	asm volatile(
+		"mrs r1, spsr\n"
+		"push {r1, r2}\n" // IRQ stack, kept 8 byte aligned
+		"msr cpsr_c, #0x13\n" // SVC mode, IRQs on
+		"mov r2, sp\n"
+		"bic sp, sp, #7\n"
+		"push {r2, lr}\n"
+		"blx %[handler]\n"
+		"pop {r2, lr}\n"
+		"mov sp, r2\n"
+		"msr cpsr_c, #0xD2\n" // IRQ mode, IRQs and FIQs off
+		"pop {r1, r2}\n"
+		"msr spsr_cxsf, r1\n"
+		: : [handler] "r"(handler) : "r0", "r1", "r2", "r3", "r12", "lr", "memory", "cc");
+}
+
+// Define the IRQ exception handler: looks the acknowledged interrupt up in
+// the registry, calls its handler and keeps its counts and times
+void __attribute__((interrupt)) __cs3_isr_irq(void) {
+	unsigned int entry = read_timer();
+	
+	// Read the ICCIAR from the CPU Interface in the GIC
+	int interrupt_ID = *((int *)0xFFFEC10C) & 0x3FF;
+	if (interrupt_ID == 1023){ // spurious, nothing to acknowledge
+		return;
+	}
+	
+	int slot = (interrupt_ID < MAX_IRQ_ID) ? irq_slot[interrupt_ID] - 1 : -1;
+	if (slot < 0){
+		irq_unexpected++;
+		irq_last_unexpected = interrupt_ID;
+	} else {
+		irq_source *source = &irq_sources[slot];
+		unsigned int start = read_timer();
+		if (source->nested){
+			irq_call_nested(source->handler);
+		} else {
+			source->handler();
+		}
+		unsigned int ticks = start - read_timer();
+		
+		// A handler that ran off the bottom of a stack changed its guard
+		stack_check(&irq_stack, source->name);
+		stack_check(&svc_stack, source->name);
+		source->count++;
+		if (entry - start > source->max_dispatch){
+			source->max_dispatch = entry - start;
+		}
+		if (ticks > source->max_ticks){
+			source->max_ticks = ticks;
+		}
+		if (ticks > hud.isr_ticks){
+			hud.isr_ticks = ticks;
+		}
+	}
+	// Write to the End of Interrupt Register (ICCEOIR)
+	*((int *)0xFFFEC110) = interrupt_ID;
+}
+
+// Define the remaining exception handlers
+void __attribute__((interrupt)) __cs3_reset(void) {
+	while (1);
+}
+
+void __attribute__((interrupt)) __cs3_isr_undef(void) {
+	while (1);
+}
+
+void __attribute__((interrupt)) __cs3_isr_swi(void) {
+	while (1);
+}
+
+void __attribute__((interrupt)) __cs3_isr_pabort(void) {
+	while (1);
+}
+
+void __attribute__((interrupt)) __cs3_isr_dabort(void) {
+	while (1);
+}
+
+void __attribute__((interrupt)) __cs3_isr_fiq(void) {
+	while (1);
+}
+
+//Initialize the banked stack pointer register for IRQ mode
+void set_A9_IRQ_stack(void) {
+	int stack, mode;
+	stack = IRQ_STACK_TOP;
+	/* change processor to IRQ mode with interrupts disabled */
+	mode = 0b11010010;
+	asm("msr cpsr, %[ps]" : : [ps] "r"(mode));
+	/* set banked stack pointer */
+	asm("mov sp, %[ps]" : : [ps] "r"(stack));
+	/* go back to SVC mode before executing subroutine return! */
+	mode = 0b11010011;
+	asm("msr cpsr, %[ps]" : : [ps] "r"(mode));
+}
+
+// Paints the IRQ stack, which nothing has used yet, and the SVC stack below
+// the caller. Called with interrupts off.
+void stack_init(void) {
+	unsigned int *sp;
+	asm volatile("mov %[sp], sp" : [sp] "=r"(sp));
+	stack_paint(&irq_stack, "IRQ", (unsigned int *) (IRQ_STACK_TOP - IRQ_STACK_SIZE), (unsigned int *) IRQ_STACK_TOP,
+		(unsigned int *) IRQ_STACK_TOP);
+	stack_paint(&svc_stack, "SVC", sp - SVC_STACK_SIZE / 4, sp, sp - STACK_PAINT_MARGIN);
+}
+
+/*
+* Turn on interrupts in the ARM processor
+*/
+void enable_A9_interrupts(void) {
+	int status = 0b01010011;
+	asm("msr cpsr, %[ps]" : : [ps] "r"(status));
+}
+
+// Turn off interrupts in the ARM processor
+void disable_A9_interrupts(void) {
+	int status = 0b11010011;
+	asm("msr cpsr, %[ps]" : : [ps] "r"(status));
+}
+
+/*
+* Configure the Generic Interrupt Controller (GIC)
+*/
+void config_GIC(void) {
+	// Every registered source goes to CPU 0
+	for (int i = 0; i < irq_source_total; i++){
+		irq_source *source = &irq_sources[i];
+		config_interrupt (source->id, 1, source->priority, source->edge);
+	}
+	// Set Interrupt Priority Mask Register (ICCPMR). Enable interrupts of all
+	// priorities
+	*((int *) 0xFFFEC104) = 0xFFFF;
+	// Set CPU Interface Control Register (ICCICR). Enable signaling of
+	// interrupts
+	*((int *) 0xFFFEC100) = 1;
+	// Configure the Distributor Control Register (ICDDCR) to send pending
+	// interrupts to CPUs
+	*((int *) 0xFFFED000) = 1;
+}
+
+/*
+* Configure Set Enable Registers (ICDISERn), Interrupt Processor Target
+* Registers (ICDIPTRn), Interrupt Priority Registers (ICDIPRn) and Interrupt
+* Configuration Registers (ICDICFRn). The default (reset) values are used for
+* other registers in the GIC.
+*/
+void config_interrupt(int N, int CPU_target, int priority, bool edge) {
+	int reg_offset, index, value, address;
+	/* Configure the Interrupt Set-Enable Registers (ICDISERn).
+	* reg_offset = (integer_div(N / 32) * 4
+	* value = 1 << (N mod 32) */
+	reg_offset = (N >> 3) & 0xFFFFFFFC;
+	index = N & 0x1F;
+	value = 0x1 << index;
+	address = 0xFFFED100 + reg_offset;
+	/* Now that we know the register address and value, set the appropriate bit */
+	*(int *)address |= value;
+
+	/* Configure the Interrupt Processor Targets Register (ICDIPTRn)
+	* reg_offset = integer_div(N / 4) * 4
+	* index = N mod 4 */
+	reg_offset = (N & 0xFFFFFFFC);
+	index = N & 0x3;
+	address = 0xFFFED800 + reg_offset + index;
+	/* Now that we know the register address and value, write to (only) the
+	* appropriate byte */
+	*(char *)address = (char)CPU_target;
+	
+	/* One priority byte per interrupt, lower values are served first */
+	address = 0xFFFED400 + N;
+	*(char *)address = (char)priority;
+	
+	/* Two configuration bits per interrupt, the upper one set for edge
+	* triggered */
+	address = 0xFFFEDC00 + ((N >> 4) << 2);
+	value = 0x2 << ((N & 0xF) * 2);
+	if (edge){
+		*(int *)address |= value;
+	} else {
+		*(int *)address &= ~value;
+	}
+}
+#else
+void config_timer(void) {
+}
+
+// Counts down at TIMER_HZ like the A9 private timer
+unsigned int read_timer(void) {
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return 0xFFFFFFFF - (unsigned int) (now.tv_sec * (unsigned long long) TIMER_HZ + now.tv_nsec / (1000000000 / TIMER_HZ));
+}
+#endif
+
+#ifndef HOST_BUILD
+// Reads the pixel buffer controller. The resolution register holds the height
+// in the top half and the width in the bottom half. Bit 1 of the status
+// register is set when pixels are addressed consecutively; otherwise (x-y
+// addressing) every row starts at a power of two. Bits 8 to 11 hold the bytes
+// per pixel, kept in s->bpp for main to check against PIXEL_BITS. Returns
+// false, leaving the default 320x240 layout, if the resolution is one the
+// game can't draw.
+bool surface_init(surface *s){
+	volatile int * pixel_ctrl_ptr = (int *)0xFF203020;
+	
+	/* Read location of the pixel buffer from the pixel buffer controller */
+	char *base = (char *) *pixel_ctrl_ptr;
+	int resolution = *(pixel_ctrl_ptr + 2);
+	int status = *(pixel_ctrl_ptr + 3);
+	int width = resolution & 0xFFFF, height = (resolution >> 16) & 0xFFFF;
+	
+	if (width == 0 || width > MAX_SCREEN_WIDTH || height == 0 || height > MAX_SCREEN_HEIGHT){
+		surface_attach(s, base, SCREEN_WIDTH, SCREEN_HEIGHT, 512 * sizeof(pixel_value));
+		s->bpp = (status >> 8) & 0xF;
+		return false;
+	}
+	
+	int row_pixels = width;
+	if ((status & 2) == 0){
+		row_pixels = 1;
+		while (row_pixels < width){
+			row_pixels <<= 1;
+		}
+	}
+	surface_attach(s, base, width, height, row_pixels * sizeof(pixel_value));
+	s->bpp = (status >> 8) & 0xF;
+	return true;
+}
+#endif
+
+// Draws to any buffer in the compiled pixel format, for example host memory
+void surface_attach(surface *s, void *base, int width, int height, int pitch){
+	s->base = (char *) base;
+	s->width = width;
+	s->height = height;
+	s->pitch = pitch;
+	s->bpp = sizeof(pixel_value);
+	s->char_width = width / TEXT_COLUMNS;
+	s->char_height = height / TEXT_ROWS;
+}
+
+void plot_pixel(int x, int y, short int line_color)
+{
+    *(pixel_value *)(screen.base + y * screen.pitch + x * sizeof(pixel_value)) = PIXEL_COLOUR(line_color);
+}
+
+// Writes count pixels of one value from p on
+static inline void fill_span(pixel_value *p, int count, pixel_value value){
+	for (int c = 0; c < count; c++){
+		p[c] = value;
+	}
+}
+
+// Fills a rectangle a row at a time
+void fill_rect(int x, int y, int width, int height, short int colour){
+	char *row = screen.base + y * screen.pitch + x * sizeof(pixel_value);
+	pixel_value value = PIXEL_COLOUR(colour);
+	
+	for (int r = 0; r < height; r++, row += screen.pitch){
+		fill_span((pixel_value *) row, width, value);
+	}
+}
+
+// Decodes a run-length encoded image straight into the pixel buffer with its
+// top left corner at x, y, one span per run. What falls off the screen isn't
+// drawn, and a run that goes past the end of its row is cut there.
+void draw_rle_image(const unsigned short *runs, int width, int height, int x, int y){
+	int left = (x < 0) ? -x : 0;
+	int right = (x + width > screen.width) ? screen.width - x : width;
+	
+	for (int r = 0; r < height; r++){
+		bool shown = y + r >= 0 && y + r < screen.height;
+		pixel_value *p = (pixel_value *) (screen.base + (y + r) * screen.pitch) + x; // used only if shown
+		for (int c = 0; c < width; runs += 2){
+			if (runs[0] == 0){
+				return; // not a table png2rle wrote
+			}
+			int start = (c > left) ? c : left, end = (c + runs[0] < right) ? c + runs[0] : right;
+			if (shown && end > start){
+				fill_span(p + start, end - start, PIXEL_COLOUR(runs[1]));
+			}
+			c += runs[0];
+		}
+	}
+}
+
+// Returns the layout of text at scale from the cache, laying it out first if
+// it isn't there. Text that would be wider than the widest screen is cut off.
+const text_layout *text_layout_get(const char *text, int scale){
+	if (scale < 1){
+		scale = 1;
+	} else if (scale > MAX_SCREEN_WIDTH / FONT_SIZE){
+		scale = MAX_SCREEN_WIDTH / FONT_SIZE;
+	}
+	int limit = MAX_SCREEN_WIDTH / (FONT_SIZE * scale);
+	if (limit > MAX_TEXT_CHARS){
+		limit = MAX_TEXT_CHARS;
+	}
+	
+	// FNV-1a picks the slot
+	unsigned int hash = 2166136261u ^ scale;
+	int length = 0;
+	for (; length < limit && text[length] != '\0'; length++){
+		hash = (hash ^ (unsigned char) text[length]) * 16777619u;
+	}
+	text_layout *l = &text_cache[hash & (TEXT_CACHE_SIZE - 1)];
+	if (l->scale == scale && l->text[length] == '\0' && strncmp(l->text, text, length) == 0){
+		text_cache_hits++;
+		return l;
+	}
+	
+	text_cache_misses++;
+	memcpy(l->text, text, length);
+	l->text[length] = '\0';
+	l->scale = scale;
+	l->width = length * FONT_SIZE * scale;
+	memset(l->bits, 0, sizeof(l->bits));
+	for (int i = 0; i < length; i++){
+		unsigned char c = text[i];
+		const unsigned char *glyph = font_8x8[(c >= FONT_FIRST && c < FONT_FIRST + FONT_GLYPHS) ? c - FONT_FIRST : '?' - FONT_FIRST];
+		for (int r = 0; r < FONT_SIZE; r++){
+			for (int b = 0; b < FONT_SIZE; b++){
+				if ((glyph[r] >> b) & 1){
+					for (int x = (i * FONT_SIZE + b) * scale, end = x + scale; x < end; x++){
+						l->bits[r][x >> 5] |= 1u << (x & 31);
+					}
+				}
+			}
+		}
+	}
+	return l;
+}
+
+int text_width(const char *text, int scale){
+	return text_layout_get(text, scale)->width;
+}
+
+// Draws text into the pixel buffer with its top left corner at x, y, each
+// glyph pixel scale pixels square, leaving the background alone. Every row
+// is drawn from its layout a 32 pixel word at a time: empty words are
+// skipped and each run of set bits becomes one span.
+void draw_text(int x, int y, const char *text, int scale, short int colour){
+	const text_layout *l = text_layout_get(text, scale);
+	pixel_value value = PIXEL_COLOUR(colour);
+	int visible = (screen.width - x < l->width) ? screen.width - x : l->width;
+	char *row = screen.base + y * screen.pitch + x * sizeof(pixel_value);
+	
+	for (int r = 0; r < FONT_SIZE * l->scale && y + r < screen.height; r++, row += screen.pitch){
+		const unsigned int *bits = l->bits[r / l->scale];
+		pixel_value *p = (pixel_value *) row;
+		for (int w = 0; w * 32 < visible; w++){
+			unsigned int word = bits[w];
+			while (word != 0){
+				int start = __builtin_ctz(word);
+				unsigned int gaps = ~(word >> start);
+				int run = (gaps == 0) ? 32 : __builtin_ctz(gaps);
+				int pixel = w * 32 + start;
+				if (pixel + run > visible){
+					run = visible - pixel;
+					if (run <= 0){
+						break;
+					}
+				}
+				fill_span(p + pixel, run, value);
+				word = (start + run >= 32) ? 0 : word & (~0u << (start + run));
+			}
+		}
+	}
+}
+
+// Shows how the game ended in large letters above the board, red for a win
+// as the stroke over the line, or clears the strip (winner 0)
+void draw_result_banner(int winner){
+	int height = FONT_SIZE * BANNER_SCALE, y = (BOARD_MARGIN - height) / 2;
+	
+	fill_rect(0, y, screen.width, height, 0x0000);
+	if (winner == 0){
+		return;
+	}
+	const char *text = (winner == 1) ? "X wins!" : (winner == 2) ? "O wins!" : "Tie game";
+	draw_text((screen.width - text_width(text, BANNER_SCALE)) / 2, y, text, BANNER_SCALE, (winner == 3) ? 0xFFFF : 0xF800);
+}
+
+// Clear screen by writing black into the address
+void clear_screen (){
+	fill_rect(0, 0, screen.width, screen.height, 0x0000);
+}
+
+// Clear any text on the screen by writing " " into the address
+void clear_text (){
+	int y,x;
+	for(x=0;x<80;x++){
+		for(y=0;y<60;y++){
+			char clear[1] = " \0";
+			write_text(x, y, clear);
+		}
+	}
+}
+
+// Function which handles what to do once a keyboard interrupt is given
+void keyboard_ISR(void) {
+
+	volatile int * PS2_ptr = (int *)0xFF200100; // Points to PS2 Base
+    
+	int PS2_data = *(PS2_ptr);
+	int RVALID = PS2_data & 0x8000;
+	
+	//Read Interrupt Register
+	int readInterruptReg;
+	readInterruptReg = *(PS2_ptr + 1 ); 
+	  
+	//Clear Interrupt 
+	*(PS2_ptr+1) = readInterruptReg; 
+
+	// when RVALID is 1, there is data 
+	if (RVALID != 0){
+		keyboard_byte(PS2_data & 0xFF); //data in LSB
+	}
+	return;
+}
+
+// Passes on make codes only. Releasing a key sends 0xF0 and then its
+// scancode again, which must not act a second time.
+void keyboard_byte(unsigned char byte) {
+	if (byte == 0xF0){
+		break_pending = true;
+	} else if (break_pending){
+		break_pending = false;
+	} else {
+		handle_key(byte);
+	}
+}
+
+// Does what a key's make code asks for. Keys from the PS/2 keyboard and
+// commands from the console both come through here.
+void handle_key(unsigned char byte0) {
+	// Only [H] and [Esc] work while the help screen is up, so nothing
+	// draws over it
+	if (help_showing && byte0 != 0x33 && byte0 != 0x76){
+		return;
+	}
+	// The main loop does all the drawing during an exhibition, [G] ends it.
+	// One that the main loop has yet to start counts as running, so a second [G]
+	// cancels it rather than asking for it again.
+	if (exhibition_total > 0 || exhibition_request > 0){
+		if (byte0 == 0x34){
+			exhibition_request = 0; // stop
+		}
+		return;
+	}
+	unsigned int start = read_timer();
+	if (qubic_showing){
+		qubic_key(byte0);
+		hud_key_done(start);
+		return;
+	}
+	if (ultimate_showing){
+		ultimate_key(byte0);
+		hud_key_done(start);
+		return;
+	}
+
+	if(byte0 == 0x22){  //X, start game
+		game_view_changed();
+		clear_screen();
+		clear_text();
+		draw_board();
+		draw_selection_box(selection_cell, 0xF800);
+		isStalemate = false;
+		char player_status[150] = "                    Player X's Turn!                      \0";
+		write_text(14, 55, player_status);
+	}
+	
+	if(byte0 == 0x1D){  //UP, W
+		game_view_changed();
+		// Erase currently drawn selection box by drawing it black
+		draw_selection_box(selection_cell, 0x0000);
+		draw_board();
+		
+		// Neighbouring box, looping back round at the edge
+		selection_cell = game_layout.neighbour[selection_cell][MOVE_UP];
+		
+		draw_selection_box(selection_cell, 0xF800);
+	}
+
+	if(byte0 == 0x1B){ //DOWN, S
+		game_view_changed();
+		// Erase currently drawn selection box by drawing it black
+		draw_selection_box(selection_cell, 0x0000);
+		draw_board();
+		
+		// Neighbouring box, looping back round at the edge
+		selection_cell = game_layout.neighbour[selection_cell][MOVE_DOWN];
+		
+		draw_selection_box(selection_cell, 0xF800);
+	}
+
+	if(byte0 == 0x1C){ //LEFT, A
+		game_view_changed();
+		// Erase currently drawn selection box by drawing it black
+		draw_selection_box(selection_cell, 0x0000);
+		draw_board();
+		
+		// Neighbouring box, looping back round at the edge
+		selection_cell = game_layout.neighbour[selection_cell][MOVE_LEFT];
+		
+		draw_selection_box(selection_cell, 0xF800);
+	}
+
+	if(byte0 == 0x23){ //RIGHT, D
+		game_view_changed();
+		// Erase currently drawn selection box by drawing it black
+		draw_selection_box(selection_cell, 0x0000);
+		draw_board();
+		
+		// Neighbouring box, looping back round at the edge
+		selection_cell = game_layout.neighbour[selection_cell][MOVE_RIGHT];
+		
+		draw_selection_box(selection_cell, 0xF800);
+	}
+
+	if(byte0 == 0x29){  //SpaceBar , Restart Game
+		game_view_changed();
+		clear_screen(0,0,0x0000); 
+		clear_text();
+		draw_board();
+		
+		Turn = 'X';
+		memset(board, 0, sizeof(board));
+		engine_init(&game_position, GAME_ROWS, GAME_COLS, GAME_K);
+		start_game_record(); // keeps the game that was just played
+		
+		char clear_winner_status[150] = "                                                     \0";                             
+		write_text(14, 55, clear_winner_status);
+		
+		// Reinitialize selection box to the top left box
+		selection_cell = 0;
+		draw_selection_box(selection_cell, 0xF800);
+		
+		char player_status[150] = "                    Player X's Turn!                      \0";
+		write_text(14, 55, player_status);
+		isStalemate = false;
+
+	}  
+	
+	if(number_key_cell[byte0] != 0){ //Select Box 1-9
+		game_view_changed();
+		draw_selection_box(selection_cell, 0x0000);
+		draw_board();
+		
+		selection_cell = number_key_cell[byte0] - 1;
+		
+		draw_selection_box(selection_cell, 0xF800);
+	}
+	
+	if(byte0 == 0x33){//H-Help Screen
+		show_help();
+	}
+	
+	if(byte0 == 0x76){ //Escape - Resume game
+		hide_help();
+	}
+
+	if (byte0 == 0x4D) { //P - switch the strategy used by [C]
+		game_view_changed();
+		if (ai_strategy == AI_STRATEGY_SEARCH){
+			ai_strategy = AI_STRATEGY_PROOF;
+			char strategy_status[30] = "AI: win solver\0";
+			write_text(50, 57, strategy_status);
+		} else {
+			ai_strategy = AI_STRATEGY_SEARCH;
+			char strategy_status[30] = "AI: search    \0";
+			write_text(50, 57, strategy_status);
+		}
+	}
+
+	if (byte0 == 0x34) { //G - exhibition, many boards against the AI
+		exhibition_request = EXHIBITION_BOARDS; // start
+	}
+
+	if (byte0 == 0x2A) { //V - ultimate tic-tac-toe against the AI
+		ultimate_toggle();
+	}
+
+	if (byte0 == 0x15) { //Q - Qubic, 4x4x4 against the AI
+		qubic_toggle();
+	}
+
+	if (byte0 == 0x24) { //E - show the AI's value of every empty cell
+		analysis_toggle();
+	}
+
+	if (byte0 == 0x2B) { //F - cycle the performance HUD
+		hud_toggle();
+	}
+
+	if (byte0 == 0x21) { //C - AI makes a move if this is clicked
+		game_view_changed();
+		AI_move();
+	}
+	
+	if (byte0 == 0x3C) { //U - take back the last move
+		game_view_changed();
+		undo_move();
+	}
+	
+	if (byte0 == 0x2D) { //R - play the last move taken back again
+		game_view_changed();
+		redo_move();
+	}
+	
+	if(byte0 == 0x5A){ //Enter - place piece on board
+		game_view_changed();
+		
+		// Only draw if box is empty
+		if (board[selection_cell] == 0){
+			// 0 means empty, 1 means there is an X, 2 means there is an O
+			engine_play(&game_position, selection_cell, (Turn == 'X') ? 1 : 2);
+			finish_move(selection_cell);
+		}
+	}
+	
+	analysis_update();
+	hud_key_done(start);
+}
+
+void draw_line(int x0, int y0, int x1, int y1, short int line_color) {
+    bool is_steep = ( abs(y1 - y0) > abs(x1 - x0) );
+	
+    if (is_steep) {
+        swap(&x0, &y0);
+        swap(&x1, &y1);
+    }
+   
+    if (x0 > x1) {
+        swap(&x0, &x1);
+        swap(&y0, &y1);
+    }
+    
+    int delta_x = x1 - x0;
+    int delta_y = abs(y1 - y0);
+    int error = -(delta_x / 2);
+    
+    int y = y0;
+    int y_step;
+    if (y0 < y1) 
+        y_step =1;
+    else 
+        y_step = -1;
+    
+    for(int x = x0; x <= x1; x++) {
+        if (is_steep) 
+            plot_pixel(y, x, line_color);
+        else 
+            plot_pixel(x, y, line_color);
+        
+        error += delta_y;
+        
+        if (error >= 0) {
+            y +=y_step;
+            error -= delta_x;
+        }
+    } 
+}
+
+void swap(int *first, int *second){
+	int temp = *first;
+    *first = *second;
+    *second = temp;   
+}
+
+void draw_board(void){
+	for (int i = 0; i < game_layout.grid_total; i++){
+		segment *g = &game_layout.grid[i];
+		draw_thick_segment(g->x0, g->y0, g->x1, g->y1, 0XFFFF);
+	}
+	
+	char text_top_row[100] = "Welcome to Tic-Tac-Toe!\0";
+	write_text(28, 3, text_top_row);
+	
+	// Box numbers, or their values while the analysis overlay is on
+	for (int cell = 0; cell < game_layout.cells; cell++){
+		write_text(game_layout.label_x[cell], game_layout.label_y[cell], analysis_showing ? analysis_label[cell] : game_layout.label[cell]);
+	}
+	
+	char winner_status[50] = "Press [H] for help screen.";
+	write_text(5, 57, winner_status);
+}
+
+void write_text(int x, int y, char * text_ptr) {
+	int offset;
+#ifdef HOST_BUILD
+	char * character_buffer = &host_character_buffer[0][0];
+#else
+	volatile char * character_buffer = (char *)0xC9000000; // video character buffer
+#endif
+	
+	/* assume that the text string fits on one line */
+	offset = (y << 7) + x;
+	
+	while (*(text_ptr)) {
+		*(character_buffer + offset) = *(text_ptr); // write to the character buffer
+		++text_ptr;
+		++offset;
+	}
+}
+
+
+// Points the snapshots at their memory: SDRAM on the board, the heap on the
+// host
+void snapshot_init(void){
+	size_t pixel_bytes = (size_t) screen.pitch * screen.height;
+#ifdef HOST_BUILD
+	game_snapshot.pixels = malloc(pixel_bytes + CHARACTER_BUFFER_BYTES);
+	help_snapshot.pixels = malloc(pixel_bytes + CHARACTER_BUFFER_BYTES);
+#else
+	game_snapshot.pixels = (char *) SCREEN_CACHE_BASE;
+	help_snapshot.pixels = (char *) SCREEN_CACHE_BASE + SCREEN_CACHE_SLOT;
+#endif
+	game_snapshot.text = game_snapshot.pixels + pixel_bytes;
+	help_snapshot.text = help_snapshot.pixels + pixel_bytes;
+	game_snapshot.valid = false;
+	help_snapshot.valid = false;
+}
+
+static char *character_buffer_start(void){
+#ifdef HOST_BUILD
+	return &host_character_buffer[0][0];
+#else
+	return (char *) 0xC9000000;
+#endif
+}
+
+static void snapshot_save(screen_snapshot *snapshot){
+	memcpy(snapshot->pixels, screen.base, (size_t) screen.pitch * screen.height);
+	memcpy(snapshot->text, character_buffer_start(), CHARACTER_BUFFER_BYTES);
+	snapshot->valid = true;
+}
+
+static void snapshot_restore(screen_snapshot *snapshot){
+	memcpy(screen.base, snapshot->pixels, (size_t) screen.pitch * screen.height);
+	memcpy(character_buffer_start(), snapshot->text, CHARACTER_BUFFER_BYTES);
+}
+
+static void toggle_measured(toggle_stats *stats, unsigned int start){
+	stats->last_ticks = start - read_timer();
+	stats->total_ticks += stats->last_ticks;
+	stats->count++;
+	if (stats->last_ticks > stats->max_ticks){
+		stats->max_ticks = stats->last_ticks;
+	}
+}
+
+// Called whenever something on the game screen changes, so the next [H]
+// takes a fresh copy of it
+void game_view_changed(void){
+	game_snapshot.valid = false;
+}
+
+void draw_help_screen(void){
+	clear_screen();			
+	clear_text();
+	
+	char title[100] = "Tic-Tac-Toe Help Screen\0";
+	write_text(28, 3, title);
+	
+	char instructions[100] = "Try to get 3 consecutive boxes to win the game!\0";
+	write_text(8, 7, instructions);
+	
+	char controls[20] = "Game Controls: \0";
+	write_text(8, 10, controls);
+	
+	char number_keys[70] = "[1]-[9]: Select board index\0";
+	write_text(8, 13, number_keys);
+	
+	char selection_key_a[70] = "[A]: Move red selection box left\0";
+	write_text(8, 15, selection_key_a);
+	
+	char selection_key_d[70] = "[D]: Move red selection box right\0";
+	write_text(8, 17, selection_key_d);
+	
+	char selection_key_w[70] = "[W]: Move red selection box up\0";
+	write_text(8, 19, selection_key_w);
+	
+	char selection_key_s[70] = "[S]: Move red selection box down\0";
+	write_text(8, 21, selection_key_s);	
+	
+	char enter[70] = "[enter]: Place piece/ Make a move\0";
+	write_text(8, 23, enter);
+	
+	char help[70] = "[H]: Help screen\0";
+	write_text(8, 25, help);
+
+	char AI[70] = "[C]: Computer makes a move\0";
+	write_text(8, 27, AI);
+	
+	char strategy[70] = "[P]: Switch AI between search and win solver\0";
+	write_text(8, 29, strategy);
+	
+	char undo[70] = "[U]/[R]: Undo/redo a move\0";
+	write_text(8, 31, undo);
+	
+	char spacebar[70] = "[spacebar]: Restart game\0";
+	write_text(8, 33, spacebar);	
+	
+	char perf[70] = "[F]: Performance display on HEX, on screen, off\0";
+	write_text(8, 35, perf);
+	
+	char values[70] = "[E]: Show the AI's value of every empty cell\0";
+	write_text(8, 37, values);
+	
+	char exhibition[70] = "[G]: Exhibition, nine boards against the AI\0";
+	write_text(8, 39, exhibition);
+	
+	char ultimate[70] = "[V]: Ultimate tic-tac-toe against the AI, [V] again to leave\0";
+	write_text(8, 41, ultimate);
+	
+	char qubic[70] = "[Q]: Qubic, four in a row on a 4x4x4 cube, [Q] again to leave\0";
+	write_text(8, 43, qubic);
+	
+	char resume[70] = "Press [ESC] to resume the game\0";
+	write_text(8, 45, resume);	
+}
+
+// Draws the game screen from scratch, used when there is no snapshot of it
+void draw_game_view(void){
+	clear_screen();
+	clear_text();
+	draw_board();
+	draw_selection_box(selection_cell, 0xF800);
+	
+	for (int i = 0; i < GAME_CELLS; i++){
+		if (board[i] == 1){
+			draw_player_X(i+1);
+		} else if (board[i] == 2){
+			draw_player_O(i+1);
+		}
+	}
+	
+	if (Turn == 'X'){
+		char player_status[150] = "                    Player X's Turn!                      \0";
+		write_text(14, 55, player_status);
+	} else {
+		char player_status[150] = "                    Player O's Turn!                      \0";
+		write_text(14, 55, player_status);
+	}
+	
+	// The winning stroke and the banner of a finished game
+	int winner = check_winner();
+	if (winner != 0){
+		draw_result_banner(winner);
+	}
+}
+
+// Copies the game screen away unless the copy is still current, then puts up
+// the help screen, drawing it only the first time
+void show_help(void){
+	if (help_showing){
+		return;
+	}
+	unsigned int start = read_timer();
+	
+	if (!game_snapshot.valid){
+		snapshot_save(&game_snapshot);
+	}
+	if (help_snapshot.valid){
+		snapshot_restore(&help_snapshot);
+	} else {
+		draw_help_screen();
+		snapshot_save(&help_snapshot);
+	}
+	stack_report(irq_report(IRQ_REPORT_ROW) + 1); // counts change, so never part of the snapshot
+	help_showing = true;
+	toggle_measured(&help_open_stats, start);
+}
+
+// Puts the game screen back as it was when [H] was pressed
+void hide_help(void){
+	if (!help_showing){
+		return;
+	}
+	unsigned int start = read_timer();
+	
+	if (game_snapshot.valid){
+		snapshot_restore(&game_snapshot);
+	} else {
+		draw_game_view();
+	}
+	help_showing = false;
+	toggle_measured(&help_close_stats, start);
+}
+
+void draw_selection_box(int cell, short int selection_colour) {
+	draw_layout_box(&game_layout, cell, selection_colour);
+}
+
+// Outlines a cell of a board laid out by l
+void draw_layout_box(const board_layout *l, int cell, short int colour){
+	int x = l->cell_x[cell], y = l->cell_y[cell];
+	int width = l->cell_width, height = l->cell_height;
+	
+	draw_line(x, y, x + width, y, colour);
+	draw_line(x + width, y, x + width, y + height, colour);
+	draw_line(x + width, y + height, x, y + height, colour);
+	draw_line(x, y + height, x, y, colour);
+}
+
+// Draws a line 3 pixels wide. Strokes are widened sideways, diagonals along
+// both axes.
+void draw_thick_segment(int x0, int y0, int x1, int y1, short int line_color) {
+	int dx = (x0 == x1) ? 1 : (y0 == y1 ? 0 : 1);
+	int dy = (y0 == y1) ? 1 : (x0 == x1 ? 0 : 1);
+	
+	for (int i = -1; i <= 1; i++){
+		draw_line(x0 + i * dx, y0 + i * dy, x1 + i * dx, y1 + i * dy, line_color);
+	}
+}
+
+void draw_player(int boardIndex){
+	if(Turn == 'X'){
+		draw_player_X(boardIndex);
+	} else {
+		draw_player_O(boardIndex);
+	}
+}
+
+void draw_player_X(int boardIndex){
+	draw_mark(&game_layout, 0, 0, boardIndex - 1, 1);
+}
+	
+void draw_player_O(int boardIndex){
+	draw_mark(&game_layout, 0, 0, boardIndex - 1, 2);
+}
+
+// Draws player's mark in a cell of a board laid out by l, moved x, y from
+// where the layout puts it
+void draw_mark(const board_layout *l, int x, int y, int cell, int player){
+	const segment *marks = (player == 1) ? l->x_mark : l->o_mark;
+	int count = (player == 1) ? 2 : 8;
+	
+	x += l->cell_x[cell];
+	y += l->cell_y[cell];
+	for (int i = 0; i < count; i++){
+		const segment *m = &marks[i];
+		draw_line(x + m->x0, y + m->y0, x + m->x1, y + m->y1, 0xFFFF);
+	}
+}
+
+// Shows the compiled in splash screen, centred, if there is one that fits
+// and the welcome screen drawn from lines otherwise
+void initial_screen(){
+#ifdef SPLASH_HEADER
+	if (SPLASH_WIDTH <= screen.width && SPLASH_HEIGHT <= screen.height){
+		if (SPLASH_WIDTH < screen.width || SPLASH_HEIGHT < screen.height){
+			clear_screen();
+		}
+		draw_rle_image(splash_rle, SPLASH_WIDTH, SPLASH_HEIGHT, (screen.width - SPLASH_WIDTH) / 2, (screen.height - SPLASH_HEIGHT) / 2);
+	} else {
+		draw_welcome_art();
+	}
+#else
+	draw_welcome_art();
+#endif
+	
+	char developers[150] = "By Bikramjit Narwal & Nurin Fazil\0";
+	write_text(25, 53, developers);
+}
+
+void draw_welcome_art(void){
+	int offset = 20, offset2 = 15;
+	
+	fill_rect(0, 0, screen.width, screen.height, 0x00FF);
+
+	// W
+	draw_line(80, 40, 85, 70, 0xFFFF);
+	draw_line(85, 70, 90, 55, 0xFFFF);
+	draw_line(90, 55, 95, 70, 0xFFFF);
+	draw_line(95, 70, 100, 40, 0xFFFF);
+	
+	// E
+	draw_line(103, 40, 103, 70, 0xFFFF);
+	draw_line(103, 40, 115, 40, 0xFFFF);
+	draw_line(103, 70, 115, 70, 0xFFFF);
+	draw_line(103, 55, 110, 55, 0xFFFF);
+	
+	// L 
+	draw_line(118, 40, 118, 70, 0xFFFF);
+	draw_line(118, 70, 130, 70, 0xFFFF);
+
+	// C
+	draw_line(133, 40, 133, 70, 0xFFFF);
+	draw_line(133, 40, 145, 40, 0xFFFF);
+	draw_line(133, 70, 145, 70, 0xFFFF);
+
+	// O
+	draw_line(148, 40, 160, 40, 0xFFFF);
+	draw_line(148, 70, 160, 70, 0xFFFF);
+	draw_line(148, 40, 148, 70, 0xFFFF);
+	draw_line(160, 40, 160, 70, 0xFFFF);
+	
+	// M
+	draw_line(163, 40, 163, 70, 0xFFFF);
+	draw_line(163, 40, 170, 50, 0xFFFF);
+	draw_line(170, 50, 177, 40, 0xFFFF);
+	draw_line(177, 40, 177, 70, 0xFFFF);
+
+	// E
+	draw_line(180, 40, 180, 70, 0xFFFF);
+	draw_line(180, 40, 192, 40, 0xFFFF);
+	draw_line(180, 70, 192, 70, 0xFFFF);
+	draw_line(180, 55, 187, 55, 0xFFFF);
+	
+	// T
+	draw_line(204, 40, 220, 40, 0xFFFF);
+	draw_line(212, 40, 212, 70, 0xFFFF);
+	
+	// O
+	draw_line(224, 40, 236, 40, 0xFFFF);
+	draw_line(224, 70, 236, 70, 0xFFFF);
+	draw_line(224, 40, 224, 70, 0xFFFF);
+	draw_line(236, 40, 236, 70, 0xFFFF);
+	
+	// T
+	draw_line(42 + offset, 90, 57 + offset, 90, 0xFFFF);
+	draw_line(50 + offset, 90, 50 + offset, 120, 0xFFFF);
+	
+	// I 
+	draw_line(60 + offset, 90, 74 + offset, 90, 0xFFFF);
+	draw_line(60 + offset, 120, 74 + offset, 120, 0xFFFF);
+	draw_line(67 + offset, 90, 67 + offset, 120, 0xFFFF);
+
+	// C
+	draw_line(77 + offset, 90, 77 + offset, 120, 0xFFFF);
+	draw_line(77 + offset, 90, 89 + offset, 90, 0xFFFF);
+	draw_line(77 + offset, 120, 89 + offset, 120, 0xFFFF);
+
+	// - 
+	draw_line(100 + offset, 105, 111 + offset, 105, 0xFFFF);
+	
+	// T
+	draw_line(117 + offset, 90, 131 + offset, 90, 0xFFFF);
+	draw_line(124 + offset, 90, 124 + offset, 120, 0xFFFF);
+	
+	// A
+	draw_line(134 + offset, 90, 146 + offset, 90, 0xFFFF);
+	draw_line(134 + offset, 105, 146 + offset, 105, 0xFFFF);
+	draw_line(134 + offset, 90, 134 + offset, 120, 0xFFFF);
+	draw_line(146 + offset, 90, 146 + offset, 120, 0xFFFF);
+	
+	// C
+	draw_line(149 + offset, 90, 149 + offset, 120, 0xFFFF);
+	draw_line(149 + offset, 90, 161 + offset, 90, 0xFFFF);
+	draw_line(149 + offset, 120, 161 + offset, 120, 0xFFFF);
+	
+	// - 
+	draw_line(166 + offset, 105, 177 + offset, 105, 0xFFFF);
+		
+	// T
+	draw_line(183 + offset, 90, 197 + offset, 90, 0xFFFF);
+	draw_line(190 + offset, 90, 190 + offset, 120, 0xFFFF);
+		
+	// O
+	draw_line(200 + offset, 90, 212 + offset, 90, 0xFFFF);
+	draw_line(200 + offset, 120, 212 + offset, 120, 0xFFFF);
+	draw_line(200 + offset, 90, 200 + offset, 120, 0xFFFF);
+	draw_line(212 + offset, 90, 212 + offset, 120, 0xFFFF);
+		
+	// E
+	draw_line(215 + offset, 90, 215 + offset, 120, 0xFFFF);
+	draw_line(215 + offset, 90, 227 + offset, 90, 0xFFFF);
+	draw_line(215 + offset, 120, 227 + offset, 120, 0xFFFF);
+	draw_line(215 + offset, 105, 221 + offset, 105, 0xFFFF);
+	
+	// P
+	draw_line(20 + offset2, 160, 35 + offset2, 160, 0xFFFF); 
+	draw_line(20 + offset2, 160, 20 + offset2, 190, 0xFFFF); 
+	draw_line(20 + offset2, 173, 35 + offset2, 173, 0xFFFF); 
+	draw_line(35 + offset2, 160, 35 + offset2, 173, 0xFFFF); 
+	
+	// R
+	draw_line(38 + offset2, 160, 53 + offset2, 160, 0xFFFF); 
+	draw_line(38 + offset2, 160, 38 + offset2, 190, 0xFFFF); 
+	draw_line(38 + offset2, 173, 53 + offset2, 173, 0xFFFF); 
+	draw_line(53 + offset2, 160, 53 + offset2, 173, 0xFFFF); 
+	draw_line(38 + offset2, 173, 53 + offset2, 190, 0xFFFF); 
+	
+	// E
+	draw_line(56 + offset2, 160, 56 + offset2, 190, 0xFFFF);
+	draw_line(56 + offset2, 160, 68 + offset2, 160, 0xFFFF);
+	draw_line(56 + offset2, 190, 68 + offset2, 190, 0xFFFF);
+	draw_line(56 + offset2, 175, 62 + offset2, 175, 0xFFFF);
+	
+	// S
+	draw_line(71 + offset2, 160, 83 + offset2, 160, 0xFFFF);
+	draw_line(71 + offset2, 190, 83 + offset2, 190, 0xFFFF);
+	draw_line(71 + offset2, 160, 71 + offset2, 175, 0xFFFF);
+	draw_line(71 + offset2, 175, 83 + offset2, 175, 0xFFFF);
+	draw_line(83 + offset2, 175, 83 + offset2, 190, 0xFFFF);
+	
+	// S
+	draw_line(86 + offset2, 160, 98 + offset2, 160, 0xFFFF);
+	draw_line(86 + offset2, 190, 98 + offset2, 190, 0xFFFF);
+	draw_line(86 + offset2, 160, 86 + offset2, 175, 0xFFFF);
+	draw_line(86 + offset2, 175, 98 + offset2, 175, 0xFFFF);
+	draw_line(98 + offset2, 175, 98 + offset2, 190, 0xFFFF);
+	
+	// [X]
+	draw_line(111 + offset2, 158, 120 + offset2, 158, 0xFFFF); 
+	draw_line(111 + offset2, 158, 111 + offset2, 192, 0xFFFF);
+	draw_line(111 + offset2, 192, 120 + offset2, 192, 0xFFFF); 
+	
+	draw_line(123 + offset2, 163, 135 + offset2, 187, 0xFFFF);
+	draw_line(135 + offset2, 163, 123 + offset2, 187, 0xFFFF);
+	
+	draw_line(138 + offset2, 158, 147 + offset2, 158, 0xFFFF);
+	draw_line(138 + offset2, 192, 147 + offset2, 192, 0xFFFF);
+	draw_line(147 + offset2, 158, 147 + offset2, 192, 0xFFFF);
+
+	// T
+	draw_line(157 + offset2, 160, 172 + offset2, 160, 0xFFFF);
+	draw_line(164 + offset2, 160, 164 + offset2, 190, 0xFFFF);
+	
+	// O 
+	draw_line(175 + offset2, 160, 187 + offset2, 160, 0xFFFF);
+	draw_line(175 + offset2, 190, 187 + offset2, 190, 0xFFFF);
+	draw_line(175 + offset2, 160, 175 + offset2, 190, 0xFFFF);
+	draw_line(187 + offset2, 160, 187 + offset2, 190, 0xFFFF);
+	
+	// P
+	draw_line(200 + offset2, 160, 215 + offset2, 160, 0xFFFF); 
+	draw_line(200 + offset2, 160, 200 + offset2, 190, 0xFFFF); 
+	draw_line(200 + offset2, 173, 215 + offset2, 173, 0xFFFF); 
+	draw_line(215 + offset2, 160, 215 + offset2, 173, 0xFFFF); 
+	
+	// L
+	draw_line(218 + offset2, 160, 218 + offset2, 190, 0xFFFF);
+	draw_line(218 + offset2, 190, 230 + offset2, 190, 0xFFFF);
+	
+	// A
+	draw_line(233 + offset2, 160, 245 + offset2, 160, 0xFFFF);
+	draw_line(233 + offset2, 175, 245 + offset2, 175, 0xFFFF);
+	draw_line(233 + offset2, 160, 233 + offset2, 190, 0xFFFF);
+	draw_line(245 + offset2, 160, 245 + offset2, 190, 0xFFFF);
+	
+	// Y 
+	draw_line(248 + offset2, 160, 255 + offset2, 175, 0xFFFF);
+	draw_line(261 + offset2, 160, 255 + offset2, 175, 0xFFFF);
+	draw_line(255 + offset2, 175, 255 + offset2, 190, 0xFFFF);
+}
+
+// Functions checks every possibly win (3 in a row) for either player and returns the winner
+int check_winner(){
+	// A red stroke over a completed row, column or diagonal
+	int line = winning_line();
+	if (line >= 0){
+		segment *w = &game_layout.win_line[line];
+		draw_thick_segment(w->x0, w->y0, w->x1, w->y1, 0xF800);
+		return board[game_layout.line_cell[line][0]];
+	}
+	
+	checkforStalemate();
+	if (isStalemate){
+		return 3;
+	}
+	
+	return 0;
+}
+
+// Lays out a rows x cols board filling the given screen rectangle: the cell
+// rectangles, grid strokes, X and O shapes, cell numbers and the stroke over
+// every k in a row. The 3x3 board on the 320x240 screen gets 90x63 cells,
+// on 640x480 it gets 196x143.
+void layout_init(board_layout *l, int rows, int cols, int k, int left, int top, int width, int height){
+	int dir_row[4] = {0, 1, 1, 1};
+	int dir_col[4] = {1, 0, 1, -1};
+	int w = width / cols, h = height / rows;
+	
+	l->rows = rows;
+	l->cols = cols;
+	l->k = k;
+	l->cells = rows * cols;
+	l->left = left;
+	l->top = top;
+	l->cell_width = w;
+	l->cell_height = h;
+	
+	for (int cell = 0; cell < l->cells; cell++){
+		int row = cell / cols, col = cell % cols;
+		l->cell_x[cell] = left + col * w;
+		l->cell_y[cell] = top + row * h;
+		l->neighbour[cell][MOVE_UP] = ((row + rows - 1) % rows) * cols + col;
+		l->neighbour[cell][MOVE_DOWN] = ((row + 1) % rows) * cols + col;
+		l->neighbour[cell][MOVE_LEFT] = row * cols + (col + cols - 1) % cols;
+		l->neighbour[cell][MOVE_RIGHT] = row * cols + (col + 1) % cols;
+		
+		// Character buffer positions, a little in from the cell's corner
+		l->label_x[cell] = (l->cell_x[cell] + 2 * screen.char_width) / screen.char_width;
+		l->label_y[cell] = (l->cell_y[cell] + 3 * screen.char_height / 2) / screen.char_height;
+		sprintf(l->label[cell], "%d", cell + 1);
+	}
+	
+	// Inner grid lines only
+	l->grid_total = 0;
+	for (int col = 1; col < cols; col++){
+		l->grid[l->grid_total++] = (segment) {left + col * w, top, left + col * w, top + rows * h};
+	}
+	for (int row = 1; row < rows; row++){
+		l->grid[l->grid_total++] = (segment) {left, top + row * h, left + cols * w, top + row * h};
+	}
+	
+	// Insets scale with the cell, in proportion to the original 90x63 one
+	int x_inset = w * 4 / 90, y_inset = h * 4 / 63;
+	l->x_mark[0] = (segment) {x_inset, y_inset, w - x_inset, h - y_inset};
+	l->x_mark[1] = (segment) {w - x_inset, y_inset, x_inset, h - y_inset};
+	
+	int near_x = w * 5 / 90, far_x = w * 17 / 90, near_y = h * 2 / 63, far_y = h * 6 / 63;
+	l->o_mark[0] = (segment) {w - far_x, near_y, far_x, near_y};
+	l->o_mark[1] = (segment) {far_x, near_y, near_x, far_y};
+	l->o_mark[2] = (segment) {near_x, far_y, near_x, h - far_y};
+	l->o_mark[3] = (segment) {near_x, h - far_y, far_x, h - near_y};
+	l->o_mark[4] = (segment) {far_x, h - near_y, w - far_x, h - near_y};
+	l->o_mark[5] = (segment) {w - far_x, h - near_y, w - near_x, h - far_y};
+	l->o_mark[6] = (segment) {w - near_x, h - far_y, w - near_x, far_y};
+	l->o_mark[7] = (segment) {w - near_x, far_y, w - far_x, near_y};
+	
+	// Every k in a row, with a stroke from the outer edge of its first cell
+	// to the outer edge of its last, through the cell centres
+	l->line_total = 0;
+	for (int d = 0; d < 4; d++){
+		for (int row = 0; row < rows; row++){
+			for (int col = 0; col < cols; col++){
+				int end_row = row + (k - 1) * dir_row[d];
+				int end_col = col + (k - 1) * dir_col[d];
+				if (end_row >= rows || end_col < 0 || end_col >= cols){
+					continue;
+				}
+				
+				for (int i = 0; i < k; i++){
+					l->line_cell[l->line_total][i] = (row + i * dir_row[d]) * cols + col + i * dir_col[d];
+				}
+				int first = row * cols + col, last = end_row * cols + end_col;
+				int x0 = (dir_col[d] > 0) ? l->cell_x[first] : (dir_col[d] < 0 ? l->cell_x[first] + w : l->cell_x[first] + w / 2);
+				int x1 = (dir_col[d] > 0) ? l->cell_x[last] + w : (dir_col[d] < 0 ? l->cell_x[last] : l->cell_x[last] + w / 2);
+				int y0 = (dir_row[d] > 0) ? l->cell_y[first] : l->cell_y[first] + h / 2;
+				int y1 = (dir_row[d] > 0) ? l->cell_y[last] + h : l->cell_y[last] + h / 2;
+				l->win_line[l->line_total++] = (segment) {x0, y0, x1, y1};
+			}
+		}
+	}
+}
+
+// Returns the first row, column or diagonal one player has completed, or -1
+int winning_line(void){
+	for (int line = 0; line < game_layout.line_total; line++){
+		unsigned char *cells = game_layout.line_cell[line];
+		int player = board[cells[0]];
+		int i = 1;
+		while (player != 0 && i < game_layout.k && board[cells[i]] == player){
+			i++;
+		}
+		if (player != 0 && i == game_layout.k){
+			return line;
+		}
+	}
+	return -1;
+}
+
+// Draws the move just played on game_position, logs it and shows whose turn
+// it is or how the game ended
+void finish_move(int cell){
+	board[cell] = game_position.cell[cell];
+	if (board[cell] == 1){
+		draw_player_X(cell + 1);
+	} else {
+		draw_player_O(cell + 1);
+	}
+	record_move(cell);
+	
+	// check winner
+	int winner = check_winner();
+	record_result(winner);
+	audio_play((winner == 0) ? AUDIO_CLICK : (winner == 3 ? AUDIO_TIE : AUDIO_WIN));
+	
+	// No winner
+	if (winner == 0){
+		// Switch turn 
+		if (Turn == 'X'){
+			Turn = 'O';
+			char player_status[150] = "                    Player O's Turn!                      \0";
+			write_text(14, 55, player_status);
+		} else {
+			Turn = 'X';
+			char player_status[150] = "                    Player X's Turn!                      \0";
+			write_text(14, 55, player_status);
+		}
+		
+	// X wins
+	} else if (winner == 1){
+		// hide selection box
+		draw_selection_box(selection_cell, 0x0000);
+		draw_board();
+		
+		// show winner status & prompt new game
+		char winner_status[150] = "Player X Wins! Press [spacebar] to start a new game.\0";
+		write_text(14, 55, winner_status);
+		
+	// O wins
+	} else if (winner == 2){
+		// hide selection box
+		draw_selection_box(selection_cell, 0x0000);
+		draw_board();
+		
+		// show winner status & prompt new game
+		char winner_status[150] = "Player O Wins! Press [spacebar] to start a new game.\0";
+		write_text(14, 55, winner_status);
+	
+	// Stalemate
+	} else if (winner == 3){
+		// hide selection box
+		draw_selection_box(selection_cell, 0x0000);
+		draw_board();
+		
+		// show tie status & prompt new game
+		char winner_status[150] = "It's a tie! Press [spacebar] to start a new game.\0";
+		write_text(14, 55, winner_status);
+	}
+	if (winner != 0){
+		draw_result_banner(winner);
+	}
+}
+
+// Takes back the last move. Only its cell is repainted, and if the move won
+// the game the red stroke is painted out and the grid and marks it crossed
+// are drawn again.
+void undo_move(void){
+	int line = winning_line();
+	int cell = engine_undo_last(&game_position);
+	if (cell < 0){
+		return;
+	}
+	board[cell] = 0;
+	unrecord_move();
+	isStalemate = false;
+	draw_result_banner(0);
+	
+	// Inside the cell, clear of the grid strokes and the selection box
+	int x = game_layout.cell_x[cell], y = game_layout.cell_y[cell];
+	fill_rect(x + 2, y + 2, game_layout.cell_width - 3, game_layout.cell_height - 3, 0x0000);
+	
+	draw_selection_box(selection_cell, 0x0000);
+	if (line >= 0){
+		segment *w = &game_layout.win_line[line];
+		draw_thick_segment(w->x0, w->y0, w->x1, w->y1, 0x0000);
+		for (int i = 0; i < game_layout.k; i++){
+			int c = game_layout.line_cell[line][i];
+			if (board[c] == 1){
+				draw_player_X(c + 1);
+			} else if (board[c] == 2){
+				draw_player_O(c + 1);
+			}
+		}
+	}
+	draw_board();
+	selection_cell = cell;
+	draw_selection_box(selection_cell, 0xF800);
+	
+	// The player who made the move is to move again
+	Turn = (game_position.history_player[game_position.stones] == 1) ? 'X' : 'O';
+	if (Turn == 'X'){
+		char player_status[150] = "                    Player X's Turn!                      \0";
+		write_text(14, 55, player_status);
+	} else {
+		char player_status[150] = "                    Player O's Turn!                      \0";
+		write_text(14, 55, player_status);
+	}
+}
+
+// Plays the last move taken back again, the same way as any other move
+void redo_move(void){
+	int cell = engine_redo(&game_position);
+	if (cell < 0){
+		return;
+	}
+	draw_selection_box(selection_cell, 0x0000);
+	draw_board();
+	selection_cell = cell;
+	draw_selection_box(selection_cell, 0xF800);
+	finish_move(cell);
+}
+
+// Checks if every position has been filled
+void checkforStalemate(){
+    for(int index = 0; index < GAME_CELLS; index++){
+        // 0 means no one has claimed that position
+        if(board[index] == 0){
+            isStalemate = false;
+			return;
+        }
+    }
+	isStalemate = true;
+}
+
+// Line tables of a board size, built the first time the size is asked for
+const mnk_shape *engine_shape(int rows, int cols, int k){
+	int dir_row[4] = {0, 1, 1, 1};
+	int dir_col[4] = {1, 0, 1, -1};
+	mnk_shape *s = NULL;
+	
+#ifdef HOST_BUILD
+	pthread_mutex_lock(&shape_lock);
+#endif
+	for (int i = 0; i < shape_total; i++){
+		if (shapes[i].rows == rows && shapes[i].cols == cols && shapes[i].k == k){
+			s = &shapes[i];
+			break;
+		}
+	}
+	if (s != NULL){
+#ifdef HOST_BUILD
+		pthread_mutex_unlock(&shape_lock);
+#endif
+		return s;
+	}
+	if (shape_total == MAX_SHAPES){
+#ifdef HOST_BUILD
+		fprintf(stderr, "more than %d board sizes in use\n", MAX_SHAPES);
+		exit(1);
+#else
+		while (1);
+#endif
+	}
+	
+	// Fixed seed so the same position always has the same hash
+	if (shape_total == 0){
+		unsigned long long seed = 0x9E3779B97F4A7C15ULL;
+		for (int cell = 0; cell < MAX_CELLS; cell++){
+			for (int p = 0; p < 2; p++){
+				seed ^= seed << 13;
+				seed ^= seed >> 7;
+				seed ^= seed << 17;
+				zobrist[cell][p] = seed;
+			}
+		}
+	}
+	
+	s = &shapes[shape_total];
+	s->rows = rows;
+	s->cols = cols;
+	s->k = k;
+	
+	// A line with c stones of one player and none of the other is worth 8^c
+	// unless there are tuned weights for this k
+	s->line_weight[0] = 0;
+	for (int c = 1; c <= MAX_K; c++){
+		s->line_weight[c] = 1 << (3 * c);
+	}
+#ifdef TUNED_K
+	if (k == TUNED_K){
+		int tuned[TUNED_K] = TUNED_LINE_WEIGHTS;
+		memcpy(s->line_weight, tuned, sizeof(tuned));
+	}
+#endif
+	
+	// Every k long line in every direction, and the cell to line incidence
+	s->line_total = 0;
+	memset(s->cell_line_total, 0, sizeof(s->cell_line_total));
+	for (int d = 0; d < 4; d++){
+		for (int row = 0; row < rows; row++){
+			for (int col = 0; col < cols; col++){
+				int end_row = row + (k - 1) * dir_row[d];
+				int end_col = col + (k - 1) * dir_col[d];
+				if (end_row >= rows || end_col < 0 || end_col >= cols){
+					continue;
+				}
+				
+				for (int i = 0; i < k; i++){
+					int cell = (row + i * dir_row[d]) * cols + col + i * dir_col[d];
+					s->line_cells[s->line_total][i] = cell;
+					s->cell_lines[cell][s->cell_line_total[cell]++] = s->line_total;
+				}
+				s->line_total++;
+			}
+		}
+	}
+	shape_total++;
+#ifdef HOST_BUILD
+	pthread_mutex_unlock(&shape_lock);
+#endif
+	return s;
+}
+
+// Set up an empty m,n,k board (k in a row wins) on the line tables of its size
+void engine_init(mnk_board *b, int rows, int cols, int k){
+	b->rows = rows;
+	b->cols = cols;
+	b->k = k;
+	b->cells = rows * cols;
+	b->shape = engine_shape(rows, cols, k);
+	b->stones = 0;
+	b->history_total = 0;
+	b->score = 0;
+	b->hash = 0;
+	memset(b->cell, 0, sizeof(b->cell));
+	memset(b->line_count, 0, sizeof(b->line_count));
+	memset(b->near, 0, sizeof(b->near));
+	memset(b->open_lines, 0, sizeof(b->open_lines));
+	b->open_lines[0][0] = b->shape->line_total;
+	b->open_lines[1][0] = b->shape->line_total;
+}
+
+// Value of a line for X given how many stones each player has in it. Lines
+// holding stones of both players can't be won by anyone.
+static inline int line_value(const int *line_weight, unsigned char *count){
+	if (count[1] == 0){
+		return line_weight[count[0]];
+	} else if (count[0] == 0){
+		return -line_weight[count[1]];
+	}
+	return 0;
+}
+
+// Adds (delta 1) or takes away (delta -1) a line from the score and open lines
+static inline void line_account(mnk_board *b, unsigned char *count, int delta){
+	if (count[1] == 0){
+		b->score += delta * b->shape->line_weight[count[0]];
+		b->open_lines[0][count[0]] += delta;
+	}
+	if (count[0] == 0){
+		b->score -= delta * b->shape->line_weight[count[1]];
+		b->open_lines[1][count[1]] += delta;
+	}
+}
+
+// Places a stone and updates the lines through the cell. The move goes on
+// the history, dropping any moves that could have been redone.
+void engine_play(mnk_board *b, int cell, int player){
+	b->cell[cell] = player;
+	b->history[b->stones] = cell;
+	b->history_player[b->stones] = player;
+	b->stones++;
+	b->history_total = b->stones;
+	b->hash ^= zobrist[cell][player - 1];
+	
+	const mnk_shape *s = b->shape;
+	for (int i = 0; i < s->cell_line_total[cell]; i++){
+		unsigned char *count = b->line_count[s->cell_lines[cell][i]];
+		line_account(b, count, -1);
+		count[player - 1]++;
+		line_account(b, count, 1);
+	}
+	
+	int row = cell / b->cols, col = cell % b->cols;
+	int first_col = (col < 2) ? 0 : col - 2;
+	int last_col = (col + 2 >= b->cols) ? b->cols - 1 : col + 2;
+	for (int r = (row < 2) ? 0 : row - 2; r <= row + 2 && r < b->rows; r++){
+		for (int c = first_col; c <= last_col; c++){
+			b->near[r * b->cols + c]++;
+		}
+	}
+}
+
+// Removes the stone placed by engine_play. Moves are undone in the reverse of
+// the order they were played; the history keeps them for engine_redo.
+void engine_undo(mnk_board *b, int cell){
+	int player = b->cell[cell];
+	b->cell[cell] = 0;
+	b->stones--;
+	b->hash ^= zobrist[cell][player - 1];
+	
+	const mnk_shape *s = b->shape;
+	for (int i = 0; i < s->cell_line_total[cell]; i++){
+		unsigned char *count = b->line_count[s->cell_lines[cell][i]];
+		line_account(b, count, -1);
+		count[player - 1]--;
+		line_account(b, count, 1);
+	}
+	
+	int row = cell / b->cols, col = cell % b->cols;
+	int first_col = (col < 2) ? 0 : col - 2;
+	int last_col = (col + 2 >= b->cols) ? b->cols - 1 : col + 2;
+	for (int r = (row < 2) ? 0 : row - 2; r <= row + 2 && r < b->rows; r++){
+		for (int c = first_col; c <= last_col; c++){
+			b->near[r * b->cols + c]--;
+		}
+	}
+}
+
+// Takes back the last move, returns its cell or -1 if there are none
+int engine_undo_last(mnk_board *b){
+	if (b->stones == 0){
+		return -1;
+	}
+	int cell = b->history[b->stones - 1];
+	engine_undo(b, cell);
+	return cell;
+}
+
+// Plays the last move undone again, returns its cell or -1 if there is none
+int engine_redo(mnk_board *b){
+	if (b->stones == b->history_total){
+		return -1;
+	}
+	int total = b->history_total, cell = b->history[b->stones];
+	engine_play(b, cell, b->history_player[b->stones]);
+	b->history_total = total;
+	return cell;
+}
+
+// Checks whether the stone on cell completes k in a row
+bool engine_is_win(mnk_board *b, int cell){
+	int player = b->cell[cell];
+	const mnk_shape *s = b->shape;
+	
+	for (int i = 0; i < s->cell_line_total[cell]; i++){
+		if (b->line_count[s->cell_lines[cell][i]][player - 1] == b->k){
+			return true;
+		}
+	}
+	return false;
+}
+
+// Scores the position for player from the running line counts
+int engine_evaluate(mnk_board *b, int player){
+	return (player == 1) ? b->score : -b->score;
+}
+
+// Recomputes the score from scratch by scanning every line. Only used to check
+// and benchmark the incremental score.
+int engine_rescore(mnk_board *b){
+	const mnk_shape *s = b->shape;
+	int score = 0;
+	
+	for (int line = 0; line < s->line_total; line++){
+		unsigned char count[2] = {0, 0};
+		for (int i = 0; i < b->k; i++){
+			int stone = b->cell[s->line_cells[line][i]];
+			if (stone != 0){
+				count[stone - 1]++;
+			}
+		}
+		score += line_value(s->line_weight, count);
+	}
+	return score;
+}
+
+// Fills moves with the candidate cells, ordered so central cells come first.
+// On boards larger than 3x3 only cells within 2 of an existing stone are used.
+int generate_moves(mnk_board *b, unsigned char *moves){
+	int count = 0;
+	int centre_row = b->rows / 2, centre_col = b->cols / 2;
+	
+	if (b->stones == 0 && b->cells > 9){
+		moves[0] = centre_row * b->cols + centre_col;
+		return 1;
+	}
+	
+	for (int cell = 0; cell < b->cells; cell++){
+		if (b->cell[cell] != 0){
+			continue;
+		}
+		
+		if (b->cells > 9 && b->near[cell] == 0){
+			continue;
+		}
+		
+		// Insertion sort by distance to the centre
+		int dist = abs(cell / b->cols - centre_row) + abs(cell % b->cols - centre_col);
+		int i = count++;
+		while (i > 0 && abs(moves[i - 1] / b->cols - centre_row) + abs(moves[i - 1] % b->cols - centre_col) > dist){
+			moves[i] = moves[i - 1];
+			i--;
+		}
+		moves[i] = cell;
+	}
+	return count;
+}
+
+// Alpha-beta negamax. Returns the score of the position for player, who is
+// about to move. Gives up (search_aborted) once the budget is spent.
+int negamax(mnk_board *b, int depth, int alpha, int beta, int player, int ply){
+	search_nodes++;
+	pv_length[ply] = ply;
+	
+	// Only read the timer every 256 nodes
+	if ((search_nodes & 0xFF) == 0 && search_start - read_timer() > search_budget){
+		search_aborted = true;
+	}
+	if (search_aborted){
+		return 0;
+	}
+	
+	if (depth == 0){
+		return engine_evaluate(b, player);
+	}
+	
+	unsigned char *moves = move_list[ply];
+	int count = generate_moves(b, moves);
+	if (count == 0){
+		return 0;
+	}
+	
+	// On the previous iteration's principal variation, try its move first.
+	// Elsewhere previous_pv[ply] is just a move from another line.
+	bool pv_node = search_on_pv && ply < previous_pv_length;
+	if (pv_node){
+		for (int i = 1; i < count; i++){
+			if (moves[i] == previous_pv[ply]){
+				unsigned char pv_move = moves[i];
+				memmove(&moves[1], &moves[0], i);
+				moves[0] = pv_move;
+				break;
+			}
+		}
+	}
+	
+	int best = -INFINITY_SCORE;
+	for (int i = 0; i < count; i++){
+		int move = moves[i];
+		int score;
+		
+		engine_play(b, move, player);
+		pv_length[ply + 1] = ply + 1;
+		if (engine_is_win(b, move)){
+			score = WIN_SCORE - ply - 1;
+		} else if (b->stones == b->cells){
+			score = 0;
+		} else {
+			search_on_pv = pv_node && move == previous_pv[ply];
+			score = -negamax(b, depth - 1, -beta, -alpha, 3 - player, ply + 1);
+		}
+		engine_undo(b, move);
+		
+		if (search_aborted){
+			return 0;
+		}
+		
+		if (score > best){
+			best = score;
+			
+			// Update the principal variation
+			pv_table[ply][ply] = move;
+			for (int j = ply + 1; j < pv_length[ply + 1]; j++){
+				pv_table[ply][j] = pv_table[ply + 1][j];
+			}
+			pv_length[ply] = pv_length[ply + 1];
+		}
+		if (best > alpha){
+			alpha = best;
+		}
+		if (alpha >= beta){
+			break;
+		}
+	}
+	return best;
+}
+
+// Iterative deepening search for player's best move. Gives up once
+// budget_ticks of the A9 private timer have passed and returns the best move of
+// the last depth that finished. Per depth statistics are left in search_stats.
+int search_best_move(mnk_board *b, int player, unsigned int budget_ticks){
+	unsigned char fallback[MAX_CELLS];
+	int best_move = -1;
+	int score = 0;
+	int max_depth = b->cells - b->stones;
+	
+	if (generate_moves(b, fallback) == 0){
+		return -1;
+	}
+	// Something legal is returned even if depth 1 doesn't finish
+	best_move = fallback[0];
+	
+	if (max_depth > MAX_DEPTH){
+		max_depth = MAX_DEPTH;
+	}
+	
+	memset(search_stats, 0, sizeof(search_stats));
+	search_depth_reached = 0;
+	search_aborted = false;
+	search_budget = budget_ticks;
+	search_start = read_timer();
+	previous_pv_length = 0;
+	
+	for (int depth = 1; depth <= max_depth; depth++){
+		unsigned int depth_start = read_timer();
+		int alpha = -INFINITY_SCORE, beta = INFINITY_SCORE;
+		
+		// Aspiration window around the previous score
+		if (depth > 1){
+			alpha = score - ASPIRATION_WINDOW;
+			beta = score + ASPIRATION_WINDOW;
+		}
+		
+		search_nodes = 0;
+		search_on_pv = true;
+		int result = negamax(b, depth, alpha, beta, player, 0);
+		
+		// Score fell outside the window, search again with a full window
+		if (!search_aborted && (result <= alpha || result >= beta)){
+			search_on_pv = true;
+			result = negamax(b, depth, -INFINITY_SCORE, INFINITY_SCORE, player, 0);
+		}
+		
+		search_stats[depth].nodes = search_nodes;
+		search_stats[depth].ticks = depth_start - read_timer();
+		if (search_aborted){
+			break;
+		}
+		
+		score = result;
+		best_move = pv_table[0][0];
+		search_stats[depth].score = score;
+		search_stats[depth].best_move = best_move;
+		search_stats[depth].completed = true;
+		search_depth_reached = depth;
+		
+		// Keep the principal variation to order the next iteration
+		previous_pv_length = pv_length[0];
+		for (int i = 0; i < previous_pv_length; i++){
+			previous_pv[i] = pv_table[0][i];
+		}
+		
+		// Stop once the result is a forced win or loss
+		if (score > WIN_SCORE - MAX_DEPTH || score < -WIN_SCORE + MAX_DEPTH){
+			break;
+		}
+	}
+	return best_move;
+}
+
+// Checks whether player completes a line by playing on cell
+static bool completes_line(mnk_board *b, int cell, int player){
+	const mnk_shape *s = b->shape;
+	for (int i = 0; i < s->cell_line_total[cell]; i++){
+		unsigned char *count = b->line_count[s->cell_lines[cell][i]];
+		if (count[player - 1] == b->k - 1 && count[2 - player] == 0){
+			return true;
+		}
+	}
+	return false;
+}
+
+// A forcing move makes a four (k-1 in a line the defender can't use) or at
+// least two threes (k-2), which covers open threes and double threes
+static bool is_forcing(mnk_board *b, int cell, int attacker){
+	const mnk_shape *s = b->shape;
+	int threes = 0;
+	
+	for (int i = 0; i < s->cell_line_total[cell]; i++){
+		unsigned char *count = b->line_count[s->cell_lines[cell][i]];
+		if (count[2 - attacker] != 0){
+			continue;
+		}
+		if (count[attacker - 1] + 1 >= b->k - 1){
+			return true;
+		}
+		if (count[attacker - 1] + 1 == b->k - 2){
+			threes++;
+		}
+	}
+	return threes >= 2;
+}
+
+// Adds the empty cells of line to moves, skipping cells already marked
+static int add_line_cells(mnk_board *b, int line, unsigned char *moves, int count, unsigned char *mark){
+	for (int i = 0; i < b->k; i++){
+		int cell = b->shape->line_cells[line][i];
+		if (b->cell[cell] == 0 && !mark[cell]){
+			mark[cell] = 1;
+			moves[count++] = cell;
+		}
+	}
+	return count;
+}
+
+// Threat-space move generation for the solver. The attacker may only play
+// forcing moves and the defender may only answer the threats (or make a four
+// of their own). outcome is set to 1 if the attacker has won, 2 if the
+// attacker's attack has failed and 0 if the moves should be searched.
+int threat_moves(mnk_board *b, int attacker, bool attacker_to_move, int last, unsigned char *moves, int *outcome){
+	const mnk_shape *s = b->shape;
+	int defender = 3 - attacker;
+	int k = b->k;
+	int count = 0;
+	unsigned char mark[MAX_CELLS];
+	
+	*outcome = 0;
+	if (b->stones == b->cells){
+		*outcome = 2;
+		return 0;
+	}
+	
+	if (attacker_to_move){
+		// Attacker completes a line next move
+		if (b->open_lines[attacker - 1][k - 1] > 0){
+			*outcome = 1;
+			return 0;
+		}
+		
+		// A defender four has to be blocked, and the block must still be forcing
+		bool must_block = b->open_lines[defender - 1][k - 1] > 0;
+		for (int cell = 0; cell < b->cells; cell++){
+			if (b->cell[cell] != 0 || (b->cells > 9 && b->near[cell] == 0)){
+				continue;
+			}
+			if (must_block && !completes_line(b, cell, defender)){
+				continue;
+			}
+			if (is_forcing(b, cell, attacker)){
+				moves[count++] = cell;
+			}
+		}
+	} else {
+		// Defender completes a line next move
+		if (b->open_lines[defender - 1][k - 1] > 0){
+			*outcome = 2;
+			return 0;
+		}
+		
+		memset(mark, 0, b->cells);
+		if (b->open_lines[attacker - 1][k - 1] > 0){
+			// Every attacker four has to be blocked, two different cells can't be
+			for (int line = 0; line < s->line_total; line++){
+				if (b->line_count[line][attacker - 1] == k - 1 && b->line_count[line][defender - 1] == 0){
+					count = add_line_cells(b, line, moves, count, mark);
+				}
+			}
+			if (count >= 2){
+				*outcome = 1;
+			}
+			return count;
+		}
+		
+		// Answer the threes made by the last move
+		for (int i = 0; i < s->cell_line_total[last]; i++){
+			int line = s->cell_lines[last][i];
+			if (b->line_count[line][attacker - 1] >= k - 2 && b->line_count[line][defender - 1] == 0){
+				count = add_line_cells(b, line, moves, count, mark);
+			}
+		}
+		
+		// Or counter with a four
+		if (b->open_lines[defender - 1][k - 2] > 0){
+			for (int line = 0; line < s->line_total; line++){
+				if (b->line_count[line][defender - 1] == k - 2 && b->line_count[line][attacker - 1] == 0){
+					count = add_line_cells(b, line, moves, count, mark);
+				}
+			}
+		}
+	}
+	
+	if (count == 0){
+		*outcome = 2;
+	}
+	return count;
+}
+
+// Finds hash in the worker's table. Buckets hold two entries.
+static pns_entry *pns_find(pns_context *ctx, unsigned long long hash){
+	pns_entry *bucket = &ctx->table[(hash % (ctx->table_size / 2)) * 2];
+	
+	for (int i = 0; i < 2; i++){
+		if (bucket[i].generation == pns_generation && bucket[i].hash == hash){
+			return &bucket[i];
+		}
+	}
+	return NULL;
+}
+
+// Work below an entry, 0 if it is left over from an earlier solve
+static inline unsigned int pns_work(const pns_entry *entry){
+	return (entry->generation == pns_generation) ? entry->work : 0;
+}
+
+// Stores the numbers of a position, replacing the entry with less work
+static void pns_store(pns_context *ctx, unsigned long long hash, unsigned int pn, unsigned int dn, unsigned int work){
+	pns_entry *entry = pns_find(ctx, hash);
+	
+	if (entry == NULL){
+		pns_entry *bucket = &ctx->table[(hash % (ctx->table_size / 2)) * 2];
+		entry = (pns_work(&bucket[0]) <= pns_work(&bucket[1])) ? &bucket[0] : &bucket[1];
+		if (entry->generation != pns_generation){
+			entry->generation = pns_generation;
+			ctx->table_used++;
+		}
+	}
+	entry->hash = hash;
+	entry->pn = pn;
+	entry->dn = dn;
+	entry->work = (work == 0) ? 1 : work;
+}
+
+// Depth-first proof-number search (df-pn) of the position in ctx->board.
+// The attacker moves on even plies. Returns once the position's proof or
+// disproof number reaches its threshold.
+void pns_mid(pns_context *ctx, int ply, int last, unsigned int threshold_pn, unsigned int threshold_dn){
+	mnk_board *b = &ctx->board;
+	bool or_node = (ply % 2 == 0);
+	int mover = or_node ? ctx->attacker : 3 - ctx->attacker;
+	unsigned int start_nodes = ctx->nodes;
+	unsigned int pn, dn;
+	int outcome;
+	
+	ctx->nodes++;
+	// Only read the timer every 1024 nodes
+	if ((ctx->nodes & 0x3FF) == 0 && pns_start - read_timer() > pns_budget){
+		pns_stop = true;
+	}
+	if (pns_stop){
+		return;
+	}
+	
+	unsigned char *moves = ctx->moves[ply];
+	int count = threat_moves(b, ctx->attacker, or_node, last, moves, &outcome);
+	
+	// Root moves are shared out between the workers
+	if (ply == 0 && outcome == 0){
+		int kept = 0;
+		for (int i = ctx->worker; i < count; i += PNS_THREADS){
+			moves[kept++] = moves[i];
+		}
+		count = kept;
+		if (count == 0){
+			outcome = 2;
+		}
+	}
+	
+	if (outcome != 0 || ply >= PNS_MAX_PLY){
+		pn = (outcome == 1) ? 0 : PNS_INFINITY;
+		dn = (outcome == 1) ? PNS_INFINITY : 0;
+		pns_store(ctx, b->hash, pn, dn, 1);
+		return;
+	}
+	
+	while (!pns_stop){
+		int best = 0;
+		unsigned int best_value = PNS_INFINITY + 1, second_value = PNS_INFINITY + 1;
+		unsigned int best_pn = 1, best_dn = 1;
+		unsigned int min = PNS_INFINITY, sum = 0;
+		
+		// Collect the children's numbers. Unseen children count as 1, 1.
+		for (int i = 0; i < count; i++){
+			pns_entry *child = pns_find(ctx, b->hash ^ zobrist[moves[i]][mover - 1]);
+			unsigned int child_pn = child ? child->pn : 1;
+			unsigned int child_dn = child ? child->dn : 1;
+			unsigned int value = or_node ? child_pn : child_dn;
+			
+			sum += or_node ? child_dn : child_pn;
+			if (sum > PNS_INFINITY){
+				sum = PNS_INFINITY;
+			}
+			if (value < min){
+				min = value;
+			}
+			if (value < best_value){
+				second_value = best_value;
+				best_value = value;
+				best = i;
+				best_pn = child_pn;
+				best_dn = child_dn;
+			} else if (value < second_value){
+				second_value = value;
+			}
+		}
+		
+		// OR nodes need one proven child, AND nodes need all of them
+		pn = or_node ? min : sum;
+		dn = or_node ? sum : min;
+		pns_store(ctx, b->hash, pn, dn, ctx->nodes - start_nodes);
+		
+		if (ply == 0 && pn == 0){
+			ctx->winning_move = moves[best];
+		}
+		if (pn >= threshold_pn || dn >= threshold_dn){
+			break;
+		}
+		
+		// Search the most proving child until it stops being the best one
+		unsigned int child_pn, child_dn;
+		if (or_node){
+			child_pn = (threshold_pn < second_value + 1) ? threshold_pn : second_value + 1;
+			child_dn = threshold_dn - dn + best_dn;
+		} else {
+			child_dn = (threshold_dn < second_value + 1) ? threshold_dn : second_value + 1;
+			child_pn = threshold_pn - pn + best_pn;
+		}
+		
+		engine_play(b, moves[best], mover);
+		pns_mid(ctx, ply + 1, moves[best], child_pn, child_dn);
+		engine_undo(b, moves[best]);
+	}
+}
+
+// Counts the nodes of the proof tree below a proven position: one proven
+// child of every attacker node and every child of every defender node
+unsigned int pns_proof_size(pns_context *ctx, int ply, int last){
+	mnk_board *b = &ctx->board;
+	bool or_node = (ply % 2 == 0);
+	int mover = or_node ? ctx->attacker : 3 - ctx->attacker;
+	unsigned int size = 1;
+	int outcome;
+	
+	unsigned char *moves = ctx->moves[ply];
+	int count = threat_moves(b, ctx->attacker, or_node, last, moves, &outcome);
+	if (outcome != 0 || ply >= PNS_MAX_PLY){
+		return size;
+	}
+	
+	for (int i = 0; i < count; i++){
+		int move = moves[i];
+		pns_entry *child = pns_find(ctx, b->hash ^ zobrist[move][mover - 1]);
+		if (or_node && (child == NULL || child->pn != 0)){
+			continue;
+		}
+		
+		engine_play(b, move, mover);
+		size += pns_proof_size(ctx, ply + 1, move);
+		engine_undo(b, move);
+		
+		if (or_node){
+			break;
+		}
+	}
+	return size;
+}
+
+// Runs one solver worker from the root position
+void *pns_worker(void *arg){
+	pns_context *ctx = (pns_context *) arg;
+	
+	ctx->nodes = 0;
+	ctx->winning_move = -1;
+	pns_mid(ctx, 0, -1, PNS_INFINITY, PNS_INFINITY);
+	
+	// A proven win ends the other workers' searches
+	if (ctx->winning_move >= 0){
+		pns_stop = true;
+	}
+	return NULL;
+}
+
+// Tries to prove a forced win for attacker, who is to move, within
+// budget_ticks. Returns the first move of the win, or -1 if none was found.
+// Statistics are left in pns_stats.
+int pns_solve(mnk_board *b, int attacker, unsigned int budget_ticks){
+	unsigned int table_size = PNS_TABLE_SIZE / PNS_THREADS;
+	int winning_move = -1;
+	bool disproven = true;
+	
+	// The budget covers the setup as well as the search
+	pns_start = read_timer();
+	memset(&pns_stats, 0, sizeof(pns_stats));
+	
+	// Nothing to prove if the attacker can complete a line right away
+	for (int cell = 0; cell < b->cells; cell++){
+		if (b->cell[cell] == 0 && completes_line(b, cell, attacker)){
+			pns_stats.proof_size = 1;
+			pns_stats.result = 1;
+			return cell;
+		}
+	}
+	
+	// A new stamp empties the table. Only when the stamps run out, once in
+	// four billion solves, is it cleared.
+	if (++pns_generation == 0){
+		memset(pns_table, 0, sizeof(pns_table));
+		pns_generation = 1;
+	}
+	
+	for (int w = 0; w < PNS_THREADS; w++){
+		pns_context *ctx = &pns_workers[w];
+		ctx->board = *b;
+		ctx->attacker = attacker;
+		ctx->worker = w;
+		ctx->table = pns_table + w * table_size;
+		ctx->table_size = table_size;
+		ctx->table_used = 0;
+	}
+	
+	pns_stop = false;
+	pns_budget = budget_ticks;
+	
+#ifdef HOST_BUILD
+	pthread_t threads[PNS_THREADS];
+	for (int w = 0; w < PNS_THREADS; w++){
+		pthread_create(&threads[w], NULL, pns_worker, &pns_workers[w]);
+	}
+	for (int w = 0; w < PNS_THREADS; w++){
+		pthread_join(threads[w], NULL);
+	}
+#else
+	pns_worker(&pns_workers[0]);
+#endif
+	
+	pns_stats.ticks = pns_start - read_timer();
+	
+	for (int w = 0; w < PNS_THREADS; w++){
+		pns_context *ctx = &pns_workers[w];
+		pns_entry *root = pns_find(ctx, ctx->board.hash);
+		
+		pns_stats.nodes += ctx->nodes;
+		pns_stats.table_used += ctx->table_used;
+		if (root == NULL || root->dn != 0){
+			disproven = false;
+		}
+		if (winning_move < 0 && ctx->winning_move >= 0){
+			winning_move = ctx->winning_move;
+			pns_stats.proof_size = pns_proof_size(ctx, 0, -1);
+		}
+	}
+	
+	if (pns_stats.ticks != 0){
+		pns_stats.positions_per_second = (unsigned long long) pns_stats.nodes * TIMER_HZ / pns_stats.ticks;
+	}
+	pns_stats.result = (winning_move >= 0) ? 1 : (disproven ? 0 : -1);
+	return winning_move;
+}
+
+// Bits needed to store a cell index of a board with this many cells
+int move_bits(int cells){
+	int bits = 1;
+	while ((1 << bits) < cells){
+		bits++;
+	}
+	return bits;
+}
+
+// Packs a game into out, returns the number of bytes used
+int game_record_encode(game_record *g, unsigned char *out){
+	int bits = move_bits(g->rows * g->cols);
+	int length = 3 + (g->move_total * bits + 7) / 8;
+	
+	out[0] = (g->rows << 4) | g->cols;
+	out[1] = (g->k << 4) | (g->result << 2);
+	out[2] = g->move_total;
+	memset(out + 3, 0, length - 3);
+	
+	for (int i = 0; i < g->move_total; i++){
+		int position = i * bits;
+		unsigned int packed = g->moves[i] << (position & 7);
+		out[3 + (position >> 3)] |= packed & 0xFF;
+		if ((position & 7) + bits > 8){
+			out[4 + (position >> 3)] |= packed >> 8;
+		}
+	}
+	return length;
+}
+
+// Unpacks a game, returns the number of bytes read or 0 if in isn't a record
+int game_record_decode(const unsigned char *in, game_record *g){
+	g->rows = in[0] >> 4;
+	g->cols = in[0] & 0xF;
+	g->k = in[1] >> 4;
+	g->result = (in[1] >> 2) & 3;
+	g->move_total = in[2];
+	if (g->rows == 0 || g->cols == 0 || g->k == 0 || g->move_total > g->rows * g->cols){
+		return 0;
+	}
+	
+	int bits = move_bits(g->rows * g->cols);
+	for (int i = 0; i < g->move_total; i++){
+		int position = i * bits;
+		unsigned int packed = in[3 + (position >> 3)];
+		if ((position & 7) + bits > 8){
+			packed |= in[4 + (position >> 3)] << 8;
+		}
+		g->moves[i] = (packed >> (position & 7)) & ((1 << bits) - 1);
+	}
+	return 3 + (g->move_total * bits + 7) / 8;
+}
+
+// Adds a game to the log buffer, writing the buffer out when it is full
+void game_log_append(game_record *g){
+	unsigned char record[3 + MAX_CELLS];
+	int length = game_record_encode(g, record);
+	
+	if (game_log_buffered + length > GAME_LOG_BUFFER_SIZE){
+		game_log_flush();
+	}
+	if (game_log_buffered + length > GAME_LOG_BUFFER_SIZE){
+		return; // the flush couldn't make room
+	}
+	memcpy(game_log_buffer + game_log_buffered, record, length);
+	game_log_buffered += length;
+}
+
+// Writes the buffered records to the end of the log
+void game_log_flush(void){
+	if (game_log_buffered == 0){
+		return;
+	}
+#ifdef HOST_BUILD
+	FILE *log = fopen(game_log_path, "ab");
+	if (log != NULL){
+		fwrite(game_log_buffer, 1, game_log_buffered, log);
+		fclose(log);
+	}
+#else
+	// The log stops growing once its region is full, and the records that
+	// didn't fit are dropped so the buffer can't overflow
+	if (game_log_length + game_log_buffered > GAME_LOG_SIZE){
+		game_log_buffered = 0;
+		return;
+	}
+	memcpy((char *) GAME_LOG_BASE + game_log_length, game_log_buffer, game_log_buffered);
+#endif
+	game_log_length += game_log_buffered;
+	game_log_buffered = 0;
+}
+
+// Logs the game being played, if any moves were made and it wasn't logged
+// when it ended, and starts a new one
+void start_game_record(void){
+	if (current_game.move_total > 0 && current_game.result == 0){
+		game_log_append(&current_game);
+	}
+	current_game.rows = 3;
+	current_game.cols = 3;
+	current_game.k = 3;
+	current_game.result = 0;
+	current_game.move_total = 0;
+}
+
+// Moves played after the game has ended are not recorded
+void record_move(int index){
+	if (current_game.result == 0 && current_game.move_total < MAX_CELLS){
+		current_game.moves[current_game.move_total++] = index;
+	}
+}
+
+// Logs the game when check_winner reports it has ended
+void record_result(int winner){
+	if (winner != 0 && current_game.result == 0 && current_game.move_total > 0){
+		current_game.result = winner;
+		game_log_append(&current_game);
+	}
+}
+
+// Takes the last move off the game being recorded. A game that had already
+// been logged as finished carries on as a new record from there.
+void unrecord_move(void){
+	if (current_game.move_total > 0){
+		current_game.move_total--;
+	}
+	current_game.result = 0;
+}
+
+// Maps a cell through one of the board's symmetries. Bit 0 of symmetry flips
+// the columns, bit 1 the rows and bit 2 transposes (square boards only).
+int symmetry_cell(int cell, int symmetry, int rows, int cols){
+	int row = cell / cols, col = cell % cols;
+	
+	if (symmetry & 4){
+		int temp = row;
+		row = col;
+		col = temp;
+	}
+	if (symmetry & 1){
+		col = cols - 1 - col;
+	}
+	if (symmetry & 2){
+		row = rows - 1 - row;
+	}
+	return row * cols + col;
+}
+
+// Smallest hash of the position over all of the board's symmetries, so
+// positions that are rotations or reflections of each other share a key
+unsigned long long canonical_key(mnk_board *b){
+	int symmetries = (b->rows == b->cols) ? 8 : 4;
+	unsigned long long key = b->hash;
+	
+	for (int symmetry = 1; symmetry < symmetries; symmetry++){
+		unsigned long long hash = 0;
+		for (int cell = 0; cell < b->cells; cell++){
+			if (b->cell[cell] != 0){
+				hash ^= zobrist[symmetry_cell(cell, symmetry, b->rows, b->cols)][b->cell[cell] - 1];
+			}
+		}
+		if (hash < key){
+			key = hash;
+		}
+	}
+	return key;
+}
+
+// Uses a book image already in memory without copying it
+bool book_attach(opening_book *book, const void *image){
+	const book_header *header = (const book_header *) image;
+	
+	if (memcmp(header->magic, "TTTBOOK", 8) != 0){
+		return false;
+	}
+	book->rows = header->rows;
+	book->cols = header->cols;
+	book->k = header->k;
+	book->count = header->count;
+	book->entries = (const book_entry *) (header + 1);
+	return true;
+}
+
+#ifdef HOST_BUILD
+// Maps a whole file read-only, returns NULL if it can't or the file is empty
+void *map_read(const char *path, size_t *size){
+	struct stat info;
+	int fd = open(path, O_RDONLY);
+	if (fd < 0 || fstat(fd, &info) != 0 || info.st_size == 0){
+		if (fd >= 0){
+			close(fd);
+		}
+		return NULL;
+	}
+	*size = info.st_size;
+	void *data = mmap(NULL, *size, PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+	return (data == MAP_FAILED) ? NULL : data;
+}
+
+// Creates (or truncates) a file of size bytes and maps it for writing in
+// place. Reports why and returns NULL if it can't.
+void *map_create(const char *path, size_t size){
+	int fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+	if (fd < 0 || ftruncate(fd, size) != 0){
+		perror(path);
+		if (fd >= 0){
+			close(fd);
+		}
+		return NULL;
+	}
+	void *data = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	close(fd);
+	if (data == MAP_FAILED){
+		perror(path);
+		return NULL;
+	}
+	return data;
+}
+
+// Maps a book file read-only
+bool book_open(opening_book *book, const char *path){
+	size_t size;
+	void *image = map_read(path, &size);
+	if (image == NULL){
+		return false;
+	}
+	if (size < sizeof(book_header) || !book_attach(book, image) || sizeof(book_header) + book->count * sizeof(book_entry) > size){
+		munmap(image, size);
+		book->entries = NULL;
+		return false;
+	}
+	return true;
+}
+#endif
+
+// Binary search for a key, NULL if the book doesn't have it
+const book_entry *book_find(opening_book *book, unsigned long long key){
+	unsigned long long low = 0, high = book->count;
+	
+	while (low < high){
+		unsigned long long middle = (low + high) / 2;
+		if (book->entries[middle].key < key){
+			low = middle + 1;
+		} else {
+			high = middle;
+		}
+	}
+	return (low < book->count && book->entries[low].key == key) ? &book->entries[low] : NULL;
+}
+
+// Picks the move leading to the position with the best average self-play
+// result for the player to move. Returns -1 if the book has no move for it.
+int book_move(opening_book *book, mnk_board *b){
+	int player = (b->stones % 2 == 0) ? 1 : 2;
+	int best_move = -1;
+	long long best_score = 0;
+	unsigned int best_games = 1;
+	
+	if (book->entries == NULL || book->rows != b->rows || book->cols != b->cols || book->k != b->k){
+		return -1;
+	}
+	book->lookups++;
+	
+	for (int cell = 0; cell < b->cells; cell++){
+		if (b->cell[cell] != 0){
+			continue;
+		}
+		
+		engine_play(b, cell, player);
+		const book_entry *entry = book_find(book, canonical_key(b));
+		engine_undo(b, cell);
+		
+		// Compare score / games without dividing
+		if (entry != NULL && entry->games >= BOOK_MIN_GAMES
+			&& (best_move < 0 || (long long) entry->score * best_games > best_score * entry->games)){
+			best_move = cell;
+			best_score = entry->score;
+			best_games = entry->games;
+		}
+	}
+	
+	if (best_move >= 0){
+		book->hits++;
+	}
+	return best_move;
+}
+
+// Works out the layer offsets of a database for the board size
+void endgame_layout(endgame_db *db, int rows, int cols, int k){
+	for (int n = 0; n <= MAX_DB_CELLS; n++){
+		binomial[n][0] = 1;
+		for (int r = 1; r <= n; r++){
+			binomial[n][r] = binomial[n - 1][r - 1] + ((r < n) ? binomial[n - 1][r] : 0);
+		}
+	}
+	
+	db->rows = rows;
+	db->cols = cols;
+	db->k = k;
+	db->cells = rows * cols;
+	db->total = 0;
+	
+	// X moves first so a position with s stones has (s + 1) / 2 Xs
+	for (int stones = 0; stones <= db->cells; stones++){
+		int x = (stones + 1) / 2, o = stones / 2;
+		db->layer_offset[stones] = db->total;
+		db->total += binomial[db->cells][x] * binomial[db->cells - x][o];
+	}
+	db->layer_offset[db->cells + 1] = db->total;
+}
+
+// Perfect hash of a position to its index in the database
+unsigned long long endgame_rank(endgame_db *db, const char *cell){
+	unsigned long long x_rank = 0, o_rank = 0;
+	int x = 0, o = 0, free_cells = 0;
+	
+	// Combinatorial number system rank of the X cells, and of the O cells
+	// numbered among the cells without an X
+	for (int i = 0; i < db->cells; i++){
+		if (cell[i] == 1){
+			x_rank += binomial[i][++x];
+		} else {
+			if (cell[i] == 2){
+				o_rank += binomial[free_cells][++o];
+			}
+			free_cells++;
+		}
+	}
+	return db->layer_offset[x + o] + x_rank * binomial[db->cells - x][o] + o_rank;
+}
+
+int endgame_value(endgame_db *db, unsigned long long index){
+	return (db->values[index >> 2] >> ((index & 3) * 2)) & 3;
+}
+
+// Uses a database image already in memory (mapped from a file, or loaded into
+// SDRAM with the program) without copying it
+bool endgame_attach(endgame_db *db, const void *image){
+	const endgame_header *header = (const endgame_header *) image;
+	
+	if (memcmp(header->magic, "TTTEGDB", 8) != 0 || header->rows * header->cols > MAX_DB_CELLS){
+		return false;
+	}
+	endgame_layout(db, header->rows, header->cols, header->k);
+	if (db->total != header->total){
+		return false;
+	}
+	db->values = (const unsigned char *) (header + 1);
+	return true;
+}
+
+#ifdef HOST_BUILD
+// Maps a database file read-only. Pages are only read when they are looked up.
+bool endgame_open(endgame_db *db, const char *path){
+	size_t size;
+	void *image = map_read(path, &size);
+	if (image == NULL){
+		return false;
+	}
+	if (size < sizeof(endgame_header) || !endgame_attach(db, image) || sizeof(endgame_header) + (db->total + 3) / 4 > size){
+		munmap(image, size);
+		db->values = NULL;
+		return false;
+	}
+	return true;
+}
+#endif
+
+// Picks the move with the best database value: a win, else a draw. Returns -1
+// if no database for this board is attached.
+int endgame_best_move(endgame_db *db, mnk_board *b){
+	int best_move = -1, best_value = 0;
+	int player = (b->stones % 2 == 0) ? 1 : 2;
+	
+	if (db->values == NULL || db->rows != b->rows || db->cols != b->cols || db->k != b->k){
+		return -1;
+	}
+	
+	for (int cell = 0; cell < b->cells; cell++){
+		if (b->cell[cell] != 0){
+			continue;
+		}
+		
+		engine_play(b, cell, player);
+		int value = ENDGAME_WIN;
+		if (!engine_is_win(b, cell)){
+			// A loss for the opponent is a win for us
+			int opponent_value = endgame_value(db, endgame_rank(db, b->cell));
+			value = (opponent_value == ENDGAME_UNKNOWN) ? ENDGAME_UNKNOWN : ENDGAME_WIN + ENDGAME_LOSS - opponent_value;
+		}
+		engine_undo(b, cell);
+		
+		if (value > best_value){
+			best_value = value;
+			best_move = cell;
+		}
+		if (value == ENDGAME_WIN){
+			break;
+		}
+	}
+	return best_move;
+}
+
+void AI_move(){	
+	// AI can only move if there is a possible spot on the board to move 
+	if(isStalemate == false){
+		mnk_board AI_board = game_position;
+		
+		// The solver gets half the budget, search is used if it finds no win
+		int player = (Turn == 'X') ? 1 : 2;
+		int AI_Index = book_move(&book, &AI_board);
+		if (AI_Index < 0){
+			AI_Index = endgame_best_move(&endgame, &AI_board);
+		}
+		if (AI_Index < 0 && ai_strategy == AI_STRATEGY_PROOF){
+			AI_Index = pns_solve(&AI_board, player, AI_BUDGET_TICKS / 2);
+		}
+		if (AI_Index < 0){
+			AI_Index = search_best_move(&AI_board, player, (ai_strategy == AI_STRATEGY_PROOF) ? AI_BUDGET_TICKS / 2 : AI_BUDGET_TICKS);
+			hud_search_done();
+		}
+		if (AI_Index < 0){
+			return;
+		}
+		
+		draw_selection_box(selection_cell, 0x0000);
+		draw_board();
+		
+		selection_cell = AI_Index;
+		
+		draw_selection_box(selection_cell, 0xF800);
+		
+		engine_play(&game_position, AI_Index, player);
+		finish_move(AI_Index);
+	}
+}
+
+// A win or loss one ply further away, as seen from the position before
+static int analysis_parent(int value){
+	if (value > WIN_SCORE - MAX_CELLS - 1){
+		return value - 1;
+	}
+	if (value < -WIN_SCORE + MAX_CELLS + 1){
+		return value + 1;
+	}
+	return value;
+}
+
+// Alpha-beta negamax like the AI's, but every position searched goes into
+// analysis_table and positions found there with enough depth aren't searched
+// again. Children get a window one wider on each side so a bound stays a
+// bound once analysis_parent has moved it.
+static int analysis_search(mnk_board *b, int player, int depth, int alpha, int beta, int ply){
+	analysis_stats.nodes++;
+	if ((analysis_stats.nodes & 0xFF) == 0 && analysis_start - read_timer() > analysis_budget){
+		analysis_aborted = true;
+	}
+	if (analysis_aborted){
+		return 0;
+	}
+	if (b->stones == b->cells){
+		return 0;
+	}
+	if (depth == 0){
+		return engine_evaluate(b, player);
+	}
+	
+	unsigned long long key = b->hash ^ player;
+	analysis_entry *entry = &analysis_table[key & (ANALYSIS_TABLE_SIZE - 1)];
+	if (entry->key == key && entry->depth >= depth){
+		if (entry->bound == ANALYSIS_EXACT || (entry->bound == ANALYSIS_LOWER && entry->value >= beta)
+			|| (entry->bound == ANALYSIS_UPPER && entry->value <= alpha)){
+			analysis_stats.table_hits++;
+			return entry->value;
+		}
+	}
+	
+	int best = -INFINITY_SCORE, original_alpha = alpha;
+	unsigned char *moves = analysis_moves[ply];
+	int count = generate_moves(b, moves);
+	for (int i = 0; i < count && alpha < beta; i++){
+		engine_play(b, moves[i], player);
+		int value = engine_is_win(b, moves[i]) ? WIN_SCORE - 1
+			: analysis_parent(-analysis_search(b, 3 - player, depth - 1, -beta - 1, -alpha + 1, ply + 1));
+		engine_undo(b, moves[i]);
+		if (value > best){
+			best = value;
+		}
+		if (best > alpha){
+			alpha = best;
+		}
+	}
+	
+	// A search cut short proves nothing
+	if (!analysis_aborted){
+		entry->key = key;
+		entry->value = best;
+		entry->depth = depth;
+		entry->bound = (best <= original_alpha) ? ANALYSIS_UPPER : (best >= beta ? ANALYSIS_LOWER : ANALYSIS_EXACT);
+	}
+	return best;
+}
+
+// Value for player of playing on cell, an empty cell of b
+int analysis_cell(mnk_board *b, int cell, int player){
+	engine_play(b, cell, player);
+	int empty = b->cells - b->stones;
+	int value = engine_is_win(b, cell) ? WIN_SCORE - 1
+		: analysis_parent(-analysis_search(b, 3 - player, (empty < ANALYSIS_DEPTH) ? empty : ANALYSIS_DEPTH,
+			-INFINITY_SCORE, INFINITY_SCORE, 0));
+	engine_undo(b, cell);
+	return value;
+}
+
+// [E]: turns the overlay on or off. Either way every label is written once.
+void analysis_toggle(void){
+	game_view_changed();
+	analysis_showing = !analysis_showing;
+	analysis_current = false;
+	for (int cell = 0; cell < game_layout.cells; cell++){
+		snprintf(analysis_label[cell], sizeof(analysis_label[cell]), "%-3s", game_layout.label[cell]);
+		write_text(game_layout.label_x[cell], game_layout.label_y[cell], analysis_label[cell]);
+	}
+	analysis_update();
+}
+
+// Brings the overlay up to date with the game after a key, writing only the
+// labels whose text changed. Empty cells show W or L and the plies to the
+// end for a forced win or loss, D for a draw, and otherwise the search's
+// score in units of a one-stone line.
+void analysis_update(void){
+	int player = (Turn == 'X') ? 1 : 2;
+	unsigned long long key = game_position.hash ^ player;
+	if (!analysis_showing || (analysis_current && key == analysis_key)){
+		return;
+	}
+	bool over = winning_line() >= 0 || game_position.stones == game_position.cells;
+	
+	analysis_stats.updates++;
+	analysis_start = read_timer();
+	analysis_budget = ANALYSIS_BUDGET_TICKS;
+	analysis_aborted = false;
+	analysis_board = game_position;
+	for (int cell = 0; cell < game_layout.cells; cell++){
+		char text[12];
+		if (over || game_position.cell[cell] != 0){
+			snprintf(text, sizeof(text), "%-3s", game_layout.label[cell]);
+		} else {
+			int value = analysis_cell(&analysis_board, cell, player);
+			int empty = game_position.cells - game_position.stones - 1;
+			if (analysis_aborted){
+				snprintf(text, sizeof(text), "?  ");
+			} else if (value > WIN_SCORE - MAX_CELLS - 1 || value < -WIN_SCORE + MAX_CELLS + 1){
+				int plies = WIN_SCORE - abs(value);
+				snprintf(text, sizeof(text), "%c%-2d", (value > 0) ? 'W' : 'L', (plies < 0) ? 0 : (plies > 99 ? 99 : plies));
+			} else if (empty <= ANALYSIS_DEPTH){
+				snprintf(text, sizeof(text), "D  ");
+			} else {
+				int units = value / game_position.shape->line_weight[1];
+				snprintf(text, sizeof(text), "%+d", (units > 99) ? 99 : (units < -99 ? -99 : units));
+			}
+		}
+		text[3] = '\0'; // the width of a label
+		if (strcmp(text, analysis_label[cell]) != 0){
+			strcpy(analysis_label[cell], text);
+			write_text(game_layout.label_x[cell], game_layout.label_y[cell], analysis_label[cell]);
+			analysis_stats.repaints++;
+			game_view_changed();
+		}
+	}
+	
+	analysis_stats.last_ticks = analysis_start - read_timer();
+	if (analysis_aborted){
+		analysis_stats.aborted++;
+	}
+	analysis_key = key;
+	analysis_current = !analysis_aborted;
+}
+
+// Forgets every position searched, for timing the overlay without the table
+void analysis_clear(void){
+	memset(analysis_table, 0, sizeof(analysis_table));
+	analysis_current = false;
+}
+
+// Clears an exhibition board for a new game, the challenger moving first
+static void exhibition_new_game(exhibition_board *b, int wait){
+	engine_init(&b->position, GAME_ROWS, GAME_COLS, GAME_K);
+	b->player = 1;
+	b->wait = wait;
+	b->result = 0;
+	b->line = -1;
+	b->dirty = 0;
+	b->redraw = true;
+}
+
+// Lays out boards in the squarest grid that holds them, above the report
+// row, and starts a game on each, their first moves a few frames apart
+void exhibition_start(int boards){
+	boards = (boards > MAX_EXHIBITION_BOARDS) ? MAX_EXHIBITION_BOARDS : (boards < 1 ? 1 : boards);
+	int cols = 1;
+	while (cols * cols < boards){
+		cols++;
+	}
+	int rows = (boards + cols - 1) / cols;
+	int slot_width = screen.width / cols, slot_height = (screen.height - 8) / rows;
+	
+	exhibition_total = boards;
+	game_view_changed();
+	layout_init(&exhibition_layout, GAME_ROWS, GAME_COLS, GAME_K, 0, 0,
+		slot_width - 2 * EXHIBITION_MARGIN, slot_height - 2 * EXHIBITION_MARGIN);
+	for (int i = 0; i < boards; i++){
+		exhibition_board *b = &exhibition_boards[i];
+		b->left = (i % cols) * slot_width + EXHIBITION_MARGIN;
+		b->top = (i / cols) * slot_height + EXHIBITION_MARGIN;
+		exhibition_new_game(b, EXHIBITION_THINK_FRAMES + 3 * i);
+	}
+	memset(&exhibition_stats, 0, sizeof(exhibition_stats));
+	memset(&exhibition_window, 0, sizeof(exhibition_window));
+	clear_screen();
+	clear_text();
+	exhibition_last_frame = read_timer();
+}
+
+// Puts the game back on screen as it was
+void exhibition_stop(void){
+	draw_game_view();
+	exhibition_total = 0;
+}
+
+// Starts or stops an exhibition when asked and runs its frames on time
+void exhibition_poll(void){
+	int request = exhibition_request;
+	if (request >= 0){
+		exhibition_request = -1;
+		if (request > 0){
+			exhibition_start(request);
+		} else if (exhibition_total > 0){
+			exhibition_stop();
+		}
+	}
+	if (exhibition_total > 0 && exhibition_last_frame - read_timer() >= EXHIBITION_FRAME_TICKS){
+		exhibition_last_frame -= EXHIBITION_FRAME_TICKS;
+		if (exhibition_last_frame - read_timer() >= EXHIBITION_FRAME_TICKS){
+			exhibition_last_frame = read_timer(); // too far behind to catch up
+		}
+		exhibition_frame();
+	}
+}
+
+// The layout line through cell that the stone on it completed
+static int exhibition_line(exhibition_board *b, int cell){
+	int player = b->position.cell[cell];
+	for (int line = 0; line < exhibition_layout.line_total; line++){
+		unsigned char *cells = exhibition_layout.line_cell[line];
+		bool through = false, complete = true;
+		for (int i = 0; i < exhibition_layout.k; i++){
+			through |= cells[i] == cell;
+			complete &= b->position.cell[cells[i]] == player;
+		}
+		if (through && complete){
+			return line;
+		}
+	}
+	return -1;
+}
+
+static void exhibition_play(exhibition_board *b, int cell){
+	int player = b->player;
+	
+	engine_play(&b->position, cell, player);
+	b->dirty |= 1u << cell;
+	exhibition_stats.moves++;
+	exhibition_window.moves++;
+	if (engine_is_win(&b->position, cell)){
+		b->result = player;
+		b->line = exhibition_line(b, cell);
+		b->redraw = true; // the stroke crosses the grid
+	} else if (b->position.stones == b->position.cells){
+		b->result = 3;
+	}
+	
+	if (b->result != 0){
+		b->wait = EXHIBITION_RESTART_FRAMES;
+		exhibition_stats.games++;
+		exhibition_window.games++;
+	} else {
+		b->player = 3 - player;
+		b->wait = (b->player == 1) ? EXHIBITION_THINK_FRAMES : 0;
+	}
+}
+
+// The engine's move on b: the cell with the best analysis value
+static int exhibition_engine_move(mnk_board *b){
+	unsigned char moves[MAX_CELLS];
+	int count = generate_moves(b, moves), best = -1, best_value = -INFINITY_SCORE;
+	
+	for (int i = 0; i < count; i++){
+		int value = analysis_cell(b, moves[i], 2);
+		if (analysis_aborted){
+			return -1;
+		}
+		if (value > best_value){
+			best_value = value;
+			best = moves[i];
+		}
+	}
+	return best;
+}
+
+// Engine moves for every board waiting on it, as one batch. The searches
+// share the analysis table, so a position any board has been through costs
+// nothing, and boards in the same position share one search. Boards the
+// budget doesn't reach keep waiting until the next frame.
+static void exhibition_ai_batch(void){
+	unsigned long long decided_hash[MAX_EXHIBITION_BOARDS];
+	int decided_move[MAX_EXHIBITION_BOARDS], decided = 0;
+	
+	analysis_start = read_timer();
+	analysis_budget = EXHIBITION_AI_TICKS;
+	analysis_aborted = false;
+	for (int i = 0; i < exhibition_total; i++){
+		exhibition_board *b = &exhibition_boards[i];
+		if (b->result != 0 || b->player != 2){
+			continue;
+		}
+		int move = -1;
+		for (int j = 0; j < decided && move < 0; j++){
+			if (decided_hash[j] == b->position.hash){
+				move = decided_move[j];
+			}
+		}
+		if (move < 0){
+			move = exhibition_engine_move(&b->position);
+			if (move < 0){
+				exhibition_stats.deferred++;
+				exhibition_window.deferred++;
+				continue;
+			}
+			decided_hash[decided] = b->position.hash;
+			decided_move[decided++] = move;
+		}
+		exhibition_play(b, move);
+	}
+}
+
+// The frame's one drawing pass: whole boards where a game started or ended,
+// otherwise only the cells that changed
+static void exhibition_draw(void){
+	board_layout *l = &exhibition_layout;
+	int width = l->cols * l->cell_width, height = l->rows * l->cell_height;
+	
+	for (int i = 0; i < exhibition_total; i++){
+		exhibition_board *b = &exhibition_boards[i];
+		if (b->redraw){
+			fill_rect(b->left - 1, b->top - 1, width + 3, height + 3, 0x0000);
+			for (int g = 0; g < l->grid_total; g++){
+				segment *s = &l->grid[g];
+				draw_thick_segment(b->left + s->x0, b->top + s->y0, b->left + s->x1, b->top + s->y1, 0xFFFF);
+			}
+			for (int cell = 0; cell < l->cells; cell++){
+				if (b->position.cell[cell] != 0){
+					draw_mark(l, b->left, b->top, cell, b->position.cell[cell]);
+				}
+			}
+			if (b->line >= 0){
+				segment *w = &l->win_line[b->line];
+				draw_thick_segment(b->left + w->x0, b->top + w->y0, b->left + w->x1, b->top + w->y1, 0xF800);
+			}
+		} else {
+			for (unsigned int dirty = b->dirty; dirty != 0; dirty &= dirty - 1){
+				int cell = __builtin_ctz(dirty);
+				fill_rect(b->left + l->cell_x[cell] + 2, b->top + l->cell_y[cell] + 2, l->cell_width - 3, l->cell_height - 3, 0x0000);
+				if (b->position.cell[cell] != 0){
+					draw_mark(l, b->left, b->top, cell, b->position.cell[cell]);
+				}
+			}
+		}
+		b->dirty = 0;
+		b->redraw = false;
+	}
+}
+
+// Adds a frame's times to a set of counters
+static void exhibition_count(exhibition_counters *c, unsigned int ticks, unsigned int ai_ticks, unsigned int draw_ticks){
+	c->frames++;
+	c->total_ticks += ticks;
+	c->ai_ticks += ai_ticks;
+	c->draw_ticks += draw_ticks;
+	if (ticks > c->max_ticks){
+		c->max_ticks = ticks;
+	}
+}
+
+// One frame: challengers whose pause is over move and finished games are
+// cleared, the engine answers every board waiting on it, then everything
+// that changed is drawn. Every EXHIBITION_REPORT_FRAMES the bottom row gets
+// the average and longest frame since the last report.
+void exhibition_frame(void){
+	unsigned int start = read_timer();
+	
+	for (int i = 0; i < exhibition_total; i++){
+		exhibition_board *b = &exhibition_boards[i];
+		if (b->wait > 0){
+			b->wait--;
+		} else if (b->result != 0){
+			exhibition_new_game(b, EXHIBITION_THINK_FRAMES);
+		} else if (b->player == 1){
+			unsigned char moves[MAX_CELLS];
+			exhibition_play(b, moves[rand() % generate_moves(&b->position, moves)]);
+		}
+	}
+	
+	unsigned int ai_start = read_timer();
+	exhibition_ai_batch();
+	unsigned int draw_start = read_timer();
+	exhibition_draw();
+	unsigned int end = read_timer();
+	
+	exhibition_count(&exhibition_stats, start - end, ai_start - draw_start, draw_start - end);
+	exhibition_count(&exhibition_window, start - end, ai_start - draw_start, draw_start - end);
+	if (exhibition_window.frames == EXHIBITION_REPORT_FRAMES){
+		exhibition_counters *w = &exhibition_window;
+		unsigned int us = TIMER_HZ / 1000000;
+		char line[81];
+		snprintf(line, sizeof(line), "%2d boards: frame %5u us, max %5u, ai %5u, draw %5u, %u games   ", exhibition_total,
+			(unsigned int) (w->total_ticks / w->frames / us), w->max_ticks / us, (unsigned int) (w->ai_ticks / w->frames / us),
+			(unsigned int) (w->draw_ticks / w->frames / us), exhibition_stats.games);
+		write_text(0, EXHIBITION_REPORT_ROW, line);
+		memset(w, 0, sizeof(*w));
+	}
+}
+
+// Builds ultimate_wins from the same line table the 3x3 game is checked with
+static void ultimate_tables(void){
+	static board_layout three; // only its lines are used
+	
+	layout_init(&three, 3, 3, 3, 0, 0, 3, 3);
+	for (int mask = 0; mask < 512; mask++){
+		ultimate_wins[mask] = false;
+		for (int line = 0; line < three.line_total; line++){
+			unsigned char *cells = three.line_cell[line];
+			unsigned int bits = 1u << cells[0] | 1u << cells[1] | 1u << cells[2];
+			ultimate_wins[mask] |= (mask & bits) == bits;
+		}
+	}
+}
+
+// Sets up an empty ultimate board, X to move anywhere
+void ultimate_init(ultimate_board *u){
+	if (!ultimate_wins[0x007]){
+		ultimate_tables();
+	}
+	memset(u, 0, sizeof(*u));
+	u->next = -1;
+	u->player = 1;
+}
+
+// Lists the legal moves, returns how many
+int ultimate_moves(const ultimate_board *u, unsigned char *moves){
+	unsigned int boards = (u->next >= 0) ? 1u << u->next : ~u->closed & 0x1FF;
+	int count = 0;
+	
+	if (u->result != 0){
+		return 0;
+	}
+	for (; boards != 0; boards &= boards - 1){
+		int board = __builtin_ctz(boards);
+		for (unsigned int empty = ~(u->cells[0][board] | u->cells[1][board]) & 0x1FF; empty != 0; empty &= empty - 1){
+			moves[count++] = board * 9 + __builtin_ctz(empty);
+		}
+	}
+	return count;
+}
+
+// Plays a legal move for the side to move. The meta-board is only tested
+// when a board has just been won.
+void ultimate_play(ultimate_board *u, int move){
+	int board = move / 9, cell = move % 9, side = u->player - 1;
+	unsigned int mine = u->cells[side][board] |= 1u << cell;
+	
+	if (ultimate_wins[mine]){
+		u->won[side] |= 1u << board;
+		u->closed |= 1u << board;
+		if (ultimate_wins[u->won[side]]){
+			u->result = u->player;
+		}
+	} else if ((mine | u->cells[!side][board]) == 0x1FF){
+		u->closed |= 1u << board;
+	}
+	if (u->result == 0 && u->closed == 0x1FF){
+		u->result = 3;
+	}
+	u->next = (u->closed & (1u << cell)) ? -1 : cell;
+	u->player = 3 - u->player;
+	u->moves++;
+}
+
+// xorshift32, then a multiply to pick below count: the A9 has no divide
+static inline int ultimate_random(unsigned int *seed, int count){
+	*seed ^= *seed << 13;
+	*seed ^= *seed >> 17;
+	*seed ^= *seed << 5;
+	return (int) (((unsigned long long) *seed * count) >> 32);
+}
+
+// Plays random moves to the end of the game, returns the result
+int ultimate_playout(ultimate_board *u, unsigned int *seed){
+	unsigned char moves[ULTIMATE_CELLS];
+	
+	while (u->result == 0){
+		ultimate_play(u, moves[ultimate_random(seed, ultimate_moves(u, moves))]);
+	}
+	return u->result;
+}
+
+// Rough log2 and 1 / sqrt from the float's bits, good enough for UCT; the
+// game doesn't link the maths library
+static inline float ultimate_log2(float x){
+	union { float f; unsigned int i; } v = {x};
+	return v.i * (1.0f / (1 << 23)) - 127.0f;
+}
+
+static inline float ultimate_rsqrt(float x){
+	union { float f; unsigned int i; } v = {x};
+	v.i = 0x5F3759DF - (v.i >> 1);
+	return v.f * (1.5f - 0.5f * x * v.f * v.f);
+}
+
+// The child of parent with the best UCT value, an unvisited one first
+static int ultimate_select(int parent){
+	ultimate_node *p = &ultimate_tree[parent];
+	float log_visits = ultimate_log2((float) p->visits);
+	float explore = ULTIMATE_EXPLORATION * log_visits * ultimate_rsqrt(log_visits);
+	int best = p->first_child;
+	float best_value = -1.0f;
+	
+	for (int child = p->first_child; child < p->first_child + p->child_total; child++){
+		ultimate_node *c = &ultimate_tree[child];
+		if (c->visits == 0){
+			return child;
+		}
+		float value = c->score * 0.5f / c->visits + explore * ultimate_rsqrt((float) c->visits);
+		if (value > best_value){
+			best_value = value;
+			best = child;
+		}
+	}
+	return best;
+}
+
+// Gives node a child for every legal move, if the tree has room
+static bool ultimate_expand(int node, const ultimate_board *u){
+	unsigned char moves[ULTIMATE_CELLS];
+	int count = ultimate_moves(u, moves);
+	
+	if (ultimate_tree_total + count > ULTIMATE_TREE_SIZE){
+		return false;
+	}
+	ultimate_tree[node].first_child = ultimate_tree_total;
+	ultimate_tree[node].child_total = count;
+	for (int i = 0; i < count; i++){
+		ultimate_tree[ultimate_tree_total++] = (ultimate_node) {-1, 0, 0, moves[i], 0};
+	}
+	return true;
+}
+
+// Monte Carlo tree search from root for budget_ticks, or until the tree is
+// full. Every iteration walks down the tree by UCT, grows it by one node's
+// children, plays one random game from there and scores it back up the path.
+// Returns the most visited move.
+int ultimate_search(const ultimate_board *root, unsigned int budget_ticks){
+	unsigned int start = read_timer(), playouts = 0;
+	
+	ultimate_tree[0] = (ultimate_node) {-1, 0, 0, 0, 0};
+	ultimate_tree_total = 1;
+	ultimate_expand(0, root);
+	if (ultimate_tree[0].child_total == 1){
+		return ultimate_tree[1].move;
+	}
+	
+	while (start - read_timer() < budget_ticks){
+		ultimate_board u = *root;
+		int path[ULTIMATE_CELLS + 1], depth = 0, node = 0;
+		
+		path[depth++] = 0;
+		while (ultimate_tree[node].first_child >= 0 && u.result == 0){
+			node = ultimate_select(node);
+			ultimate_play(&u, ultimate_tree[node].move);
+			path[depth++] = node;
+		}
+		if (u.result == 0 && ultimate_tree[node].visits > 0 && ultimate_expand(node, &u)){
+			node = ultimate_select(node);
+			ultimate_play(&u, ultimate_tree[node].move);
+			path[depth++] = node;
+		}
+		int result = ultimate_playout(&u, &ultimate_seed);
+		playouts++;
+		
+		// Odd depths are the root player's moves
+		for (int i = 0; i < depth; i++){
+			int mover = (i % 2 == 1) ? root->player : 3 - root->player;
+			ultimate_tree[path[i]].visits++;
+			ultimate_tree[path[i]].score += (result == 3) ? 1 : (result == mover) ? 2 : 0;
+		}
+		if (ultimate_tree_total + ULTIMATE_CELLS > ULTIMATE_TREE_SIZE){
+			break;
+		}
+	}
+	
+	int best = 1;
+	for (int child = 1; child <= ultimate_tree[0].child_total; child++){
+		if (ultimate_tree[child].visits > ultimate_tree[best].visits){
+			best = child;
+		}
+	}
+	ultimate_stats.searches++;
+	ultimate_stats.playouts = playouts;
+	ultimate_stats.nodes = ultimate_tree_total;
+	ultimate_stats.ticks = start - read_timer();
+	ultimate_stats.total_playouts += playouts;
+	ultimate_stats.total_ticks += ultimate_stats.ticks;
+	return ultimate_tree[best].move;
+}
+
+// Screen cell of an ultimate move: boards row by row, cells within them
+static int ultimate_layout_cell(int move){
+	int board = move / 9, cell = move % 9;
+	return ((board / 3) * 3 + cell / 3) * 9 + (board % 3) * 3 + cell % 3;
+}
+
+// Draws one board inside the thick lines around it: its thin grid and stones,
+// or a large mark once it is won, and a red frame if the next move may be
+// played on it
+static void ultimate_draw_board(int board){
+	board_layout *l = &ultimate_layout;
+	const ultimate_board *u = &ultimate_game;
+	int x = ultimate_meta_layout.cell_x[board], y = ultimate_meta_layout.cell_y[board];
+	int width = 3 * l->cell_width, height = 3 * l->cell_height;
+	bool open = u->result == 0 && (u->next == board || (u->next < 0 && !(u->closed & (1u << board))));
+	
+	fill_rect(x + 2, y + 2, width - 3, height - 3, 0x0000);
+	if (u->won[0] & (1u << board) || u->won[1] & (1u << board)){
+		draw_mark(&ultimate_meta_layout, 0, 0, board, (u->won[0] & (1u << board)) ? 1 : 2);
+		return;
+	}
+	for (int i = 1; i < 3; i++){
+		draw_line(x + i * l->cell_width, y + 2, x + i * l->cell_width, y + height - 2, 0xFFFF);
+		draw_line(x + 2, y + i * l->cell_height, x + width - 2, y + i * l->cell_height, 0xFFFF);
+	}
+	for (int cell = 0; cell < 9; cell++){
+		for (int side = 0; side < 2; side++){
+			if (u->cells[side][board] & (1u << cell)){
+				draw_mark(l, 0, 0, ultimate_layout_cell(board * 9 + cell), side + 1);
+			}
+		}
+	}
+	if (open){
+		short int colour = (board == ultimate_pick) ? 0x07E0 : 0xF800;
+		draw_line(x + 3, y + 3, x + width - 3, y + 3, colour);
+		draw_line(x + 3, y + height - 3, x + width - 3, y + height - 3, colour);
+		draw_line(x + 3, y + 3, x + 3, y + height - 3, colour);
+		draw_line(x + width - 3, y + 3, x + width - 3, y + height - 3, colour);
+	}
+}
+
+// Shows whose move it is or how the game ended, and the engine's last search
+static void ultimate_status(void){
+	const ultimate_board *u = &ultimate_game;
+	char status[81];
+	
+	if (u->result != 0){
+		snprintf(status, sizeof(status), "%-40s", (u->result == 3) ? "Tie game! [Space] for a new one" :
+			(u->result == 1) ? "Player X wins! [Space] for a new one" : "Player O wins! [Space] for a new one");
+	} else if (u->next < 0 && ultimate_pick < 0){
+		snprintf(status, sizeof(status), "%-40s", "Your move: pick a board [1-9]");
+	} else {
+		snprintf(status, sizeof(status), "Your move: a cell [1-9] on board %-7d", ((u->next >= 0) ? u->next : ultimate_pick) + 1);
+	}
+	write_text(14, ULTIMATE_STATUS_ROW, status);
+	
+	if (ultimate_stats.searches > 0){
+		unsigned int ms = ultimate_stats.ticks / (TIMER_HZ / 1000);
+		snprintf(status, sizeof(status), "AI: %u playouts, %u nodes in %u ms     ", ultimate_stats.playouts, ultimate_stats.nodes, ms);
+		write_text(14, ULTIMATE_STATUS_ROW + 2, status);
+	}
+}
+
+// Draws the whole ultimate screen
+void ultimate_draw(void){
+	board_layout *m = &ultimate_meta_layout;
+	
+	clear_screen();
+	clear_text();
+	for (int i = 0; i < m->grid_total; i++){
+		segment *g = &m->grid[i];
+		draw_thick_segment(g->x0, g->y0, g->x1, g->y1, 0xFFFF);
+	}
+	for (int board = 0; board < 9; board++){
+		ultimate_draw_board(board);
+	}
+	ultimate_status();
+}
+
+// Switches between the game and an ultimate game against the engine, which
+// picks up where it was left
+void ultimate_toggle(void){
+	game_view_changed();
+	ultimate_showing = !ultimate_showing;
+	if (!ultimate_showing){
+		draw_game_view();
+		return;
+	}
+	if (ultimate_layout.cells == 0){
+		int size = screen.height - 2 * BOARD_MARGIN - 16; // room for the status rows
+		int left = (screen.width - size) / 2;
+		layout_init(&ultimate_layout, 9, 9, 3, left, BOARD_MARGIN / 2, size, size);
+		layout_init(&ultimate_meta_layout, 3, 3, 3, left, BOARD_MARGIN / 2, 9 * ultimate_layout.cell_width, 9 * ultimate_layout.cell_height);
+		ultimate_init(&ultimate_game);
+	}
+	ultimate_draw();
+}
+
+// Plays a move on the ultimate game and redraws the boards it changed: its
+// own and every board that was or now is open to the next move
+static void ultimate_move(int move){
+	unsigned int before = (ultimate_game.next >= 0) ? 1u << ultimate_game.next : ~ultimate_game.closed & 0x1FF;
+	
+	ultimate_play(&ultimate_game, move);
+	unsigned int after = (ultimate_game.next >= 0) ? 1u << ultimate_game.next : ~ultimate_game.closed & 0x1FF;
+	unsigned int dirty = (before | after | 1u << (move / 9)) & 0x1FF;
+	if (ultimate_game.result != 0){
+		dirty = 0x1FF; // no board is open any more
+		audio_play((ultimate_game.result == 3) ? AUDIO_TIE : AUDIO_WIN);
+	} else {
+		audio_play(AUDIO_CLICK);
+	}
+	for (; dirty != 0; dirty &= dirty - 1){
+		ultimate_draw_board(__builtin_ctz(dirty));
+	}
+}
+
+// Keys while the ultimate game is up: [V] leaves, [Space] starts a new game
+// and number keys choose a board when any open one may be played, then a
+// cell. The engine answers straight away.
+void ultimate_key(unsigned char byte0){
+	ultimate_board *u = &ultimate_game;
+	
+	if (byte0 == 0x2A){
+		ultimate_toggle();
+		return;
+	}
+	if (byte0 == 0x29){
+		ultimate_init(u);
+		ultimate_pick = -1;
+		ultimate_draw();
+		return;
+	}
+	int number = number_key_cell[byte0] - 1;
+	if (number < 0 || u->result != 0 || u->player != 1){
+		return;
+	}
+	
+	if (u->next < 0 && ultimate_pick < 0){
+		if (!(u->closed & (1u << number))){
+			ultimate_pick = number;
+			ultimate_draw_board(number);
+			ultimate_status();
+		}
+		return;
+	}
+	int board = (u->next >= 0) ? u->next : ultimate_pick;
+	if ((u->cells[0][board] | u->cells[1][board]) & (1u << number)){
+		return;
+	}
+	ultimate_pick = -1;
+	ultimate_move(board * 9 + number);
+	if (u->result == 0){
+		ultimate_move(ultimate_search(u, AI_BUDGET_TICKS));
+	}
+	ultimate_status();
+}
+
+// Builds the 76 lines: every direction with its first non-zero step
+// positive, from every start whose fourth cell is still inside the cube
+static void qubic_tables(void){
+	int total = 0;
+	
+	memset(qubic_cell_line_total, 0, sizeof(qubic_cell_line_total));
+	for (int d = 0; d < 27; d++){
+		int dx = d % 3 - 1, dy = d / 3 % 3 - 1, dz = d / 9 - 1;
+		int first = (dz != 0) ? dz : (dy != 0 ? dy : dx);
+		if (first <= 0){
+			continue;
+		}
+		for (int cell = 0; cell < QUBIC_CELLS; cell++){
+			int x = cell % 4, y = cell / 4 % 4, z = cell / 16;
+			int end_x = x + 3 * dx, end_y = y + 3 * dy, end_z = z + 3 * dz;
+			if (end_x < 0 || end_x > 3 || end_y < 0 || end_y > 3 || end_z < 0 || end_z > 3){
+				continue;
+			}
+			unsigned long long mask = 0;
+			for (int i = 0; i < 4; i++){
+				int c = (z + i * dz) * 16 + (y + i * dy) * 4 + x + i * dx;
+				mask |= 1ULL << c;
+				qubic_cell_lines[c][qubic_cell_line_total[c]++] = total;
+			}
+			qubic_line[total++] = mask;
+		}
+	}
+	
+	qubic_strong = 0;
+	for (int cell = 0; cell < QUBIC_CELLS; cell++){
+		if (qubic_cell_line_total[cell] == QUBIC_MAX_LINES_PER_CELL){
+			qubic_strong |= 1ULL << cell;
+		}
+	}
+}
+
+// Sets up an empty cube, X to move
+void qubic_init(qubic_board *b){
+	if (qubic_line[0] == 0){
+		qubic_tables();
+	}
+	memset(b, 0, sizeof(*b));
+	b->player = 1;
+	b->line = -1;
+}
+
+// Whether the stone on cell completes one of the lines through it
+bool qubic_is_win(unsigned long long stones, int cell){
+	for (int i = 0; i < qubic_cell_line_total[cell]; i++){
+		unsigned long long line = qubic_line[qubic_cell_lines[cell][i]];
+		if ((stones & line) == line){
+			return true;
+		}
+	}
+	return false;
+}
+
+// Plays an empty cell for the side to move
+void qubic_play(qubic_board *b, int cell){
+	unsigned long long *mine = &b->stones[b->player - 1];
+	
+	*mine |= 1ULL << cell;
+	b->moves++;
+	if (qubic_is_win(*mine, cell)){
+		b->result = b->player;
+		for (int i = 0; i < qubic_cell_line_total[cell]; i++){
+			unsigned long long line = qubic_line[qubic_cell_lines[cell][i]];
+			if ((*mine & line) == line){
+				b->line = qubic_cell_lines[cell][i];
+			}
+		}
+	} else if (b->moves == QUBIC_CELLS){
+		b->result = 3;
+	}
+	b->player = 3 - b->player;
+}
+
+// Empty cells on the lines where mine has count stones and theirs none. With
+// count 3 these are the cells that win at once, found without counting: the
+// line's one cell mine doesn't hold.
+unsigned long long qubic_open_cells(unsigned long long mine, unsigned long long theirs, int count){
+	unsigned long long cells = 0;
+	
+	for (int i = 0; i < QUBIC_LINES; i++){
+		unsigned long long line = qubic_line[i], rest = line & ~mine;
+		if ((line & theirs) != 0){
+			continue;
+		}
+		if ((count == 3) ? rest != 0 && (rest & (rest - 1)) == 0 : __builtin_popcountll(line & mine) == count){
+			cells |= rest;
+		}
+	}
+	return cells;
+}
+
+// Open lines weighted by how full they are, from mine's point of view
+int qubic_evaluate(unsigned long long mine, unsigned long long theirs){
+	static const int weight[4] = {0, 1, 8, 64};
+	int score = 0;
+	
+	for (int i = 0; i < QUBIC_LINES; i++){
+		unsigned long long line = qubic_line[i];
+		unsigned long long my_part = line & mine, their_part = line & theirs;
+		if (their_part == 0){
+			score += weight[__builtin_popcountll(my_part)];
+		} else if (my_part == 0){
+			score -= weight[__builtin_popcountll(their_part)];
+		}
+	}
+	return score;
+}
+
+// Alpha-beta over the two stone masks, side to move first, so a move is one
+// OR and nothing is undone. A line of three the side to move can finish wins
+// at once; two such lines of the opponent's lose; one must be blocked.
+// Children that make a three are tried first, then cells on seven lines.
+int qubic_negamax(unsigned long long mine, unsigned long long theirs, int depth, int alpha, int beta, int ply){
+	qubic_stats.nodes++;
+	if ((qubic_stats.nodes & 1023) == 0 && qubic_start - read_timer() > qubic_budget){
+		qubic_aborted = true;
+	}
+	if (qubic_aborted){
+		return 0;
+	}
+	
+	unsigned long long empty = ~(mine | theirs);
+	if (qubic_open_cells(mine, theirs, 3) != 0){
+		return QUBIC_WIN_SCORE - ply;
+	}
+	unsigned long long forced = qubic_open_cells(theirs, mine, 3);
+	if ((forced & (forced - 1)) != 0){
+		return -(QUBIC_WIN_SCORE - ply - 1);
+	}
+	if (empty == 0){
+		return 0;
+	}
+	if (depth == 0){
+		return qubic_evaluate(mine, theirs);
+	}
+	
+	unsigned long long candidates = (forced != 0) ? forced : empty;
+	unsigned long long threes = candidates & qubic_open_cells(mine, theirs, 2);
+	unsigned long long order[3] = {threes, candidates & ~threes & qubic_strong, candidates & ~threes & ~qubic_strong};
+	int best = -INFINITY_SCORE;
+	for (int pass = 0; pass < 3; pass++){
+		for (unsigned long long moves = order[pass]; moves != 0; moves &= moves - 1){
+			unsigned long long bit = moves & -moves;
+			int score = -qubic_negamax(theirs, mine | bit, depth - 1, -beta, -alpha, ply + 1);
+			if (qubic_aborted){
+				return 0;
+			}
+			if (score > best){
+				best = score;
+			}
+			if (score > alpha){
+				alpha = score;
+			}
+			if (alpha >= beta){
+				return best;
+			}
+		}
+	}
+	return best;
+}
+
+// Iterative deepening within budget_ticks, returns the best move of the last
+// depth that finished, or -1 if the cube is full. The previous depth's best
+// move is searched first.
+int qubic_search(const qubic_board *b, unsigned int budget_ticks){
+	unsigned long long mine = b->stones[b->player - 1], theirs = b->stones[2 - b->player];
+	unsigned long long empty = ~(mine | theirs);
+	unsigned char moves[QUBIC_CELLS];
+	int count = 0, best;
+	
+	qubic_start = read_timer();
+	qubic_budget = budget_ticks;
+	qubic_aborted = false;
+	qubic_stats.nodes = 0;
+	qubic_stats.depth = 0;
+	
+	// Winning, then forced, moves need no search
+	unsigned long long wins = qubic_open_cells(mine, theirs, 3), forced = qubic_open_cells(theirs, mine, 3);
+	unsigned long long candidates = (wins != 0) ? wins : (forced != 0 ? forced : empty);
+	unsigned long long order[2] = {candidates & qubic_strong, candidates & ~qubic_strong};
+	for (int pass = 0; pass < 2; pass++){
+		for (unsigned long long m = order[pass]; m != 0; m &= m - 1){
+			moves[count++] = __builtin_ctzll(m);
+		}
+	}
+	if (count == 0){
+		return -1;
+	}
+	best = moves[0];
+	
+	for (int depth = 1; count > 1 && depth <= QUBIC_MAX_DEPTH && depth <= __builtin_popcountll(empty); depth++){
+		int alpha = -INFINITY_SCORE, depth_best = -1;
+		for (int i = 0; i < count; i++){
+			int score = -qubic_negamax(theirs, mine | 1ULL << moves[i], depth - 1, -INFINITY_SCORE, -alpha, 1);
+			if (qubic_aborted){
+				break;
+			}
+			if (score > alpha){
+				alpha = score;
+				depth_best = i;
+			}
+		}
+		if (qubic_aborted || depth_best < 0){
+			break;
+		}
+		best = moves[depth_best];
+		qubic_stats.depth = depth;
+		qubic_stats.score = alpha;
+		for (int i = depth_best; i > 0; i--){
+			moves[i] = moves[i - 1];
+		}
+		moves[0] = best;
+		if (alpha >= QUBIC_WIN_SCORE - QUBIC_MAX_DEPTH || alpha <= -(QUBIC_WIN_SCORE - QUBIC_MAX_DEPTH)){
+			break; // decided
+		}
+	}
+	
+	qubic_stats.searches++;
+	qubic_stats.ticks = qubic_start - read_timer();
+	qubic_stats.total_nodes += qubic_stats.nodes;
+	qubic_stats.total_ticks += qubic_stats.ticks;
+	return best;
+}
+
+// Screen centre of a cell. Layers are stacked evenly, so the centres of a
+// line's cells are on one straight line on screen too.
+static void qubic_cell_centre(int cell, int *x, int *y){
+	board_layout *l = &qubic_layer_layout[cell / 16];
+	*x = l->cell_x[cell % 16] + l->cell_width / 2;
+	*y = l->cell_y[cell % 16] + l->cell_height / 2;
+}
+
+// Shows whose move it is or how the game ended, and the engine's last search,
+// to the right of the layers
+static void qubic_status(void){
+	const qubic_board *b = &qubic_game;
+	int col = (qubic_layer_layout[0].left + 4 * qubic_layer_layout[0].cell_width) / screen.char_width + 3;
+	char text[40];
+	
+	snprintf(text, sizeof(text), "%-18s", (b->result == 0) ? "Your move (X)" : (b->result == 1) ? "Player X wins!" :
+		(b->result == 2) ? "Player O wins!" : "Tie game!");
+	write_text(col, 10, text);
+	write_text(col, 12, (b->result == 0) ? "                  " : "[Space]: new game ");
+	if (qubic_stats.searches > 0){
+		snprintf(text, sizeof(text), "AI: depth %-8d", qubic_stats.depth);
+		write_text(col, 16, text);
+		snprintf(text, sizeof(text), "%u nodes        ", qubic_stats.nodes);
+		write_text(col, 18, text);
+		snprintf(text, sizeof(text), "%u ms        ", qubic_stats.ticks / (TIMER_HZ / 1000));
+		write_text(col, 20, text);
+	}
+}
+
+// Draws the four layers, their stones, the cursor and any winning line
+void qubic_draw(void){
+	clear_screen();
+	clear_text();
+	for (int z = 0; z < 4; z++){
+		board_layout *l = &qubic_layer_layout[z];
+		for (int i = 0; i <= 4; i++){
+			draw_line(l->left + i * l->cell_width, l->top, l->left + i * l->cell_width, l->top + 4 * l->cell_height, 0xFFFF);
+			draw_line(l->left, l->top + i * l->cell_height, l->left + 4 * l->cell_width, l->top + i * l->cell_height, 0xFFFF);
+		}
+		char layer[8];
+		snprintf(layer, sizeof(layer), "%d", z + 1);
+		write_text(l->left / screen.char_width - 3, (l->top + 2 * l->cell_height) / screen.char_height, layer);
+	}
+	for (int cell = 0; cell < QUBIC_CELLS; cell++){
+		for (int side = 0; side < 2; side++){
+			if (qubic_game.stones[side] & (1ULL << cell)){
+				draw_mark(&qubic_layer_layout[cell / 16], 0, 0, cell % 16, side + 1);
+			}
+		}
+	}
+	draw_layout_box(&qubic_layer_layout[qubic_cursor / 16], qubic_cursor % 16, 0xF800);
+	if (qubic_game.line >= 0){
+		unsigned long long line = qubic_line[qubic_game.line];
+		int x0, y0, x1, y1;
+		qubic_cell_centre(__builtin_ctzll(line), &x0, &y0);
+		qubic_cell_centre(63 - __builtin_clzll(line), &x1, &y1);
+		draw_thick_segment(x0, y0, x1, y1, 0xF800);
+	}
+	qubic_status();
+}
+
+// Switches between the game and a Qubic game against the engine, which
+// picks up where it was left
+void qubic_toggle(void){
+	game_view_changed();
+	qubic_showing = !qubic_showing;
+	if (!qubic_showing){
+		draw_game_view();
+		return;
+	}
+	if (qubic_layer_layout[0].cells == 0){
+		int layer_height = (screen.height - 16 - 3 * QUBIC_LAYER_GAP) / 4;
+		int width = screen.width * 9 / 20, left = screen.width / 8;
+		for (int z = 0; z < 4; z++){
+			layout_init(&qubic_layer_layout[z], 4, 4, 4, left, 8 + z * (layer_height + QUBIC_LAYER_GAP), width, layer_height);
+		}
+		qubic_init(&qubic_game);
+	}
+	qubic_draw();
+}
+
+// Draws a move just played, and the winning line if it ended the game
+static void qubic_move(int cell){
+	int player = qubic_game.player;
+	
+	qubic_play(&qubic_game, cell);
+	draw_mark(&qubic_layer_layout[cell / 16], 0, 0, cell % 16, player);
+	if (qubic_game.result != 0){
+		qubic_draw();
+		audio_play((qubic_game.result == 3) ? AUDIO_TIE : AUDIO_WIN);
+	} else {
+		audio_play(AUDIO_CLICK);
+	}
+}
+
+// Keys while Qubic is up: [W] and [S] move the cursor a row, on to the next
+// layer at the edge, [A] and [D] a column, [Enter] plays, [Space] starts a
+// new game and [Q] leaves. The engine answers straight away.
+void qubic_key(unsigned char byte0){
+	qubic_board *b = &qubic_game;
+	
+	if (byte0 == 0x15){
+		qubic_toggle();
+		return;
+	}
+	if (byte0 == 0x29){
+		qubic_init(b);
+		qubic_draw();
+		return;
+	}
+	if (byte0 == 0x1D || byte0 == 0x1B || byte0 == 0x1C || byte0 == 0x23){
+		int step = (byte0 == 0x1D) ? -4 : (byte0 == 0x1B) ? 4 : 0;
+		int col = qubic_cursor % 4;
+		if (byte0 == 0x1C || byte0 == 0x23){
+			col = (col + ((byte0 == 0x1C) ? 3 : 1)) % 4;
+		}
+		draw_layout_box(&qubic_layer_layout[qubic_cursor / 16], qubic_cursor % 16, 0xFFFF);
+		qubic_cursor = ((qubic_cursor - qubic_cursor % 4 + step + QUBIC_CELLS) % QUBIC_CELLS) + col;
+		draw_layout_box(&qubic_layer_layout[qubic_cursor / 16], qubic_cursor % 16, 0xF800);
+		return;
+	}
+	if (byte0 != 0x5A || b->result != 0 || b->player != 1 || ((b->stones[0] | b->stones[1]) & (1ULL << qubic_cursor))){
+		return;
+	}
+	qubic_move(qubic_cursor);
+	if (b->result == 0){
+		qubic_move(qubic_search(b, AI_BUDGET_TICKS));
+	}
+	qubic_status();
+}
+
+// Adds a square wave note that fades out to a clip, returns its length
+int audio_note(short *samples, int length, int frequency, int amplitude){
+	unsigned int phase = 0, step = (unsigned int) ((frequency * 65536ULL) / AUDIO_RATE);
+	
+	for (int i = 0; i < length; i++, phase += step){
+		int level = amplitude * (length - i) / length;
+		samples[i] = (phase & 0x8000) ? level : -level;
+	}
+	return length;
+}
+
+// Generates the clips: a short tick for a move, a rising C major arpeggio for
+// a win and two falling notes for a tie
+void audio_init(void){
+	short *p = audio_clip_data;
+	
+	audio_clip_start[AUDIO_CLICK] = p;
+	p += audio_note(p, AUDIO_RATE / 50, 1500, 6000);
+	
+	audio_clip_start[AUDIO_WIN] = p;
+	p += audio_note(p, AUDIO_RATE / 8, 523, 8000);
+	p += audio_note(p, AUDIO_RATE / 8, 659, 8000);
+	p += audio_note(p, AUDIO_RATE / 4, 784, 8000);
+	
+	audio_clip_start[AUDIO_TIE] = p;
+	p += audio_note(p, AUDIO_RATE / 6, 392, 8000);
+	p += audio_note(p, AUDIO_RATE / 6, 330, 8000);
+	
+	for (int c = 0; c < AUDIO_CLIPS; c++){
+		const short *end = (c + 1 < AUDIO_CLIPS) ? audio_clip_start[c + 1] : p;
+		audio_clip_length[c] = end - audio_clip_start[c];
+	}
+}
+
+// Asks for a clip to be played. Safe to call from an interrupt handler: the
+// clip starts at the next audio_pump, which the main loop only reaches once
+// the handler returns. A click asked for by the keyboard handler before the
+// engine's reply in Qubic or ultimate tic-tac-toe is therefore late by the
+// search, up to AI_BUDGET_TICKS (17 ms).
+void audio_play(int clip){
+	audio_requested[clip]++;
+}
+
+bool audio_playing(void){
+	for (int v = 0; v < AUDIO_VOICES; v++){
+		if (audio_voices[v].samples != NULL){
+			return true;
+		}
+	}
+	return false;
+}
+
+// Starts the clips asked for since the last call and mixes the ring up to
+// AUDIO_LEAD samples ahead of the audio core. Does nothing while it's quiet.
+void audio_pump(void){
+	for (int c = 0; c < AUDIO_CLIPS; c++){
+		while (audio_started[c] != audio_requested[c]){
+			// A free voice, or the one that has played the longest
+			int v = 0;
+			for (int i = 0; i < AUDIO_VOICES; i++){
+				if (audio_voices[i].samples == NULL){
+					v = i;
+					break;
+				}
+				if (audio_voices[i].position > audio_voices[v].position){
+					v = i;
+				}
+			}
+			audio_voices[v].samples = audio_clip_start[c];
+			audio_voices[v].length = audio_clip_length[c];
+			audio_voices[v].position = 0;
+			audio_started[c]++;
+		}
+	}
+	if (!audio_playing()){
+		return;
+	}
+	
+	unsigned int start = read_timer();
+	while (audio_playing() && audio_head - audio_tail + AUDIO_MIX_CHUNK <= AUDIO_LEAD){
+		audio_mix(AUDIO_MIX_CHUNK);
+	}
+	audio_stats.mix_ticks += start - read_timer();
+#ifndef HOST_BUILD
+	// Write FIFO interrupts on until the ring runs dry
+	volatile int * audio_ptr = (int *) AUDIO_BASE;
+	*(audio_ptr) = 0x2;
+#endif
+}
+
+// Mixes count samples of the playing voices onto the ring, saturating
+void audio_mix(int count){
+	int mixed[AUDIO_MIX_CHUNK] = {0};
+	
+	for (int v = 0; v < AUDIO_VOICES; v++){
+		audio_voice *voice = &audio_voices[v];
+		if (voice->samples == NULL){
+			continue;
+		}
+		int n = (voice->length - voice->position < count) ? voice->length - voice->position : count;
+		const short *samples = voice->samples + voice->position;
+		for (int i = 0; i < n; i++){
+			mixed[i] += samples[i];
+		}
+		voice->position += n;
+		if (voice->position == voice->length){
+			voice->samples = NULL;
+		}
+	}
+	
+	unsigned int head = audio_head;
+	for (int i = 0; i < count; i++){
+		int sample = (mixed[i] > 32767) ? 32767 : (mixed[i] < -32768 ? -32768 : mixed[i]);
+		audio_ring[(head + i) & (AUDIO_RING_SIZE - 1)] = sample;
+	}
+	__sync_synchronize(); // the samples are in the ring before the interrupt can see them
+	audio_head = head + count;
+	audio_stats.mixed += count;
+}
+
+// Takes up to space samples off the ring, counting an underrun if it runs
+// short while a clip is still being mixed. Returns the number taken.
+int audio_drain(short *samples, int space){
+	unsigned int tail = audio_tail;
+	int available = audio_head - tail;
+	int n = (available < space) ? available : space;
+	
+	__sync_synchronize();
+	for (int i = 0; i < n; i++){
+		samples[i] = audio_ring[(tail + i) & (AUDIO_RING_SIZE - 1)];
+	}
+	audio_tail = tail + n;
+	audio_stats.samples += n;
+	if (n < space && audio_playing()){
+		audio_stats.ring_underruns++;
+		audio_stats.missing_samples += space - n;
+	}
+	return n;
+}
+
+#ifndef HOST_BUILD
+// Fills the audio core's write FIFO from the ring, the same sample on both
+// channels, and turns its interrupt off once there is nothing left to play
+void audio_ISR(void){
+	volatile int * audio_ptr = (int *) AUDIO_BASE;
+	short samples[AUDIO_FIFO_SIZE];
+	
+	audio_stats.interrupts++;
+	int fifospace = *(audio_ptr + 1);
+	int left = (fifospace >> 24) & 0xFF, right = (fifospace >> 16) & 0xFF;
+	int space = (left < right) ? left : right;
+	if (space == AUDIO_FIFO_SIZE){
+		audio_stats.fifo_underruns++;
+	}
+	
+	int n = audio_drain(samples, space);
+	for (int i = 0; i < n; i++){
+		// In the top 16 bits; shifting the unsigned bits avoids shifting a
+		// negative value, which is undefined
+		int word = (int) ((unsigned int) (unsigned short) samples[i] << 16);
+		*(audio_ptr + 2) = word;
+		*(audio_ptr + 3) = word;
+	}
+	if (n == 0 && !audio_playing()){
+		*(audio_ptr) = 0;
+	}
+}
+#else
+static void write_le(FILE *file, unsigned int value, int bytes){
+	for (int i = 0; i < bytes; i++){
+		fputc((value >> (8 * i)) & 0xFF, file);
+	}
+}
+
+static void audio_wav_header(unsigned int samples){
+	fwrite("RIFF", 1, 4, audio_wav);
+	write_le(audio_wav, 36 + samples * 2, 4);
+	fwrite("WAVEfmt ", 1, 8, audio_wav);
+	write_le(audio_wav, 16, 4); // format chunk size
+	write_le(audio_wav, 1, 2); // PCM
+	write_le(audio_wav, 1, 2); // mono
+	write_le(audio_wav, AUDIO_RATE, 4);
+	write_le(audio_wav, AUDIO_RATE * 2, 4); // bytes per second
+	write_le(audio_wav, 2, 2); // bytes per frame
+	write_le(audio_wav, 16, 2); // bits per sample
+	fwrite("data", 1, 4, audio_wav);
+	write_le(audio_wav, samples * 2, 4);
+}
+
+// Sends the mixed stream to a 16-bit mono WAV file instead of the audio core
+bool audio_wav_open(const char *path){
+	audio_wav = fopen(path, "wb");
+	if (audio_wav == NULL){
+		return false;
+	}
+	audio_wav_samples = 0;
+	audio_wav_header(0);
+	return true;
+}
+
+// Stands in for the audio interrupt after the codec has played space
+// samples: whatever the ring doesn't have is written as silence, as the
+// codec would play it
+void audio_host_tick(int space){
+	short samples[AUDIO_RING_SIZE];
+	
+	if (space > AUDIO_RING_SIZE){
+		space = AUDIO_RING_SIZE;
+	}
+	audio_stats.interrupts++;
+	int n = audio_drain(samples, space);
+	memset(samples + n, 0, (space - n) * sizeof(short));
+	if (audio_wav != NULL){
+		for (int i = 0; i < space; i++){
+			write_le(audio_wav, (unsigned short) samples[i], 2);
+		}
+		audio_wav_samples += space;
+	}
+}
+
+// Fills in the sizes in the header and closes the file
+void audio_wav_close(void){
+	if (audio_wav == NULL){
+		return;
+	}
+	fseek(audio_wav, 0, SEEK_SET);
+	audio_wav_header(audio_wav_samples);
+	fclose(audio_wav);
+	audio_wav = NULL;
+}
+#endif
+
+// Adds an interrupt source for config_GIC to set up. Returns false if the
+// registry is full or the ID is taken or out of range.
+bool irq_register(int id, void (*handler)(void), int priority, bool edge, bool nested, const char *name){
+	if (irq_source_total == MAX_IRQ_SOURCES || id < 0 || id >= MAX_IRQ_ID || irq_slot[id] != 0){
+		return false;
+	}
+	irq_source *source = &irq_sources[irq_source_total++];
+	memset(source, 0, sizeof(*source));
+	source->id = id;
+	source->handler = handler;
+	source->priority = priority;
+	source->edge = edge;
+	source->nested = nested;
+	source->name = name;
+	irq_slot[id] = irq_source_total;
+	return true;
+}
+
+// Longest a source can have waited so far: its dispatch time plus the longest
+// run of any handler that keeps it out. A handler that isn't nested keeps
+// every interrupt out; a nested one only those of its own priority or lower.
+unsigned int irq_latency_bound(int slot){
+	irq_source *source = &irq_sources[slot];
+	unsigned int blocked = 0;
+	
+	for (int i = 0; i < irq_source_total; i++){
+		irq_source *other = &irq_sources[i];
+		if ((!other->nested || other->priority <= source->priority) && other->max_ticks > blocked){
+			blocked = other->max_ticks;
+		}
+	}
+	return source->max_dispatch + blocked;
+}
+
+// Writes a line per interrupt source to the character buffer from row on:
+// how often it fired, its longest run and its worst case latency so far ("n"
+// after the priority marks a nested handler). Returns the row after it.
+int irq_report(int row){
+	char line[81] = "interrupt      id pri   count\0";
+	
+	write_text(2, row++, line);
+	for (int i = 0; i < irq_source_total; i++){
+		irq_source *source = &irq_sources[i];
+		snprintf(line, sizeof(line), "%-13s %3d %3d%s %7u  run %6u us  latency %6u us",
+			source->name, source->id, source->priority, source->nested ? "n" : " ", source->count,
+			source->max_ticks / (TIMER_HZ / 1000000), irq_latency_bound(i) / (TIMER_HZ / 1000000));
+		write_text(2, row + i, line);
+	}
+	if (irq_unexpected != 0){
+		snprintf(line, sizeof(line), "unexpected    %3d     %7u", irq_last_unexpected, irq_unexpected);
+		write_text(2, row + irq_source_total, line);
+		row++;
+	}
+	return row + irq_source_total;
+}
+
+// Fills a stack with STACK_PAINT from bottom up to end, below anything in
+// use, and keeps it for stack_used and stack_check
+void stack_paint(stack_region *stack, const char *name, unsigned int *bottom, unsigned int *top, unsigned int *end){
+	stack->name = name;
+	stack->bottom = bottom;
+	stack->end = end;
+	stack->top = top;
+	stack->overflows = 0;
+	stack->overflow_by = NULL;
+	for (unsigned int *p = bottom; p < end; p++){
+		*p = STACK_PAINT;
+	}
+}
+
+// Deepest the stack has been since it was painted, in bytes below its top
+unsigned int stack_used(const stack_region *stack){
+	const unsigned int *p = stack->bottom;
+	while (p < stack->end && *p == STACK_PAINT){
+		p++;
+	}
+	return (const char *) stack->top - (const char *) p;
+}
+
+// Returns false, counting an overflow against by, if a guard word at the
+// bottom of the stack changed. The guard is painted again so the next
+// overflow is seen too.
+bool stack_check(stack_region *stack, const char *by){
+	if (stack->bottom == NULL){
+		return true;
+	}
+	for (int i = 0; i < STACK_GUARD_WORDS; i++){
+		if (stack->bottom[i] != STACK_PAINT){
+			stack->overflows++;
+			stack->overflow_by = by;
+			for (i = 0; i < STACK_GUARD_WORDS; i++){
+				stack->bottom[i] = STACK_PAINT;
+			}
+			return false;
+		}
+	}
+	return true;
+}
+
+// Writes a line per painted stack to the character buffer from row on: its
+// size, the deepest it has been and how often it overflowed
+void stack_report(int row){
+	stack_region *stacks[2] = {&irq_stack, &svc_stack};
+	char line[81];
+	
+	for (int i = 0; i < 2; i++){
+		stack_region *stack = stacks[i];
+		if (stack->bottom == NULL){
+			continue;
+		}
+		unsigned int size = (char *) stack->top - (char *) stack->bottom, used = stack_used(stack);
+		snprintf(line, sizeof(line), "%s stack %6u bytes, %6u used (%3u%%), %u overflows%s%s", stack->name, size, used,
+			used * 100 / size, stack->overflows, stack->overflow_by ? ", last after " : "", stack->overflow_by ? stack->overflow_by : "");
+		write_text(2, row++, line);
+	}
+}
+
+// Writes the HEX displays and LEDR, skipping registers that wouldn't change
+static void hud_output(unsigned int hex3_0, unsigned int hex5_4, unsigned int ledr){
+#ifndef HOST_BUILD
+	if (hex3_0 != hud_hex[0]){
+		*((volatile int *) HEX3_HEX0_BASE) = hex3_0;
+	}
+	if (hex5_4 != hud_hex[1]){
+		*((volatile int *) HEX5_HEX4_BASE) = hex5_4;
+	}
+	if (ledr != hud_ledr){
+		*((volatile int *) LEDR_BASE) = ledr;
+	}
+#endif
+	hud_hex[0] = hex3_0;
+	hud_hex[1] = hex5_4;
+	hud_ledr = ledr;
+}
+
+// Builds the digit pair table and blanks the displays
+void hud_init(void){
+	for (int i = 0; i < 100; i++){
+		hex_digit_pairs[i] = hex_digit_segments[i / 10] << 8 | hex_digit_segments[i % 10];
+	}
+	hud_last_poll = read_timer();
+	hud_ring_underruns = audio_stats.ring_underruns;
+	hud_hex[0] = hud_hex[1] = hud_ledr = 1; // anything but what is written next
+	hud_output(0, 0, 0);
+}
+
+// Last search's speed, 0 if nothing was searched yet
+static unsigned int hud_nodes_per_ms(void){
+	return (hud.ai_ticks == 0) ? 0 : (unsigned long long) hud.ai_nodes * (TIMER_HZ / 1000) / hud.ai_ticks;
+}
+
+// [F]: off, then the HEX displays, then those and the character buffer's
+// corner. Deadlines missed before the HUD was turned on are forgotten.
+void hud_toggle(void){
+	hud_mode = (hud_mode + 1) % HUD_MODES;
+	if (hud_mode == HUD_HEX){
+		hud.late = 0;
+		hud_frames = 0;
+	}
+	if (hud_mode == HUD_OFF){
+		char blank[20] = "                 \0";
+		game_view_changed();
+		for (int i = 0; i < 3; i++){
+			write_text(HUD_TEXT_COL, HUD_TEXT_ROW + i, blank);
+			hud_text[i][0] = '\0';
+		}
+	}
+}
+
+// Keeps the time a key took, lighting LEDR0 if it was over a frame. The key
+// may have cleared the character buffer, so the HUD's corner is written again.
+void hud_key_done(unsigned int start){
+	hud.frame_ticks = start - read_timer();
+	if (hud.frame_ticks > HUD_FRAME_TICKS){
+		hud.late |= HUD_LATE_FRAME;
+		hud.late_count++;
+	}
+	for (int i = 0; i < 3; i++){
+		hud_text[i][0] = '\0';
+	}
+}
+
+// Keeps the node count and time of the search that just finished
+void hud_search_done(void){
+	unsigned int nodes = 0, ticks = 0;
+	for (int depth = 0; depth <= MAX_DEPTH; depth++){
+		nodes += search_stats[depth].nodes;
+		ticks += search_stats[depth].ticks;
+	}
+	hud.ai_nodes = nodes;
+	hud.ai_ticks = ticks;
+}
+
+// Once a frame: checks the audio and main loop deadlines and puts what the
+// handlers stored on the displays the HUD is on. The HEX displays show one
+// value at a time after its letter, H for the longest handler run in the
+// last frame (us), F for the last key (us) and n for the AI's nodes per ms.
+void hud_poll(void){
+	unsigned int now = read_timer(), elapsed = hud_last_poll - now;
+	if (elapsed < HUD_FRAME_TICKS){
+		return;
+	}
+	hud_last_poll = now;
+	hud_frames++;
+	if (elapsed > 2 * HUD_FRAME_TICKS){
+		hud.late |= HUD_LATE_POLL;
+		hud.late_count++;
+	}
+	if (audio_stats.ring_underruns != hud_ring_underruns){
+		hud_ring_underruns = audio_stats.ring_underruns;
+		hud.late |= HUD_LATE_AUDIO;
+		hud.late_count++;
+	}
+	hud_isr_shown = hud.isr_ticks;
+	hud.isr_ticks = 0;
+	if (hud_mode == HUD_OFF){
+		hud_output(0, 0, 0);
+		return;
+	}
+	
+	unsigned int values[3] = {hud_isr_shown / (TIMER_HZ / 1000000), hud.frame_ticks / (TIMER_HZ / 1000000), hud_nodes_per_ms()};
+	for (int i = 0; i < 3; i++){
+		values[i] = (values[i] > 99999) ? 99999 : values[i]; // five digits
+	}
+	int shown = (hud_frames / HUD_ROTATE_FRAMES) % 3;
+	unsigned int value = values[shown];
+	unsigned int digits = hex_digit_pairs[value / 100 % 100] << 16 | hex_digit_pairs[value % 100];
+	unsigned int top = hex_digit_segments[value / 10000];
+	
+	// Blank the leading zeros, HEX4 first
+	if (value < 10000){
+		top = 0;
+		for (int shift = 24; shift > 0 && (digits >> shift & 0xFF) == hex_digit_segments[0]; shift -= 8){
+			digits &= ~(0xFFu << shift);
+		}
+	}
+	hud_output(digits, hud_value_letter[shown] << 8 | top, hud.late);
+	
+	if (hud_mode == HUD_HEX_TEXT){
+		char line[20];
+		for (int i = 0; i < 3; i++){
+			snprintf(line, sizeof(line), (i == 0) ? "isr   %5u us   " : (i == 1) ? "key   %5u us   " : "ai %5u nodes/ms", values[i]);
+			if (strcmp(line, hud_text[i]) != 0){
+				strcpy(hud_text[i], line);
+				write_text(HUD_TEXT_COL, HUD_TEXT_ROW + i, line);
+				if (!help_showing){
+					game_view_changed(); // the saved game screen holds the old figures
+				}
+			}
+		}
+	}
+}
+
+// Turns on the receive interrupt and says hello
+void console_init(void){
+#ifndef HOST_BUILD
+	volatile int * uart_ptr = (int *) JTAG_UART_BASE;
+	*(uart_ptr + 1) = 0x1; // RE
+#endif
+	console_write("tic-tac-toe console, type help\n> ");
+	console_flush();
+}
+
+// Queues a received byte for console_poll
+void console_receive(char c){
+	if (console_rx_head - console_rx_tail == CONSOLE_RX_SIZE){
+		console_stats.rx_dropped++;
+		return;
+	}
+	console_rx[console_rx_head++ & (CONSOLE_RX_SIZE - 1)] = c;
+	console_stats.rx_bytes++;
+}
+
+// Builds lines out of the received bytes and runs each one
+void console_poll(void){
+	while (console_rx_tail != console_rx_head){
+		char c = console_rx[console_rx_tail++ & (CONSOLE_RX_SIZE - 1)];
+		if (c == '\r' || c == '\n'){
+			if (console_line_length > 0){
+				console_line[console_line_length] = '\0';
+				console_line_length = 0;
+				console_stats.lines++;
+				console_command(console_line);
+				console_write("> ");
+			}
+		} else if (console_line_length < CONSOLE_LINE){
+			console_line[console_line_length++] = c;
+		}
+	}
+	console_flush();
+}
+
+// Queues text for the UART, dropping what doesn't fit in the ring
+void console_write(const char *text){
+	for (; *text != '\0'; text++){
+		if (console_tx_head - console_tx_tail == CONSOLE_TX_SIZE){
+			console_stats.tx_dropped++;
+			continue;
+		}
+		console_tx[console_tx_head++ & (CONSOLE_TX_SIZE - 1)] = *text;
+	}
+}
+
+void console_printf(const char *format, ...){
+	char text[160];
+	va_list args;
+	
+	va_start(args, format);
+	vsnprintf(text, sizeof(text), format, args);
+	va_end(args);
+	console_write(text);
+}
+
+// Moves as much queued output as the UART takes right now. On the board the
+// write interrupt stays on while output is left, so the rest follows from
+// console_ISR without anyone waiting; the host writes it to stdout.
+void console_flush(void){
+#ifdef HOST_BUILD
+	while (console_tx_tail != console_tx_head){
+		putchar(console_tx[console_tx_tail++ & (CONSOLE_TX_SIZE - 1)]);
+		console_stats.tx_bytes++;
+	}
+	fflush(stdout);
+#else
+	volatile int * uart_ptr = (int *) JTAG_UART_BASE;
+	int space = (*(uart_ptr + 1) >> 16) & 0xFFFF; // WSPACE
+	while (space > 0 && console_tx_tail != console_tx_head){
+		*(uart_ptr) = console_tx[console_tx_tail++ & (CONSOLE_TX_SIZE - 1)];
+		console_stats.tx_bytes++;
+		space--;
+	}
+	*(uart_ptr + 1) = (console_tx_tail != console_tx_head) ? 0x3 : 0x1; // RE, and WE while output is left
+#endif
+}
+
+#ifndef HOST_BUILD
+// Empties the receive FIFO, runs any complete lines and refills the
+// transmit FIFO
+void console_ISR(void){
+	volatile int * uart_ptr = (int *) JTAG_UART_BASE;
+	int data;
+	
+	while ((data = *(uart_ptr)) & 0x8000){ // RVALID
+		console_receive(data & 0xFF);
+	}
+	console_poll();
+}
+#endif
+
+// Prints the board as rows of X, O and .
+static void console_board(void){
+	if (qubic_showing || ultimate_showing){
+		console_printf("the console board is the 3x3 game, %s is showing\n", qubic_showing ? "Qubic [Q]" : "ultimate [V]");
+		return;
+	}
+	for (int row = 0; row < GAME_ROWS; row++){
+		char text[GAME_COLS * 2 + 2];
+		for (int col = 0; col < GAME_COLS; col++){
+			int cell = board[row * GAME_COLS + col];
+			text[col * 2] = (cell == 1) ? 'X' : (cell == 2 ? 'O' : '.');
+			text[col * 2 + 1] = ' ';
+		}
+		text[GAME_COLS * 2 - 1] = '\n';
+		text[GAME_COLS * 2] = '\0';
+		console_write(text);
+	}
+	int line = winning_line();
+	if (line >= 0){
+		console_printf("%c wins\n", (board[game_layout.line_cell[line][0]] == 1) ? 'X' : 'O');
+	} else if (game_position.stones == GAME_CELLS){
+		console_write("tie\n");
+	} else {
+		console_printf("%c to move\n", Turn);
+	}
+}
+
+// One random ultimate tic-tac-toe game, for bench: playouts per second
+static void bench_playout(void){
+	ultimate_board u;
+	ultimate_init(&u);
+	ultimate_playout(&u, &ultimate_seed);
+}
+
+// A search from the current position with the AI's budget, for bench
+static void bench_search(void){
+	mnk_board b = game_position;
+	search_best_move(&b, (Turn == 'X') ? 1 : 2, AI_BUDGET_TICKS);
+}
+
+// Scancode of the number key for a cell, 0 if there is none
+static unsigned char cell_key(int cell){
+	for (int code = 0; code < 256; code++){
+		if (number_key_cell[code] == cell + 1){
+			return code;
+		}
+	}
+	return 0;
+}
+
+// Runs one console command. Game commands go through handle_key like the
+// keys they stand for.
+void console_command(char *line){
+	console_bench benches[] = {
+		{"draw_board", draw_board}, {"draw_game_view", draw_game_view}, {"clear_screen", clear_screen},
+		{"draw_help_screen", draw_help_screen}, {"search", bench_search},
+		{"playout", bench_playout}
+	};
+	int bench_total = sizeof(benches) / sizeof(benches[0]);
+	char *command = strtok(line, " \t");
+	char *argument = strtok(NULL, " \t");
+	int number = (argument != NULL) ? atoi(argument) : 0;
+	
+	if (command == NULL){
+		return;
+	}
+	if (strcmp(command, "help") == 0){
+		console_write("move <1-9>, ai, undo, redo, reset, key <hex scancode>, board, stats, stack,\n"
+			"exhibition [boards, 0 to stop], "
+			"bench <name> [times] with name one of");
+		for (int i = 0; i < bench_total; i++){
+			console_printf(" %s", benches[i].name);
+		}
+		console_write("\n");
+	} else if (strcmp(command, "move") == 0 && number >= 1 && number <= GAME_CELLS){
+		handle_key(cell_key(number - 1));
+		handle_key(0x5A);
+		console_board();
+	} else if (strcmp(command, "move") == 0){
+		console_printf("move takes a cell from 1 to %d\n", GAME_CELLS);
+	} else if (strcmp(command, "ai") == 0 || strcmp(command, "undo") == 0 || strcmp(command, "redo") == 0 || strcmp(command, "reset") == 0){
+		handle_key((command[0] == 'a') ? 0x21 : (command[0] == 'u') ? 0x3C : (command[2] == 'd') ? 0x2D : 0x29);
+		console_board();
+	} else if (strcmp(command, "key") == 0 && argument != NULL){
+		keyboard_byte(strtol(argument, NULL, 16));
+	} else if (strcmp(command, "board") == 0){
+		console_board();
+	} else if (strcmp(command, "stats") == 0){
+		unsigned int nodes = 0, ticks = 0;
+		for (int depth = 0; depth <= MAX_DEPTH; depth++){
+			nodes += search_stats[depth].nodes;
+			ticks += search_stats[depth].ticks;
+		}
+		console_printf("search: depth %d, %u nodes, %u us\n", search_depth_reached, nodes, ticks / (TIMER_HZ / 1000000));
+		console_printf("audio: %u samples, %u ring underruns (%u samples), %u fifo underruns\n",
+			audio_stats.samples, audio_stats.ring_underruns, audio_stats.missing_samples, audio_stats.fifo_underruns);
+		console_printf("console: %u bytes in, %u lines, %u bytes out, %u dropped\n",
+			console_stats.rx_bytes, console_stats.lines, console_stats.tx_bytes, console_stats.rx_dropped + console_stats.tx_dropped);
+		console_printf("hud: isr %u us, last key %u us, ai %u nodes/ms, %u deadlines missed\n", hud_isr_shown / (TIMER_HZ / 1000000),
+			hud.frame_ticks / (TIMER_HZ / 1000000), hud_nodes_per_ms(), hud.late_count);
+		console_printf("analysis: %u updates (%u out of time), %u nodes, %u table hits, %u labels written, last %u us\n",
+			analysis_stats.updates, analysis_stats.aborted, analysis_stats.nodes, analysis_stats.table_hits, analysis_stats.repaints,
+			analysis_stats.last_ticks / (TIMER_HZ / 1000000));
+		for (int i = 0; i < irq_source_total; i++){
+			irq_source *source = &irq_sources[i];
+			console_printf("irq %-13s %3d: %u, run %u us, latency %u us\n", source->name, source->id, source->count,
+				source->max_ticks / (TIMER_HZ / 1000000), irq_latency_bound(i) / (TIMER_HZ / 1000000));
+		}
+	} else if (strcmp(command, "stack") == 0){
+		stack_region *stacks[2] = {&irq_stack, &svc_stack};
+		for (int i = 0; i < 2; i++){
+			stack_region *stack = stacks[i];
+			if (stack->bottom == NULL){
+				console_printf("%s stack not painted\n", (i == 0) ? "IRQ" : "SVC");
+				continue;
+			}
+			unsigned int size = (char *) stack->top - (char *) stack->bottom;
+			console_printf("%s stack: %u of %u bytes used, %u overflows%s%s\n", stack->name, stack_used(stack), size,
+				stack->overflows, stack->overflow_by ? ", last after " : "", stack->overflow_by ? stack->overflow_by : "");
+		}
+	} else if (strcmp(command, "exhibition") == 0){
+		if (argument != NULL){
+			exhibition_request = number; // the main loop starts or stops it
+			return;
+		}
+		exhibition_counters *c = &exhibition_stats;
+		unsigned int us = TIMER_HZ / 1000000, frames = (c->frames > 0) ? c->frames : 1;
+		console_printf("exhibition: %d boards, %u frames, frame %u us (max %u), ai %u us, draw %u us\n", exhibition_total, c->frames,
+			(unsigned int) (c->total_ticks / frames / us), c->max_ticks / us, (unsigned int) (c->ai_ticks / frames / us),
+			(unsigned int) (c->draw_ticks / frames / us));
+		console_printf("%u moves, %u games, %u engine moves deferred\n", c->moves, c->games, c->deferred);
+	} else if (strcmp(command, "bench") == 0 && exhibition_total > 0){
+		console_write("not during an exhibition\n");
+	} else if (strcmp(command, "bench") == 0 && argument != NULL){
+		char *times = strtok(NULL, " \t");
+		int count = (times != NULL && atoi(times) > 0) ? atoi(times) : 100;
+		for (int i = 0; i < bench_total; i++){
+			if (strcmp(argument, benches[i].name) == 0){
+				game_view_changed();
+				unsigned int start = read_timer();
+				for (int n = 0; n < count; n++){
+					benches[i].run();
+				}
+				unsigned int hundredths = (unsigned long long) (start - read_timer()) * 100 / (TIMER_HZ / 1000000) / count;
+				console_printf("%s: %d times, %u.%02u us each\n", argument, count, hundredths / 100, hundredths % 100);
+				if (!help_showing){
+					draw_game_view(); // some of them draw over the game
+				}
+				return;
+			}
+		}
+		console_printf("no bench called %s\n", argument);
+	} else {
+		console_write("unknown command, try help\n");
+	}
+}
@@ -0,0 +1,289 @@
+// Batch position analyser. Memory-maps a file of packed positions, shares it
+// out between threads and writes the engine's verdict on every position
+// (best move, value and plies to the end of a forced result) into a
+// memory-mapped output file, one fixed size record per position. Nothing is
+// allocated per position.
+//
+// 3x3 positions are answered from a table of exact results built once at
+// start-up. Larger boards are searched with search_best_move for a fixed time
+// per position.
+//
+// Build and run on the host:
+//   gcc -O2 -pthread -o analyze_positions tools/analyze_positions.c
+//   ./analyze_positions --random count positions.bin [rows cols k]
+//   ./analyze_positions positions.bin verdicts.bin [threads [microseconds per position]]
+#define HOST_BUILD
+#include "../tic_tac_toe.c"
+
+#define MAX_ANALYSIS_THREADS 64
+#define THREE_BY_THREE_CODES 19683 // 3^9
+#define NO_MOVE 255
+
+// Position file header. 3x3 records are 2 bytes: the base-3 code of board[9]
+// (cell i times 3^i, 0 empty, 1 X, 2 O) with bit 15 set when O is to move.
+// Other boards use 2 bits per cell, then a byte holding the side to move.
+typedef struct {
+	char magic[8]; // "TTTPOS1"
+	int rows, cols, k;
+	int record_size;
+	unsigned long long count;
+} position_file_header;
+
+// One verdict. value is 1 for a win for the side to move, -1 for a loss and
+// 0 for a draw (or no forced result found on larger boards).
+typedef struct {
+	unsigned char best_move; // NO_MOVE if the game is already over
+	signed char value;
+	unsigned char depth_to_mate; // plies until the forced result ends the game
+	unsigned char reserved;
+} verdict;
+
+// A range of records analysed by one thread
+typedef struct {
+	const unsigned char *records;
+	verdict *verdicts;
+	unsigned long long first, last;
+} analysis_job;
+
+position_file_header input_header;
+mnk_board empty_board; // line tables are built once, threads copy this
+verdict exact_table[2][THREE_BY_THREE_CODES];
+bool exact_known[2][THREE_BY_THREE_CODES];
+unsigned int search_ticks;
+int power_of_three[10] = {1, 3, 9, 27, 81, 243, 729, 2187, 6561, 19683};
+
+// Exact result of a 3x3 position with player to move, memoised by its code
+verdict solve_exact(mnk_board *b, int code, int player){
+	verdict result = {NO_MOVE, -1, 0, 0};
+	int best_score = -1000;
+
+	if (exact_known[player - 1][code]){
+		return exact_table[player - 1][code];
+	}
+
+	for (int cell = 0; cell < 9; cell++){
+		if (b->cell[cell] != 0){
+			continue;
+		}
+
+		int value, depth;
+		engine_play(b, cell, player);
+		if (engine_is_win(b, cell)){
+			value = 1;
+			depth = 1;
+		} else if (b->stones == 9){
+			value = 0;
+			depth = 0;
+		} else {
+			verdict child = solve_exact(b, code + player * power_of_three[cell], 3 - player);
+			value = -child.value;
+			depth = (child.value == 0) ? 0 : child.depth_to_mate + 1;
+		}
+		engine_undo(b, cell);
+
+		// Quickest win, then a draw, then the slowest loss
+		int score = (value == 1) ? 100 - depth : (value == -1 ? -100 + depth : 0);
+		if (score > best_score){
+			best_score = score;
+			result = (verdict) {cell, value, depth, 0};
+		}
+	}
+
+	exact_known[player - 1][code] = true;
+	exact_table[player - 1][code] = result;
+	return result;
+}
+
+// Fills the table for every code, including ones that can't come up in a
+// game. Positions that are already over get NO_MOVE.
+void build_exact_table(void){
+	for (int code = 0; code < THREE_BY_THREE_CODES; code++){
+		for (int player = 1; player <= 2; player++){
+			mnk_board b = empty_board;
+			bool over = false;
+
+			for (int cell = 0; cell < 9; cell++){
+				int stone = code / power_of_three[cell] % 3;
+				if (stone != 0){
+					engine_play(&b, cell, stone);
+					over |= engine_is_win(&b, cell);
+				}
+			}
+			if (over || b.stones == 9){
+				exact_known[player - 1][code] = true;
+				exact_table[player - 1][code] = (verdict) {NO_MOVE, 0, 0, 0};
+				continue;
+			}
+			solve_exact(&b, code, player);
+		}
+	}
+}
+
+// Searches one packed m,n,k position
+verdict analyse_board(const unsigned char *record){
+	mnk_board b = empty_board;
+	verdict result = {NO_MOVE, 0, 0, 0};
+	int player = record[(b.cells * 2 + 7) / 8];
+
+	for (int cell = 0; cell < b.cells; cell++){
+		int stone = (record[cell >> 2] >> ((cell & 3) * 2)) & 3;
+		if (stone == 1 || stone == 2){
+			engine_play(&b, cell, stone);
+			if (engine_is_win(&b, cell)){
+				return result;
+			}
+		}
+	}
+
+	int move = search_best_move(&b, player, search_ticks);
+	if (move < 0){
+		return result;
+	}
+	int score = search_stats[search_depth_reached].score;
+	result.best_move = move;
+	if (score > WIN_SCORE - MAX_DEPTH){
+		result.value = 1;
+		result.depth_to_mate = WIN_SCORE - score;
+	} else if (score < -WIN_SCORE + MAX_DEPTH){
+		result.value = -1;
+		result.depth_to_mate = WIN_SCORE + score;
+	}
+	return result;
+}
+
+void *analyse_range(void *arg){
+	analysis_job *job = (analysis_job *) arg;
+	bool small = (input_header.rows == 3 && input_header.cols == 3 && input_header.k == 3);
+
+	for (unsigned long long i = job->first; i < job->last; i++){
+		const unsigned char *record = job->records + i * input_header.record_size;
+		if (small){
+			unsigned int packed = record[0] | (record[1] << 8);
+			unsigned int code = packed & 0x7FFF;
+			job->verdicts[i] = (code < THREE_BY_THREE_CODES) ? exact_table[packed >> 15][code] : (verdict) {NO_MOVE, 0, 0, 0};
+		} else {
+			job->verdicts[i] = analyse_board(record);
+		}
+	}
+	return NULL;
+}
+
+// Writes count random positions with X and O stones alternating, for testing
+int write_random_positions(unsigned long long count, const char *path, int rows, int cols, int k){
+	position_file_header header = {"TTTPOS1", rows, cols, k, 0, count};
+	int cells = rows * cols;
+	header.record_size = (rows == 3 && cols == 3 && k == 3) ? 2 : (cells * 2 + 7) / 8 + 1;
+
+	size_t size = sizeof(header) + count * header.record_size;
+	unsigned char *file = map_create(path, size);
+	if (file == NULL){
+		return 1;
+	}
+	memcpy(file, &header, sizeof(header));
+
+	srand(1);
+	for (unsigned long long i = 0; i < count; i++){
+		unsigned char *record = file + sizeof(header) + i * header.record_size;
+		char cell[MAX_CELLS] = {0};
+		int stones = rand() % cells;
+		for (int s = 0; s < stones; s++){
+			int c = rand() % cells;
+			while (cell[c] != 0){
+				c = (c + 1) % cells;
+			}
+			cell[c] = 1 + (s & 1);
+		}
+
+		if (header.record_size == 2){
+			unsigned int code = 0;
+			for (int c = 0; c < 9; c++){
+				code += cell[c] * power_of_three[c];
+			}
+			code |= (stones & 1) << 15;
+			record[0] = code & 0xFF;
+			record[1] = code >> 8;
+		} else {
+			for (int c = 0; c < cells; c++){
+				record[c >> 2] |= cell[c] << ((c & 3) * 2);
+			}
+			record[(cells * 2 + 7) / 8] = 1 + (stones & 1);
+		}
+	}
+	munmap(file, size);
+	printf("wrote %llu %dx%d k=%d positions to %s\n", count, rows, cols, k, path);
+	return 0;
+}
+
+int main(int argc, char *argv[]){
+	if (argc >= 4 && strcmp(argv[1], "--random") == 0){
+		int rows = (argc > 6) ? atoi(argv[4]) : 3, cols = (argc > 6) ? atoi(argv[5]) : 3, k = (argc > 6) ? atoi(argv[6]) : 3;
+		return write_random_positions(strtoull(argv[2], NULL, 10), argv[3], rows, cols, k);
+	}
+	if (argc < 3){
+		printf("usage: %s positions verdicts [threads [microseconds per position]]\n", argv[0]);
+		printf("       %s --random count positions [rows cols k]\n", argv[0]);
+		return 1;
+	}
+
+	int threads = (argc > 3) ? atoi(argv[3]) : (int) sysconf(_SC_NPROCESSORS_ONLN);
+	search_ticks = (argc > 4) ? atoi(argv[4]) * (TIMER_HZ / 1000000) : TIMER_HZ / 1000;
+	if (threads < 1 || threads > MAX_ANALYSIS_THREADS){
+		threads = 1;
+	}
+
+	size_t input_size;
+	const unsigned char *input = map_read(argv[1], &input_size);
+	if (input == NULL || input_size < sizeof(input_header)){
+		printf("can't read %s\n", argv[1]);
+		return 1;
+	}
+	memcpy(&input_header, input, sizeof(input_header));
+	if (memcmp(input_header.magic, "TTTPOS1", 8) != 0 || input_header.rows > MAX_ROWS || input_header.cols > MAX_COLS
+		|| sizeof(input_header) + input_header.count * input_header.record_size > input_size){
+		printf("%s is not a position file\n", argv[1]);
+		return 1;
+	}
+
+	size_t output_size = input_header.count * sizeof(verdict);
+	verdict *output = map_create(argv[2], output_size);
+	if (output == NULL){
+		return 1;
+	}
+
+	engine_init(&empty_board, input_header.rows, input_header.cols, input_header.k);
+	unsigned int start = read_timer();
+	if (input_header.rows == 3 && input_header.cols == 3 && input_header.k == 3){
+		build_exact_table();
+	}
+	double table_seconds = (start - read_timer()) / (double) TIMER_HZ;
+
+	analysis_job jobs[MAX_ANALYSIS_THREADS];
+	pthread_t workers[MAX_ANALYSIS_THREADS];
+	unsigned long long shard = (input_header.count + threads - 1) / threads;
+
+	start = read_timer();
+	for (int t = 0; t < threads; t++){
+		unsigned long long first = t * shard, last = first + shard;
+		jobs[t] = (analysis_job) {input + sizeof(input_header), output,
+			(first < input_header.count) ? first : input_header.count,
+			(last < input_header.count) ? last : input_header.count};
+		pthread_create(&workers[t], NULL, analyse_range, &jobs[t]);
+	}
+	for (int t = 0; t < threads; t++){
+		pthread_join(workers[t], NULL);
+	}
+	double seconds = (start - read_timer()) / (double) TIMER_HZ;
+
+	unsigned long long wins = 0, draws = 0, losses = 0, over = 0;
+	for (unsigned long long i = 0; i < input_header.count; i++){
+		over += (output[i].best_move == NO_MOVE);
+		wins += (output[i].best_move != NO_MOVE && output[i].value == 1);
+		draws += (output[i].best_move != NO_MOVE && output[i].value == 0);
+		losses += (output[i].best_move != NO_MOVE && output[i].value == -1);
+	}
+
+	printf("%llu %dx%d k=%d positions, %d threads\n", input_header.count, input_header.rows, input_header.cols, input_header.k, threads);
+	printf("win %llu  draw %llu  loss %llu  game over %llu\n", wins, draws, losses, over);
+	printf("table %.3f s, analysis %.3f s, %.0f positions/s\n", table_seconds, seconds, input_header.count / seconds);
+	return 0;
+}
@@ -0,0 +1,51 @@
+// Plays the game's sound effects through the host audio backend into a WAV
+// file. The codec is simulated in FIFO sized steps, each one an audio
+// interrupt, with audio_pump run between them the way the main loop would;
+// --stall makes the main loop miss that many milliseconds after every sound
+// to show the underrun counters at work.
+//
+// Build and run on the host:
+//   gcc -O2 -o audio_wav tools/audio_wav.c && ./audio_wav sounds.wav [--stall ms]
+#define HOST_BUILD
+#include "../tic_tac_toe.c"
+
+int main(int argc, char *argv[]){
+	if (argc != 2 && !(argc == 4 && strcmp(argv[2], "--stall") == 0)){
+		printf("usage: %s output.wav [--stall ms]\n", argv[0]);
+		return 1;
+	}
+	int stall = (argc == 4) ? atoi(argv[3]) * AUDIO_RATE / 1000 : 0;
+	if (!audio_wav_open(argv[1])){
+		perror(argv[1]);
+		return 1;
+	}
+	audio_init();
+	
+	// A game: five moves a quarter of a second apart, the last one winning,
+	// then a tie, with two clicks overlapping the tie
+	struct { int at_ms, clip; } script[] = {
+		{0, AUDIO_CLICK}, {250, AUDIO_CLICK}, {500, AUDIO_CLICK}, {750, AUDIO_CLICK}, {1000, AUDIO_WIN},
+		{2000, AUDIO_TIE}, {2100, AUDIO_CLICK}, {2150, AUDIO_CLICK}
+	};
+	int events = sizeof(script) / sizeof(script[0]), next = 0;
+	int total = 3 * AUDIO_RATE, step = AUDIO_FIFO_SIZE * 3 / 4, stalled_until = -1;
+	
+	for (int t = 0; t < total; t += step){
+		while (next < events && script[next].at_ms * AUDIO_RATE / 1000 <= t){
+			audio_play(script[next++].clip);
+			stalled_until = t + stall;
+			audio_pump(); // the clip starts before the stall
+		}
+		if (t >= stalled_until){
+			audio_pump();
+		}
+		audio_host_tick(step);
+	}
+	audio_wav_close();
+	
+	printf("%u samples at %d Hz, %u interrupts\n", audio_wav_samples, AUDIO_RATE, audio_stats.interrupts);
+	printf("mixed %u samples, %.3f us per sample\n", audio_stats.mixed,
+		audio_stats.mixed ? audio_stats.mix_ticks * 1e6 / TIMER_HZ / audio_stats.mixed : 0.0);
+	printf("ring underruns %u (%u samples missing)\n", audio_stats.ring_underruns, audio_stats.missing_samples);
+	return 0;
+}
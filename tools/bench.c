@@ -0,0 +1,331 @@
+// The benchmark suite: drawing primitives, the game's screens and logic, the
+// AI, and whole scripted sessions fed in as PS/2 bytes, all on the host build
+// with the screen in host memory. Every benchmark is timed over several
+// samples of enough repetitions to take BENCH_SAMPLE_TICKS; the fastest
+// sample is the result, as it is the one least disturbed by the machine.
+//
+// Results are written as JSON. Given a baseline (an earlier run's JSON) each
+// result is compared with it and the run fails, exit status 1, if any is
+// slower by more than the threshold. Times depend on the machine, so a
+// baseline is only worth comparing with on the machine that saved it;
+// tools/bench_baseline.json is one machine's, kept as an example.
+//
+// Build and run on the host:
+//   gcc -O2 -o bench tools/bench.c
+//   ./bench [--baseline file.json] [--threshold percent] [--save file.json] [--filter text] [--samples n]
+//   ./bench --save baseline.json && ./bench --baseline baseline.json > results.json
+#define HOST_BUILD
+#include "../tic_tac_toe.c"
+
+#define BENCH_SAMPLE_TICKS (TIMER_HZ / 50) // 20 ms
+#define BENCH_MAX_SAMPLES 31
+#define BENCH_DEFAULT_SAMPLES 11
+#define BENCH_DEFAULT_THRESHOLD 10.0 // percent slower that fails the run
+#define MAX_BASELINES 64
+
+// One benchmark. run does ops operations, setup puts the game in the state
+// run starts from and isn't timed.
+typedef struct {
+	const char *name;
+	const char *kind; // micro or macro
+	int ops;
+	void (*setup)(void);
+	void (*run)(void);
+} bench_case;
+
+typedef struct {
+	char name[64];
+	double ns_per_op;
+} bench_baseline;
+
+bench_baseline baselines[MAX_BASELINES];
+int baseline_total;
+
+// A game five moves in, O to move, nobody has won
+static void setup_midgame(void){
+	int moves[5] = {4, 0, 8, 2, 6};
+
+	Turn = 'X';
+	memset(board, 0, sizeof(board));
+	engine_init(&game_position, GAME_ROWS, GAME_COLS, GAME_K);
+	for (int i = 0; i < 5; i++){
+		board[moves[i]] = (i % 2 == 0) ? 1 : 2;
+		engine_play(&game_position, moves[i], board[moves[i]]);
+	}
+	Turn = 'O';
+	isStalemate = false;
+	game_view_changed();
+	draw_game_view();
+}
+
+// The game screen with an empty board, as after [X]
+static void setup_new_game(void){
+	Turn = 'X';
+	memset(board, 0, sizeof(board));
+	engine_init(&game_position, GAME_ROWS, GAME_COLS, GAME_K);
+	isStalemate = false;
+	selection_cell = 0;
+	game_view_changed();
+	draw_game_view();
+}
+
+static void run_plot_pixel(void){
+	for (int i = 0; i < 1024; i++){
+		plot_pixel(i % 320, (i * 7) % 240, 0xFFFF);
+	}
+}
+
+static void run_line_horizontal(void){
+	draw_line(0, 120, 319, 120, 0xFFFF);
+}
+
+static void run_line_vertical(void){
+	draw_line(160, 0, 160, 239, 0xFFFF);
+}
+
+static void run_line_diagonal(void){
+	draw_line(0, 0, 239, 239, 0xFFFF);
+}
+
+static void run_line_shallow(void){
+	draw_line(0, 0, 319, 100, 0xFFFF);
+}
+
+static void run_line_steep(void){
+	draw_line(0, 0, 100, 239, 0xFFFF);
+}
+
+static void run_draw_player_X(void){
+	draw_player_X(5);
+}
+
+static void run_draw_player_O(void){
+	draw_player_O(5);
+}
+
+static void run_write_text(void){
+	char text[] = "The quick brown fox jumps over the lazy dog";
+	write_text(10, 30, text);
+}
+
+static void run_check_winner(void){
+	check_winner();
+}
+
+// The AI's move from the same position every time
+mnk_board saved_position;
+int saved_board[GAME_CELLS];
+
+static void setup_AI_move(void){
+	setup_midgame();
+	saved_position = game_position;
+	memcpy(saved_board, board, sizeof(board));
+}
+
+static void run_AI_move(void){
+	game_position = saved_position;
+	memcpy(board, saved_board, sizeof(board));
+	Turn = 'O';
+	current_game.move_total = 0; // so the record never fills up
+	AI_move();
+}
+
+// Each key as the keyboard sends it: the make code, then on release 0xF0
+// and the code again
+static void press(const unsigned char *keys, int count){
+	for (int i = 0; i < count; i++){
+		keyboard_byte(keys[i]);
+		keyboard_byte(0xF0);
+		keyboard_byte(keys[i]);
+	}
+}
+
+// A whole game as keys: [X], X takes the top row while O answers in the
+// middle row, then [Space]
+static void run_scripted_game(void){
+	static const unsigned char keys[] = {0x22, 0x16, 0x5A, 0x25, 0x5A, 0x1E, 0x5A, 0x2E, 0x5A, 0x26, 0x5A, 0x29};
+	press(keys, sizeof(keys));
+}
+
+// The AI playing both sides with [C] until the game is over, then [Space]
+static void run_ai_game(void){
+	static const unsigned char keys[] = {0x21, 0x21, 0x21, 0x21, 0x21, 0x21, 0x21, 0x21, 0x21, 0x29};
+	press(keys, sizeof(keys));
+}
+
+// [H] then [Esc], the game screen marked changed first as after a move so
+// it is copied again
+static void run_help_toggle(void){
+	static const unsigned char keys[] = {0x33, 0x76};
+	game_view_changed();
+	press(keys, sizeof(keys));
+}
+
+bench_case cases[] = {
+	{"plot_pixel", "micro", 1024, setup_new_game, run_plot_pixel},
+	{"draw_line_horizontal", "micro", 1, setup_new_game, run_line_horizontal},
+	{"draw_line_vertical", "micro", 1, setup_new_game, run_line_vertical},
+	{"draw_line_diagonal", "micro", 1, setup_new_game, run_line_diagonal},
+	{"draw_line_shallow", "micro", 1, setup_new_game, run_line_shallow},
+	{"draw_line_steep", "micro", 1, setup_new_game, run_line_steep},
+	{"clear_screen", "micro", 1, setup_new_game, clear_screen},
+	{"draw_board", "micro", 1, setup_new_game, draw_board},
+	{"draw_player_X", "micro", 1, setup_new_game, run_draw_player_X},
+	{"draw_player_O", "micro", 1, setup_new_game, run_draw_player_O},
+	{"write_text", "micro", 1, setup_new_game, run_write_text},
+	{"clear_text", "micro", 1, setup_new_game, clear_text},
+	{"check_winner", "micro", 1, setup_midgame, run_check_winner},
+	{"AI_move", "micro", 1, setup_AI_move, run_AI_move},
+	{"scripted_game", "macro", 1, setup_new_game, run_scripted_game},
+	{"ai_game", "macro", 1, setup_new_game, run_ai_game},
+	{"help_toggle", "macro", 1, setup_midgame, run_help_toggle},
+};
+
+// Reads name and ns_per_op pairs from a results file written by this tool
+bool read_baselines(const char *path){
+	FILE *file = fopen(path, "r");
+	if (file == NULL){
+		perror(path);
+		return false;
+	}
+	char line[256];
+	while (fgets(line, sizeof(line), file) != NULL && baseline_total < MAX_BASELINES){
+		bench_baseline *b = &baselines[baseline_total];
+		char *name = strstr(line, "\"name\": \""), *ns = strstr(line, "\"ns_per_op\": ");
+		if (name != NULL && ns != NULL && sscanf(name, "\"name\": \"%63[^\"]\"", b->name) == 1){
+			b->ns_per_op = strtod(ns + strlen("\"ns_per_op\": "), NULL);
+			baseline_total++;
+		}
+	}
+	fclose(file);
+	return true;
+}
+
+double find_baseline(const char *name){
+	for (int i = 0; i < baseline_total; i++){
+		if (strcmp(baselines[i].name, name) == 0){
+			return baselines[i].ns_per_op;
+		}
+	}
+	return 0;
+}
+
+int compare_doubles(const void *a, const void *b){
+	double x = *(const double *) a, y = *(const double *) b;
+	return (x > y) - (x < y);
+}
+
+// Times c: finds how many runs fill a sample, then takes samples of that
+// many. Fills in the fastest and median sample in nanoseconds per operation.
+void measure(bench_case *c, int samples, double *fastest, double *median){
+	double per_op[BENCH_MAX_SAMPLES];
+	int runs = 1;
+
+	c->setup();
+	for (;;){
+		unsigned int start = read_timer();
+		for (int i = 0; i < runs; i++){
+			c->run();
+		}
+		if (start - read_timer() >= BENCH_SAMPLE_TICKS / 4 || runs >= (1 << 24)){
+			runs = (int) ((unsigned long long) runs * BENCH_SAMPLE_TICKS / (start - read_timer() + 1)) + 1;
+			break;
+		}
+		runs *= 4;
+	}
+	for (int s = 0; s < samples; s++){
+		unsigned int start = read_timer();
+		for (int i = 0; i < runs; i++){
+			c->run();
+		}
+		per_op[s] = (double) (start - read_timer()) * 1e9 / TIMER_HZ / runs / c->ops;
+	}
+	qsort(per_op, samples, sizeof(double), compare_doubles);
+	*fastest = per_op[0];
+	*median = per_op[samples / 2];
+}
+
+int main(int argc, char *argv[]){
+	const char *baseline_path = NULL, *save_path = NULL, *filter = NULL;
+	double threshold = BENCH_DEFAULT_THRESHOLD;
+	int samples = BENCH_DEFAULT_SAMPLES;
+
+	for (int i = 1; i + 1 < argc; i += 2){
+		if (strcmp(argv[i], "--baseline") == 0){
+			baseline_path = argv[i + 1];
+		} else if (strcmp(argv[i], "--threshold") == 0){
+			threshold = atof(argv[i + 1]);
+		} else if (strcmp(argv[i], "--save") == 0){
+			save_path = argv[i + 1];
+		} else if (strcmp(argv[i], "--filter") == 0){
+			filter = argv[i + 1];
+		} else if (strcmp(argv[i], "--samples") == 0){
+			samples = atoi(argv[i + 1]);
+		} else {
+			fprintf(stderr, "unknown option %s\n", argv[i]);
+			return 2;
+		}
+	}
+	if (argc % 2 == 0){
+		fprintf(stderr, "usage: %s [--baseline file.json] [--threshold percent] [--save file.json] [--filter text] [--samples n]\n", argv[0]);
+		return 2;
+	}
+	samples = (samples < 1) ? 1 : (samples > BENCH_MAX_SAMPLES ? BENCH_MAX_SAMPLES : samples);
+	if (baseline_path != NULL && !read_baselines(baseline_path)){
+		return 2;
+	}
+
+	// Set up as main does on the board, without keeping the games played
+	game_log_path = "/dev/null";
+	layout_init(&game_layout, GAME_ROWS, GAME_COLS, GAME_K, BOARD_MARGIN, BOARD_MARGIN,
+		screen.width - 2 * BOARD_MARGIN, screen.height - 2 * BOARD_MARGIN);
+	snapshot_init();
+	audio_init();
+	hud_init();
+	start_game_record();
+
+	FILE *save = (save_path != NULL) ? fopen(save_path, "w") : NULL;
+	if (save_path != NULL && save == NULL){
+		perror(save_path);
+		return 2;
+	}
+	int regressions = 0, total = 0;
+	char entry[512];
+	printf("{\n\t\"screen\": \"%dx%d\",\n\t\"samples\": %d,\n\t\"threshold_percent\": %.1f,\n\t\"benchmarks\": [\n",
+		screen.width, screen.height, samples, threshold);
+	if (save != NULL){
+		fprintf(save, "{\n\t\"screen\": \"%dx%d\",\n\t\"benchmarks\": [\n", screen.width, screen.height);
+	}
+	for (int i = 0; i < (int) (sizeof(cases) / sizeof(cases[0])); i++){
+		bench_case *c = &cases[i];
+		if (filter != NULL && strstr(c->name, filter) == NULL){
+			continue;
+		}
+		double fastest, median;
+		measure(c, samples, &fastest, &median);
+
+		double base = find_baseline(c->name);
+		double change = (base > 0) ? (fastest - base) * 100 / base : 0;
+		const char *status = (base <= 0) ? "new" : (change > threshold ? "regressed" : "ok");
+		regressions += change > threshold && base > 0;
+
+		int length = snprintf(entry, sizeof(entry), "\t\t{\"name\": \"%s\", \"kind\": \"%s\", \"ns_per_op\": %.2f, \"median_ns_per_op\": %.2f",
+			c->name, c->kind, fastest, median);
+		if (base > 0){
+			length += snprintf(entry + length, sizeof(entry) - length, ", \"baseline_ns_per_op\": %.2f, \"change_percent\": %.1f", base, change);
+		}
+		printf("%s%s, \"status\": \"%s\"}", (total > 0) ? ",\n" : "", entry, status);
+		if (save != NULL){
+			fprintf(save, "%s\t\t{\"name\": \"%s\", \"kind\": \"%s\", \"ns_per_op\": %.2f}", (total > 0) ? ",\n" : "", c->name, c->kind, fastest);
+		}
+		fprintf(stderr, "%-22s %12.2f ns%s\n", c->name, fastest, strcmp(status, "regressed") == 0 ? "  REGRESSED" : "");
+		total++;
+	}
+	printf("\n\t],\n\t\"regressions\": %d,\n\t\"passed\": %s\n}\n", regressions, (regressions == 0) ? "true" : "false");
+	if (save != NULL){
+		fprintf(save, "\n\t]\n}\n");
+		fclose(save);
+	}
+	fprintf(stderr, "%d benchmarks, %d slower than the baseline by more than %.1f%%\n", total, regressions, threshold);
+	return (regressions == 0) ? 0 : 1;
+}
@@ -0,0 +1,72 @@
+// Times the analysis overlay over random games: each update as the game does
+// it, reusing the table, against nine independent searches, one per empty cell
+// with the table cleared before each. Also counts the labels each update
+// actually writes.
+//
+// Build and run on the host:
+//   gcc -O2 -o bench_analysis tools/bench_analysis.c && ./bench_analysis [games]
+#define HOST_BUILD
+#include "../tic_tac_toe.c"
+
+int main(int argc, char *argv[]){
+	int games = (argc > 1) ? atoi(argv[1]) : 200;
+
+	layout_init(&game_layout, GAME_ROWS, GAME_COLS, GAME_K, BOARD_MARGIN, BOARD_MARGIN,
+		screen.width - 2 * BOARD_MARGIN, screen.height - 2 * BOARD_MARGIN);
+	analysis_toggle();
+
+	analysis_entry *saved = malloc(sizeof(analysis_table));
+	unsigned long long incremental_ticks = 0, independent_ticks = 0, independent_nodes = 0, incremental_nodes = 0;
+	unsigned int updates = 0, repaints = analysis_stats.repaints, cells = 0;
+	srand(1);
+	for (int g = 0; g < games; g++){
+		engine_init(&game_position, GAME_ROWS, GAME_COLS, GAME_K);
+		memset(board, 0, sizeof(board));
+		Turn = 'X';
+		while (winning_line() < 0 && game_position.stones < game_position.cells){
+			int player = (Turn == 'X') ? 1 : 2;
+
+			unsigned int nodes = analysis_stats.nodes, start = read_timer();
+			analysis_update();
+			incremental_ticks += start - read_timer();
+			incremental_nodes += analysis_stats.nodes - nodes;
+			updates++;
+
+			// The same values without the table to share work between cells
+			// or positions. The game's table is put back afterwards.
+			memcpy(saved, analysis_table, sizeof(analysis_table));
+			mnk_board b = game_position;
+			nodes = analysis_stats.nodes;
+			start = read_timer();
+			for (int cell = 0; cell < b.cells; cell++){
+				if (b.cell[cell] == 0){
+					analysis_clear();
+					analysis_start = read_timer();
+					analysis_aborted = false;
+					analysis_cell(&b, cell, player);
+					cells++;
+				}
+			}
+			independent_ticks += start - read_timer();
+			independent_nodes += analysis_stats.nodes - nodes;
+			memcpy(analysis_table, saved, sizeof(analysis_table));
+
+			// A random move
+			int empty[MAX_CELLS], count = 0;
+			for (int cell = 0; cell < game_position.cells; cell++){
+				if (game_position.cell[cell] == 0){
+					empty[count++] = cell;
+				}
+			}
+			int cell = empty[rand() % count];
+			engine_play(&game_position, cell, player);
+			board[cell] = player;
+			Turn = (Turn == 'X') ? 'O' : 'X';
+		}
+	}
+	printf("%d games, %u positions, %u empty cells\n", games, updates, cells);
+	printf("incremental  %8.1f us %8.0f nodes per update\n", incremental_ticks * 1e6 / TIMER_HZ / updates, (double) incremental_nodes / updates);
+	printf("independent  %8.1f us %8.0f nodes per update\n", independent_ticks * 1e6 / TIMER_HZ / updates, (double) independent_nodes / updates);
+	printf("labels written: %.2f per update of %d cells\n", (double) (analysis_stats.repaints - repaints) / updates, game_layout.cells);
+	return 0;
+}
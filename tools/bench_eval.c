@@ -0,0 +1,78 @@
+// Microbenchmark for the incremental evaluator: cost of one
+// engine_play + engine_evaluate + engine_undo (one search node) compared with
+// rescanning every line.
+//
+// Build and run on the host:
+//   gcc -O2 -o bench_eval tools/bench_eval.c && ./bench_eval
+#define HOST_BUILD
+#include "../tic_tac_toe.c"
+
+#define ITERATIONS 10000000
+
+// Fills the board with random stones, alternating players
+void random_position(mnk_board *b, int stones){
+	int player = 1;
+	while (b->stones < stones){
+		int cell = rand() % b->cells;
+		if (b->cell[cell] == 0){
+			engine_play(b, cell, player);
+			player = 3 - player;
+		}
+	}
+}
+
+void bench(int rows, int cols, int k){
+	mnk_board b;
+	unsigned char empty[MAX_CELLS];
+	int empty_total = 0;
+	volatile int sink = 0;
+
+	engine_init(&b, rows, cols, k);
+	random_position(&b, b.cells / 3);
+
+	// The running score has to match a full rescan
+	if (b.score != engine_rescore(&b)){
+		printf("%dx%d k=%d: incremental score %d does not match rescan %d\n", rows, cols, k, b.score, engine_rescore(&b));
+		exit(1);
+	}
+
+	for (int cell = 0; cell < b.cells; cell++){
+		if (b.cell[cell] == 0){
+			empty[empty_total++] = cell;
+		}
+	}
+
+	unsigned int start = read_timer();
+	for (int i = 0; i < ITERATIONS; i++){
+		int cell = empty[i % empty_total];
+		engine_play(&b, cell, 1 + (i & 1));
+		sink += engine_evaluate(&b, 1);
+		engine_undo(&b, cell);
+	}
+	unsigned int incremental = start - read_timer();
+
+	int rescan_iterations = ITERATIONS / 100;
+	start = read_timer();
+	for (int i = 0; i < rescan_iterations; i++){
+		int cell = empty[i % empty_total];
+		b.cell[cell] = 1 + (i & 1);
+		sink += engine_rescore(&b);
+		b.cell[cell] = 0;
+	}
+	unsigned int rescan = start - read_timer();
+
+	double ns_per_tick = 1e9 / TIMER_HZ;
+	printf("%2dx%-2d k=%d  lines %4d  make+eval+unmake %7.1f ns/node  rescan %9.1f ns/node\n",
+		rows, cols, k, b.shape->line_total,
+		incremental * ns_per_tick / ITERATIONS,
+		rescan * ns_per_tick / rescan_iterations);
+}
+
+int main(void){
+	srand(1);
+	bench(3, 3, 3);
+	bench(4, 4, 3);
+	bench(7, 7, 4);
+	bench(15, 15, 5);
+	return 0;
+}
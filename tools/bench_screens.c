@@ -0,0 +1,50 @@
+// Times switching between the game and help screens: drawing both from
+// scratch every time, as the game used to, against restoring the snapshots
+// show_help and hide_help keep.
+//
+// Build and run on the host:
+//   gcc -O2 -o bench_screens tools/bench_screens.c && ./bench_screens [toggles]
+#define HOST_BUILD
+#include "../tic_tac_toe.c"
+
+int main(int argc, char *argv[]){
+	int toggles = (argc > 1) ? atoi(argv[1]) : 1000;
+
+	layout_init(&game_layout, GAME_ROWS, GAME_COLS, GAME_K, BOARD_MARGIN, BOARD_MARGIN,
+		screen.width - 2 * BOARD_MARGIN, screen.height - 2 * BOARD_MARGIN);
+	snapshot_init();
+	Turn = 'X';
+	int moves[5] = {4, 0, 8, 2, 6};
+	for (int i = 0; i < 5; i++){
+		board[moves[i]] = (i % 2 == 0) ? 1 : 2;
+	}
+	draw_game_view();
+
+	unsigned int start = read_timer();
+	for (int i = 0; i < toggles; i++){
+		draw_help_screen();
+		draw_game_view();
+	}
+	double redraw = (start - read_timer()) * 1e6 / TIMER_HZ / toggles / 2;
+
+	for (int i = 0; i < toggles; i++){
+		show_help();
+		hide_help();
+	}
+
+	double open = help_open_stats.total_ticks * 1e6 / TIMER_HZ / help_open_stats.count;
+	double close = help_close_stats.total_ticks * 1e6 / TIMER_HZ / help_close_stats.count;
+	printf("%dx%d, %d byte rows, %d toggles\n", screen.width, screen.height, screen.pitch, toggles);
+	printf("redraw         %8.1f us per switch\n", redraw);
+	printf("snapshot open  %8.1f us per switch (max %.1f, first one draws the help screen)\n",
+		open, help_open_stats.max_ticks * 1e6 / TIMER_HZ);
+	printf("snapshot close %8.1f us per switch (max %.1f)\n", close, help_close_stats.max_ticks * 1e6 / TIMER_HZ);
+
+	// After a move the game screen has to be copied again on the next [H]
+	game_view_changed();
+	start = read_timer();
+	show_help();
+	hide_help();
+	printf("after a move   %8.1f us for both switches\n", (start - read_timer()) * 1e6 / TIMER_HZ);
+	return 0;
+}
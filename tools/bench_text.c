@@ -0,0 +1,77 @@
+// Times the pixel text renderer: the status line and a scaled banner drawn
+// with draw_text against filling their boxes with spans, and against testing
+// every glyph bit and plotting pixels one at a time. --show prints a string
+// as it lands in the pixel buffer.
+//
+// Build and run on the host:
+//   gcc -O2 -o bench_text tools/bench_text.c && ./bench_text [repeats]
+//   ./bench_text --show "text" [scale]
+#define HOST_BUILD
+#include "../tic_tac_toe.c"
+
+// Draws text a pixel at a time straight from the font
+void plot_text(int x, int y, const char *text, int scale, short int colour){
+	for (int i = 0; text[i] != '\0'; i++){
+		const unsigned char *glyph = font_8x8[text[i] - FONT_FIRST];
+		for (int r = 0; r < FONT_SIZE * scale; r++){
+			for (int c = 0; c < FONT_SIZE * scale; c++){
+				if ((glyph[r / scale] >> (c / scale)) & 1){
+					plot_pixel(x + i * FONT_SIZE * scale + c, y + r, colour);
+				}
+			}
+		}
+	}
+}
+
+void bench(const char *name, const char *text, int scale, int repeats){
+	int width = text_width(text, scale), height = FONT_SIZE * scale;
+	
+	unsigned int start = read_timer();
+	for (int i = 0; i < repeats; i++){
+		fill_rect(0, 0, width, height, 0x0000);
+	}
+	double fill = (start - read_timer()) * 1e6 / TIMER_HZ / repeats;
+	
+	start = read_timer();
+	for (int i = 0; i < repeats; i++){
+		plot_text(0, 0, text, scale, 0xF800);
+	}
+	double plotted = (start - read_timer()) * 1e6 / TIMER_HZ / repeats;
+	
+	start = read_timer();
+	for (int i = 0; i < repeats; i++){
+		draw_text(0, 0, text, scale, 0xF800);
+	}
+	double drawn = (start - read_timer()) * 1e6 / TIMER_HZ / repeats;
+	
+	printf("%s: %d characters at scale %d, %dx%d pixels\n", name, (int) strlen(text), scale, width, height);
+	printf("  box fill    %8.2f us\n", fill);
+	printf("  plot pixels %8.2f us\n", plotted);
+	printf("  draw_text   %8.2f us\n", drawn);
+}
+
+// Prints the pixels text covers after draw_text
+int show(const char *text, int scale){
+	fill_rect(0, 0, screen.width, FONT_SIZE * scale, 0x0000);
+	draw_text(0, 0, text, scale, 0xFFFF);
+	int width = (text_width(text, scale) < screen.width) ? text_width(text, scale) : screen.width;
+	for (int y = 0; y < FONT_SIZE * scale; y++){
+		for (int x = 0; x < width; x++){
+			putchar(*(pixel_value *) (screen.base + y * screen.pitch + x * sizeof(pixel_value)) ? '#' : '.');
+		}
+		putchar('\n');
+	}
+	return 0;
+}
+
+int main(int argc, char *argv[]){
+	if (argc >= 3 && strcmp(argv[1], "--show") == 0){
+		return show(argv[2], (argc > 3) ? atoi(argv[3]) : 1);
+	}
+	int repeats = (argc > 1) ? atoi(argv[1]) : 10000;
+	
+	bench("status line", "Player X Wins! Press [spacebar] to start a new game.", 1, repeats);
+	bench("banner", "TIC-TAC-TOE", 3, repeats);
+	printf("layout cache: %u hits, %u misses\n", text_cache_hits, text_cache_misses);
+	return 0;
+}
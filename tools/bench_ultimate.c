@@ -0,0 +1,77 @@
+// Ultimate tic-tac-toe engine: move generator node counts by depth (checked
+// against the published counts to depth 5), random playouts per second
+// from the empty board, and the tree search playing O against random moves
+// with its playouts per second inside the search.
+//
+// Build and run on the host:
+//   gcc -O2 -o bench_ultimate tools/bench_ultimate.c && ./bench_ultimate [playouts [games [budget ms]]]
+#define HOST_BUILD
+#include "../tic_tac_toe.c"
+
+unsigned long long ultimate_perft(const ultimate_board *u, int depth){
+	unsigned char moves[ULTIMATE_CELLS];
+	int count = ultimate_moves(u, moves);
+	if (depth == 1){
+		return count;
+	}
+	unsigned long long nodes = 0;
+	for (int i = 0; i < count; i++){
+		ultimate_board child = *u;
+		ultimate_play(&child, moves[i]);
+		nodes += ultimate_perft(&child, depth - 1);
+	}
+	return nodes;
+}
+
+int main(int argc, char *argv[]){
+	int playouts = (argc > 1) ? atoi(argv[1]) : 1000000;
+	int games = (argc > 2) ? atoi(argv[2]) : 20;
+	unsigned int budget = (argc > 3) ? atoi(argv[3]) * (TIMER_HZ / 1000) : AI_BUDGET_TICKS;
+	ultimate_board empty;
+	ultimate_init(&empty);
+
+	bool ok = true;
+	unsigned long long expected[] = {81, 720, 6336, 55080, 473256};
+	for (int depth = 1; depth <= 5; depth++){
+		unsigned int start = read_timer();
+		unsigned long long nodes = ultimate_perft(&empty, depth);
+		double ms = (start - read_timer()) * 1e3 / TIMER_HZ;
+		bool match = nodes == expected[depth - 1];
+		ok &= match;
+		printf("perft %d %12llu  %8.1f ms%s\n", depth, nodes, ms, match ? "" : "  MISMATCH");
+	}
+
+	unsigned int seed = 1, results[4] = {0}, moves = 0;
+	unsigned int start = read_timer();
+	for (int i = 0; i < playouts; i++){
+		ultimate_board u = empty;
+		results[ultimate_playout(&u, &seed)]++;
+		moves += u.moves;
+	}
+	double seconds = (double) (start - read_timer()) / TIMER_HZ;
+	printf("%d random playouts: %.0f per second, %.1f moves each, X %u O %u tie %u\n", playouts,
+		playouts / seconds, (double) moves / playouts, results[1], results[2], results[3]);
+
+	// The search as O against a random X
+	unsigned int wins[4] = {0};
+	unsigned long long playouts_before = ultimate_stats.total_playouts, ticks_before = ultimate_stats.total_ticks;
+	srand(1);
+	for (int g = 0; g < games; g++){
+		ultimate_board u = empty;
+		unsigned char legal[ULTIMATE_CELLS];
+		while (u.result == 0){
+			if (u.player == 1){
+				ultimate_play(&u, legal[rand() % ultimate_moves(&u, legal)]);
+			} else {
+				ultimate_play(&u, ultimate_search(&u, budget));
+			}
+		}
+		wins[u.result]++;
+	}
+	double search_seconds = (double) (ultimate_stats.total_ticks - ticks_before) / TIMER_HZ;
+	printf("search as O, %.1f ms a move: won %u, lost %u, tied %u of %d; %.0f playouts per second\n",
+		(double) budget * 1e3 / TIMER_HZ, wins[2], wins[1], wins[3], games,
+		(ultimate_stats.total_playouts - playouts_before) / search_seconds);
+	printf("%s\n", ok ? "PASSED" : "FAILED");
+	return ok ? 0 : 1;
+}
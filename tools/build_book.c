@@ -0,0 +1,201 @@
+// Opening book builder. Plays the engine against itself with random moves
+// mixed into the opening, aggregates the results of every game in a game log
+// by position (rotations and reflections counted as one position), and writes
+// the positions as a table sorted by key that book_open maps and book_move
+// binary searches.
+//
+// Build and run on the host:
+//   gcc -O2 -o build_book tools/build_book.c
+//   ./build_book selfplay count games.log [rows cols k [random plies]]
+//   ./build_book build games.log book.bin [plies]
+//   ./build_book test book.bin games.log
+#define HOST_BUILD
+#include "../tic_tac_toe.c"
+
+#define DEFAULT_BOOK_PLIES 8
+
+// Logs count self-play games. Each of the first random_plies moves is a
+// random neighbouring move half of the time so the openings differ.
+int self_play(int count, int rows, int cols, int k, int random_plies){
+	unsigned char moves[MAX_CELLS];
+
+	srand(1);
+	for (int n = 0; n < count; n++){
+		mnk_board b;
+		engine_init(&b, rows, cols, k);
+		current_game.rows = rows;
+		current_game.cols = cols;
+		current_game.k = k;
+		current_game.result = 3;
+		current_game.move_total = 0;
+
+		for (int player = 1; b.stones < b.cells; player = 3 - player){
+			int move;
+			if (b.stones < random_plies && rand() % 2 == 0){
+				move = moves[rand() % generate_moves(&b, moves)];
+			} else {
+				move = search_best_move(&b, player, TIMER_HZ / 5000);
+			}
+			engine_play(&b, move, player);
+			current_game.moves[current_game.move_total++] = move;
+			if (engine_is_win(&b, move)){
+				current_game.result = player;
+				break;
+			}
+		}
+		game_log_append(&current_game);
+	}
+	game_log_flush();
+	printf("log is %u bytes after %d games\n", game_log_length, count);
+	return 0;
+}
+
+int compare_entries(const void *a, const void *b){
+	unsigned long long x = ((const book_entry *) a)->key, y = ((const book_entry *) b)->key;
+	return (x > y) - (x < y);
+}
+
+// Adds a game's result to the entry for key in an open addressing table
+void book_add(book_entry *table, unsigned long long capacity, unsigned long long key, int score, unsigned long long *used){
+	unsigned long long i = key & (capacity - 1);
+	while (table[i].games != 0 && table[i].key != key){
+		i = (i + 1) & (capacity - 1);
+	}
+	if (table[i].games == 0){
+		table[i].key = key;
+		(*used)++;
+	}
+	table[i].games++;
+	table[i].score += score;
+}
+
+// Aggregates the positions after the first plies moves of every game in the
+// log that matches the board size of its first game
+int build(const char *log_path, const char *book_path, int plies){
+	size_t log_size;
+	const unsigned char *log = map_read(log_path, &log_size);
+	if (log == NULL){
+		printf("can't read %s\n", log_path);
+		return 1;
+	}
+
+	// At most plies new positions per game, and the table is kept at most half full
+	game_record g;
+	int length;
+	unsigned long long offset = 0, games = 0;
+	while (offset < log_size && (length = game_record_decode(log + offset, &g)) != 0){
+		offset += length;
+		games++;
+	}
+	unsigned long long capacity = 1024;
+	while (capacity < 2 * games * plies){
+		capacity *= 2;
+	}
+	book_entry *table = calloc(capacity, sizeof(book_entry));
+
+	book_header header = {"TTTBOOK", 0, 0, 0, 0, 0};
+	mnk_board b;
+	unsigned long long used = 0, skipped = 0;
+	unsigned int start = read_timer();
+	offset = 0;
+	while (offset < log_size && (length = game_record_decode(log + offset, &g)) != 0){
+		offset += length;
+		if (header.rows == 0){
+			header.rows = g.rows;
+			header.cols = g.cols;
+			header.k = g.k;
+		}
+		if (g.rows != header.rows || g.cols != header.cols || g.k != header.k || g.result == 0){
+			skipped++;
+			continue;
+		}
+
+		engine_init(&b, g.rows, g.cols, g.k);
+		for (int i = 0; i < g.move_total && i < plies; i++){
+			int mover = (i % 2 == 0) ? 1 : 2;
+			engine_play(&b, g.moves[i], mover);
+			book_add(table, capacity, canonical_key(&b), (g.result == 3) ? 0 : (g.result == mover ? 1 : -1), &used);
+		}
+	}
+
+	// Compact the used slots and sort them for binary search
+	unsigned long long count = 0;
+	for (unsigned long long i = 0; i < capacity; i++){
+		if (table[i].games != 0){
+			table[count++] = table[i];
+		}
+	}
+	qsort(table, count, sizeof(book_entry), compare_entries);
+	header.count = count;
+
+	FILE *file = fopen(book_path, "wb");
+	if (file == NULL || fwrite(&header, sizeof(header), 1, file) != 1 || fwrite(table, sizeof(book_entry), count, file) != count){
+		perror(book_path);
+		return 1;
+	}
+	fclose(file);
+
+	size_t size = sizeof(header) + count * sizeof(book_entry);
+	printf("%dx%d k=%d: %llu games (%llu skipped), first %d plies\n", header.rows, header.cols, header.k, games - skipped, skipped, plies);
+	printf("%llu positions stored, %zu bytes, %.1f bytes per entry, %.3f s\n",
+		count, size, count ? (double) size / count : 0.0, (start - read_timer()) / (double) TIMER_HZ);
+	free(table);
+	return 0;
+}
+
+// Asks the book for a move at every position of every game in the log and
+// reports how often it has one and how long a lookup takes
+int test(const char *book_path, const char *log_path){
+	size_t log_size;
+	const unsigned char *log = map_read(log_path, &log_size);
+	if (log == NULL || !book_open(&book, book_path)){
+		printf("can't read %s or %s\n", book_path, log_path);
+		return 1;
+	}
+
+	game_record g;
+	int length;
+	unsigned long long offset = 0;
+	mnk_board b;
+	unsigned int ticks = 0;
+	int hits_by_ply[MAX_CELLS] = {0}, lookups_by_ply[MAX_CELLS] = {0};
+	while (offset < log_size && (length = game_record_decode(log + offset, &g)) != 0){
+		offset += length;
+		engine_init(&b, g.rows, g.cols, g.k);
+		for (int i = 0; i < g.move_total; i++){
+			unsigned int start = read_timer();
+			int move = book_move(&book, &b);
+			ticks += start - read_timer();
+			lookups_by_ply[i]++;
+			hits_by_ply[i] += (move >= 0);
+			engine_play(&b, g.moves[i], (i % 2 == 0) ? 1 : 2);
+		}
+	}
+
+	for (int ply = 0; ply < MAX_CELLS && hits_by_ply[ply] != 0; ply++){
+		printf("ply %2d: %6.1f%% of %d positions\n", ply, 100.0 * hits_by_ply[ply] / lookups_by_ply[ply], lookups_by_ply[ply]);
+	}
+	printf("%llu positions in the book, %u of %u lookups hit (%.1f%%), %.2f us per lookup\n",
+		book.count, book.hits, book.lookups, book.lookups ? 100.0 * book.hits / book.lookups : 0.0,
+		book.lookups ? ticks * 1e6 / TIMER_HZ / book.lookups : 0.0);
+	return 0;
+}
+
+int main(int argc, char *argv[]){
+	if (argc >= 4 && strcmp(argv[1], "selfplay") == 0){
+		game_log_path = argv[3];
+		bool sized = argc > 6;
+		return self_play(atoi(argv[2]), sized ? atoi(argv[4]) : 3, sized ? atoi(argv[5]) : 3, sized ? atoi(argv[6]) : 3,
+			(argc > 7) ? atoi(argv[7]) : DEFAULT_BOOK_PLIES);
+	}
+	if (argc >= 4 && strcmp(argv[1], "build") == 0){
+		return build(argv[2], argv[3], (argc > 4) ? atoi(argv[4]) : DEFAULT_BOOK_PLIES);
+	}
+	if (argc == 4 && strcmp(argv[1], "test") == 0){
+		return test(argv[2], argv[3]);
+	}
+	printf("usage: %s selfplay count games.log [rows cols k [random plies]]\n", argv[0]);
+	printf("       %s build games.log book.bin [plies]\n", argv[0]);
+	printf("       %s test book.bin games.log\n", argv[0]);
+	return 1;
+}
@@ -0,0 +1,57 @@
+// Runs the game on the host behind the command console, with stdin and
+// stdout in place of the JTAG UART, so sessions can be scripted. The screen
+// is drawn into host memory and can be saved as a PPM at the end.
+//
+// Build and run on the host:
+//   gcc -O2 -o console tools/console.c
+//   printf 'move 5\nai\nstats\nbench draw_board 1000\n' | ./console [screen.ppm]
+#define HOST_BUILD
+#include "../tic_tac_toe.c"
+
+// Saves the pixel buffer, RGB565 widened to 8 bits a channel
+void write_ppm(const char *path){
+	FILE *file = fopen(path, "wb");
+	if (file == NULL){
+		perror(path);
+		return;
+	}
+	fprintf(file, "P6\n%d %d\n255\n", screen.width, screen.height);
+	for (int y = 0; y < screen.height; y++){
+		for (int x = 0; x < screen.width; x++){
+			unsigned short p = *(unsigned short *) (screen.base + y * screen.pitch + x * sizeof(pixel_value));
+			fputc((p >> 11) << 3, file);
+			fputc(((p >> 5) & 0x3F) << 2, file);
+			fputc((p & 0x1F) << 3, file);
+		}
+	}
+	fclose(file);
+}
+
+int main(int argc, char *argv[]){
+	// Set up as main does on the board, straight into a game
+	Turn = 'X';
+	layout_init(&game_layout, GAME_ROWS, GAME_COLS, GAME_K, BOARD_MARGIN, BOARD_MARGIN,
+		screen.width - 2 * BOARD_MARGIN, screen.height - 2 * BOARD_MARGIN);
+	engine_init(&game_position, GAME_ROWS, GAME_COLS, GAME_K);
+	snapshot_init();
+	audio_init();
+	start_game_record();
+	draw_game_view();
+	console_init();
+	
+	int c;
+	while ((c = getchar()) != EOF){
+		console_receive(c);
+		if (c == '\n'){
+			console_poll();
+		}
+	}
+	console_receive('\n');
+	console_poll();
+	putchar('\n');
+	
+	if (argc > 1){
+		write_ppm(argv[1]);
+	}
+	return 0;
+}
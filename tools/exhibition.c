@@ -0,0 +1,30 @@
+// Frame times of exhibition mode for several numbers of boards: the whole
+// frame, the engine's batch and the drawing pass, averaged and at worst,
+// with the moves and games played. The analysis table is cleared before each
+// run so every run starts cold.
+//
+// Build and run on the host:
+//   gcc -O2 -o exhibition tools/exhibition.c && ./exhibition [frames]
+#define HOST_BUILD
+#include "../tic_tac_toe.c"
+
+int main(int argc, char *argv[]){
+	int frames = (argc > 1) ? atoi(argv[1]) : 600;
+	int sizes[] = {1, 2, 4, 9, 16};
+	double us = TIMER_HZ / 1e6;
+
+	printf("boards   frame us    max us     ai us   draw us   moves   games  deferred\n");
+	for (int i = 0; i < (int) (sizeof(sizes) / sizeof(sizes[0])); i++){
+		srand(1);
+		analysis_clear();
+		exhibition_start(sizes[i]);
+		for (int f = 0; f < frames; f++){
+			exhibition_frame();
+		}
+		exhibition_counters *c = &exhibition_stats;
+		printf("%6d %10.1f %9.1f %9.1f %9.1f %7u %7u %9u\n", exhibition_total, c->total_ticks / us / c->frames,
+			c->max_ticks / us, c->ai_ticks / us / c->frames, c->draw_ticks / us / c->frames, c->moves, c->games, c->deferred);
+		exhibition_stop();
+	}
+	return 0;
+}
@@ -0,0 +1,216 @@
+// Game log index. Builds an on-disk hash index from every position of every
+// game in a game log to the offsets of the records that passed through it,
+// and answers "which games reached this position" from it.
+//
+// Build and run on the host:
+//   gcc -O2 -o game_index tools/game_index.c
+//   ./game_index --random count games.log [rows cols k]   write self-play games
+//   ./game_index build games.log games.idx                (re)index the log
+//   ./game_index query games.log games.idx rows cols k [move ...]
+#define HOST_BUILD
+#include "../tic_tac_toe.c"
+
+// Index file header, followed by capacity entries
+typedef struct {
+	char magic[8]; // "TTTGIDX"
+	unsigned long long capacity; // a power of two
+	unsigned long long entries;
+	unsigned long long log_bytes; // how much of the log has been indexed
+} index_header;
+
+// Slots are empty while key is 0. A position has one entry per game.
+typedef struct {
+	unsigned long long key;
+	unsigned long long offset;
+} index_entry;
+
+// Key of a position: the Zobrist hash mixed with the board size so equal
+// stones on different boards don't collide
+unsigned long long position_key(mnk_board *b){
+	unsigned long long key = b->hash ^ ((unsigned long long) (b->rows << 8 | b->cols << 4 | b->k) * 0x9E3779B97F4A7C15ULL);
+	return (key == 0) ? 1 : key;
+}
+
+void index_insert(index_header *header, index_entry *entries, unsigned long long key, unsigned long long offset){
+	unsigned long long i = key & (header->capacity - 1);
+	while (entries[i].key != 0){
+		i = (i + 1) & (header->capacity - 1);
+	}
+	entries[i].key = key;
+	entries[i].offset = offset;
+	header->entries++;
+}
+
+// Counts the positions of the log from offset on (every game adds one per
+// move plus the empty board)
+unsigned long long count_positions(const unsigned char *log, size_t size, unsigned long long offset){
+	unsigned long long positions = 0;
+	game_record g;
+	int length;
+
+	while (offset < size && (length = game_record_decode(log + offset, &g)) != 0){
+		positions += g.move_total + 1;
+		offset += length;
+	}
+	return positions;
+}
+
+// Indexes the part of the log the index hasn't seen yet. The index is rebuilt
+// twice as large when it would become more than half full.
+int build(const char *log_path, const char *index_path){
+	size_t log_size, index_size = 0;
+	const unsigned char *log = map_read(log_path, &log_size);
+	if (log == NULL){
+		printf("can't read %s\n", log_path);
+		return 1;
+	}
+
+	index_header old = {"", 0, 0, 0};
+	index_header *existing = map_read(index_path, &index_size);
+	if (existing != NULL){
+		if (memcmp(existing->magic, "TTTGIDX", 8) == 0 && existing->log_bytes <= log_size){
+			old = *existing;
+		}
+		munmap(existing, index_size);
+	}
+
+	unsigned long long start = old.log_bytes;
+	unsigned long long needed = old.entries + count_positions(log, log_size, start);
+	unsigned long long capacity = old.capacity;
+	if (capacity < 2 * needed){
+		capacity = 1024;
+		while (capacity < 2 * needed){
+			capacity *= 2;
+		}
+		start = 0;
+	}
+
+	index_size = sizeof(index_header) + capacity * sizeof(index_entry);
+	int fd = open(index_path, O_RDWR | O_CREAT | (start == 0 ? O_TRUNC : 0), 0644);
+	if (fd < 0 || ftruncate(fd, index_size) != 0){
+		perror(index_path);
+		return 1;
+	}
+	index_header *header = mmap(NULL, index_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	close(fd);
+	if (header == MAP_FAILED){
+		perror("mmap");
+		return 1;
+	}
+	index_entry *entries = (index_entry *) (header + 1);
+	if (start == 0){
+		memcpy(header->magic, "TTTGIDX", 8);
+		header->capacity = capacity;
+		header->entries = 0;
+	}
+
+	unsigned long long offset = start, games = 0;
+	game_record g;
+	int length;
+	mnk_board b;
+	while (offset < log_size && (length = game_record_decode(log + offset, &g)) != 0){
+		engine_init(&b, g.rows, g.cols, g.k);
+		index_insert(header, entries, position_key(&b), offset);
+		for (int i = 0; i < g.move_total; i++){
+			engine_play(&b, g.moves[i], (i % 2 == 0) ? 1 : 2);
+			index_insert(header, entries, position_key(&b), offset);
+		}
+		offset += length;
+		games++;
+	}
+	header->log_bytes = offset;
+
+	printf("indexed %llu games (%llu bytes of log) from offset %llu, %llu entries in %llu slots\n",
+		games, offset - start, start, header->entries, header->capacity);
+	munmap(header, index_size);
+	return 0;
+}
+
+// Prints every game that reached the position given by the moves
+int query(const char *log_path, const char *index_path, int rows, int cols, int k, int move_total, char *moves[]){
+	size_t log_size, index_size;
+	const unsigned char *log = map_read(log_path, &log_size);
+	index_header *header = map_read(index_path, &index_size);
+	if (log == NULL || header == NULL || memcmp(header->magic, "TTTGIDX", 8) != 0){
+		printf("can't read %s or %s\n", log_path, index_path);
+		return 1;
+	}
+	index_entry *entries = (index_entry *) (header + 1);
+
+	mnk_board b;
+	engine_init(&b, rows, cols, k);
+	for (int i = 0; i < move_total; i++){
+		engine_play(&b, atoi(moves[i]), (i % 2 == 0) ? 1 : 2);
+	}
+	unsigned long long key = position_key(&b);
+
+	unsigned int start = read_timer();
+	unsigned long long matches = 0;
+	char *results[4] = {"unfinished", "X won", "O won", "tie"};
+	for (unsigned long long i = key & (header->capacity - 1); entries[i].key != 0; i = (i + 1) & (header->capacity - 1)){
+		if (entries[i].key != key || entries[i].offset >= header->log_bytes){
+			continue;
+		}
+
+		game_record g;
+		game_record_decode(log + entries[i].offset, &g);
+		printf("offset %10llu  %-10s ", entries[i].offset, results[g.result]);
+		for (int m = 0; m < g.move_total; m++){
+			printf(" %d", g.moves[m]);
+		}
+		printf("\n");
+		matches++;
+	}
+	printf("%llu games, %.1f us\n", matches, (start - read_timer()) * 1e6 / TIMER_HZ);
+	return 0;
+}
+
+// Logs count games of the engine playing itself with a tiny time budget and
+// a random opening move so the games differ
+int write_random_games(int count, int rows, int cols, int k){
+	srand(1);
+	for (int n = 0; n < count; n++){
+		mnk_board b;
+		engine_init(&b, rows, cols, k);
+		current_game.rows = rows;
+		current_game.cols = cols;
+		current_game.k = k;
+		current_game.result = 3;
+		current_game.move_total = 0;
+
+		for (int player = 1; b.stones < b.cells; player = 3 - player){
+			int move = rand() % b.cells;
+			if (b.stones > 0 || rows * cols > 9){
+				move = search_best_move(&b, player, TIMER_HZ / 5000);
+			}
+			engine_play(&b, move, player);
+			current_game.moves[current_game.move_total++] = move;
+			if (engine_is_win(&b, move)){
+				current_game.result = player;
+				break;
+			}
+		}
+		game_log_append(&current_game);
+	}
+	game_log_flush();
+	printf("log is %u bytes after %d games\n", game_log_length, count);
+	return 0;
+}
+
+int main(int argc, char *argv[]){
+	if (argc >= 4 && strcmp(argv[1], "--random") == 0){
+		game_log_path = argv[3];
+		bool sized = argc > 6;
+		return write_random_games(atoi(argv[2]), sized ? atoi(argv[4]) : 3, sized ? atoi(argv[5]) : 3, sized ? atoi(argv[6]) : 3);
+	}
+	if (argc == 4 && strcmp(argv[1], "build") == 0){
+		return build(argv[2], argv[3]);
+	}
+	if (argc >= 7 && strcmp(argv[1], "query") == 0){
+		return query(argv[2], argv[3], atoi(argv[4]), atoi(argv[5]), atoi(argv[6]), argc - 7, argv + 7);
+	}
+	printf("usage: %s --random count games.log [rows cols k]\n", argv[0]);
+	printf("       %s build games.log games.idx\n", argv[0]);
+	printf("       %s query games.log games.idx rows cols k [move ...]\n", argv[0]);
+	return 1;
+}
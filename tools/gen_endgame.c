@@ -0,0 +1,194 @@
+// Endgame database generator. Every position of an m,n,k board (up to 25
+// cells) is solved by retrograde analysis, one stone count at a time from the
+// full board back to the empty one, with the positions of each stone count
+// shared out between threads. The win/draw/loss values are written at 2 bits
+// per position into a memory-mapped file that endgame_open maps at runtime.
+//
+// Build and run on the host:
+//   gcc -O2 -pthread -o gen_endgame tools/gen_endgame.c
+//   ./gen_endgame 4 4 3 endgame_4x4_3.db [threads]
+//
+// Sizes: 3x3 is 1.5 KB, 4x4 is 2.4 MB and 5x5 is 38 GB.
+#define HOST_BUILD
+#include "../tic_tac_toe.c"
+
+#define MAX_GEN_THREADS 64
+
+// A range of positions with the same number of stones solved by one thread
+typedef struct {
+	endgame_db *db;
+	unsigned char *values;
+	int stones;
+	unsigned long long first, last;
+	unsigned long long count[4]; // positions found with each value
+} layer_job;
+
+const mnk_shape *lines; // the engine's line tables for the board being solved
+
+// Inverse of endgame_rank for a position with the given number of stones
+void endgame_unrank(endgame_db *db, int stones, unsigned long long rank, char *cell){
+	int x = (stones + 1) / 2, o = stones / 2;
+	unsigned long long o_total = binomial[db->cells - x][o];
+	unsigned long long x_rank = rank / o_total, o_rank = rank % o_total;
+	int free_index[MAX_DB_CELLS];
+	int free_cells = 0;
+
+	memset(cell, 0, db->cells);
+	for (int i = db->cells - 1; x > 0; i--){
+		if (binomial[i][x] <= x_rank){
+			x_rank -= binomial[i][x];
+			cell[i] = 1;
+			x--;
+		}
+	}
+
+	for (int i = 0; i < db->cells; i++){
+		if (cell[i] == 0){
+			free_index[free_cells++] = i;
+		}
+	}
+	for (int i = free_cells - 1; o > 0; i--){
+		if (binomial[i][o] <= o_rank){
+			o_rank -= binomial[i][o];
+			cell[free_index[i]] = 2;
+			o--;
+		}
+	}
+}
+
+// Checks whether player has k in a row anywhere, using the engine's line table
+bool has_line(endgame_db *db, const char *cell, int player){
+	for (int line = 0; line < lines->line_total; line++){
+		int i = 0;
+		while (i < db->k && cell[lines->line_cells[line][i]] == player){
+			i++;
+		}
+		if (i == db->k){
+			return true;
+		}
+	}
+	return false;
+}
+
+// Value of one position for the side to move, from its children's values
+int solve_position(endgame_db *db, const unsigned char *values, char *cell, int stones){
+	int mover = (stones % 2 == 0) ? 1 : 2;
+	bool last_mover_won = has_line(db, cell, 3 - mover);
+
+	// Both players with a line, or the mover with one, can't happen in a game
+	if (has_line(db, cell, mover)){
+		return ENDGAME_UNKNOWN;
+	}
+	if (last_mover_won){
+		return ENDGAME_LOSS;
+	}
+	if (stones == db->cells){
+		return ENDGAME_DRAW;
+	}
+
+	int best = ENDGAME_LOSS;
+	for (int i = 0; i < db->cells && best != ENDGAME_WIN; i++){
+		if (cell[i] != 0){
+			continue;
+		}
+		cell[i] = mover;
+		unsigned long long child = endgame_rank(db, cell);
+		int value = ENDGAME_WIN + ENDGAME_LOSS - ((values[child >> 2] >> ((child & 3) * 2)) & 3);
+		cell[i] = 0;
+
+		if (value > best){
+			best = value;
+		}
+	}
+	return best;
+}
+
+void *solve_range(void *arg){
+	layer_job *job = (layer_job *) arg;
+	char cell[MAX_DB_CELLS];
+
+	for (unsigned long long index = job->first; index < job->last; index++){
+		endgame_unrank(job->db, job->stones, index - job->db->layer_offset[job->stones], cell);
+		int value = solve_position(job->db, job->values, cell, job->stones);
+
+		// Ranges start on byte boundaries so no other thread writes this byte
+		job->values[index >> 2] |= value << ((index & 3) * 2);
+		job->count[value]++;
+	}
+	return NULL;
+}
+
+int main(int argc, char *argv[]){
+	if (argc < 5){
+		printf("usage: %s rows cols k output [threads]\n", argv[0]);
+		return 1;
+	}
+
+	int rows = atoi(argv[1]), cols = atoi(argv[2]), k = atoi(argv[3]);
+	int threads = (argc > 5) ? atoi(argv[5]) : (int) sysconf(_SC_NPROCESSORS_ONLN);
+	endgame_db db;
+
+	if (rows * cols > MAX_DB_CELLS || (k > rows && k > cols) || threads < 1 || threads > MAX_GEN_THREADS){
+		printf("unsupported board or thread count\n");
+		return 1;
+	}
+	endgame_layout(&db, rows, cols, k);
+	lines = engine_shape(rows, cols, k);
+
+	// The output file is mapped and filled in place
+	size_t size = sizeof(endgame_header) + (db.total + 3) / 4;
+	unsigned char *image = map_create(argv[4], size);
+	if (image == NULL){
+		return 1;
+	}
+
+	endgame_header *header = (endgame_header *) image;
+	memcpy(header->magic, "TTTEGDB", 8);
+	header->rows = rows;
+	header->cols = cols;
+	header->k = k;
+	header->total = db.total;
+	unsigned char *values = image + sizeof(endgame_header);
+
+	printf("%dx%d k=%d: %llu positions, %llu bytes, %d threads\n", rows, cols, k, db.total, (unsigned long long) size, threads);
+	unsigned int start = read_timer();
+
+	for (int stones = db.cells; stones >= 0; stones--){
+		unsigned long long first = db.layer_offset[stones], last = db.layer_offset[stones + 1];
+		unsigned long long step = ((last - first + threads - 1) / threads + 3) & ~3ULL;
+		layer_job jobs[MAX_GEN_THREADS];
+		pthread_t workers[MAX_GEN_THREADS];
+		int started = 0;
+
+		for (int t = 0; t < threads; t++){
+			// Inner boundaries are multiples of 4 so threads never share a
+			// byte. Small layers leave the last threads nothing to do.
+			unsigned long long begin = (first & ~3ULL) + t * step;
+			unsigned long long end = (t == threads - 1) ? last : begin + step;
+			begin = (begin < first) ? first : begin;
+			end = (end < last) ? end : last;
+			if (begin >= end){
+				continue;
+			}
+			jobs[started] = (layer_job) {&db, values, stones, begin, end, {0, 0, 0, 0}};
+			pthread_create(&workers[started], NULL, solve_range, &jobs[started]);
+			started++;
+		}
+
+		unsigned long long count[4] = {0, 0, 0, 0};
+		for (int t = 0; t < started; t++){
+			pthread_join(workers[t], NULL);
+			for (int v = 0; v < 4; v++){
+				count[v] += jobs[t].count[v];
+			}
+		}
+		printf("stones %2d: %12llu win %12llu draw %12llu loss %12llu unreachable\n",
+			stones, count[ENDGAME_WIN], count[ENDGAME_DRAW], count[ENDGAME_LOSS], count[ENDGAME_UNKNOWN]);
+	}
+
+	char *names[4] = {"unknown", "loss", "draw", "win"};
+	printf("empty board: %s for X, %.2f s\n", names[(values[0] & 3)], (start - read_timer()) / (double) TIMER_HZ);
+
+	munmap(image, size);
+	return 0;
+}
@@ -0,0 +1,229 @@
+// Perft: enumerates the game tree of an m,n,k board ply by ply and counts
+// the positions at every ply and the finished games. A game ends as soon as
+// someone completes a line or the board is full. Counts are checked against
+// known values where there are any, so this is both a regression test and a
+// benchmark of move generation and win detection.
+//
+// On 3x3 the whole tree is also walked with the game's own board[],
+// check_winner and checkforStalemate, which have to agree with the engine.
+//
+// Build and run on the host:
+//   gcc -O2 -pthread -o perft tools/perft.c
+//   ./perft [rows cols k [depth [threads [dedupe]]]]
+// With dedupe set to 1 every position is only counted (and expanded) once.
+#define HOST_BUILD
+#include "../tic_tac_toe.c"
+
+#define MAX_PERFT_THREADS 64
+#define PERFT_HASH_SIZE (1 << 24)
+
+// Known results for 3x3 tic-tac-toe, per ply
+unsigned long long reference_nodes[10] = {1, 9, 72, 504, 3024, 15120, 54720, 148176, 200448, 127872};
+unsigned long long reference_unique[10] = {1, 9, 72, 252, 756, 1260, 1520, 1140, 390, 78};
+#define REFERENCE_GAMES 255168ULL
+#define REFERENCE_X_WINS 131184ULL
+#define REFERENCE_O_WINS 77904ULL
+#define REFERENCE_DRAWS 46080ULL
+
+// One thread of the enumeration
+typedef struct {
+	mnk_board board;
+	unsigned long long nodes[MAX_CELLS + 1];
+	unsigned long long games;
+} perft_worker;
+
+int perft_depth;
+bool perft_dedupe;
+unsigned int perft_next_job; // next root move to take
+unsigned int perft_job_total;
+unsigned char perft_jobs[MAX_CELLS];
+unsigned long long *perft_seen; // hashes of positions already counted
+
+// Adds a hash to the shared set, returns false if it was already there
+bool perft_insert(unsigned long long hash){
+	unsigned long long key = (hash == 0) ? 1 : hash;
+	unsigned int i = (unsigned int) (key % PERFT_HASH_SIZE);
+
+	while (1){
+		unsigned long long current = perft_seen[i];
+		if (current == key){
+			return false;
+		}
+		if (current == 0 && __sync_bool_compare_and_swap(&perft_seen[i], 0, key)){
+			return true;
+		}
+		if (perft_seen[i] == key){
+			return false;
+		}
+		i = (i + 1) % PERFT_HASH_SIZE;
+	}
+}
+
+void perft(perft_worker *w, int ply, int player){
+	mnk_board *b = &w->board;
+
+	if (perft_dedupe && !perft_insert(b->hash)){
+		return;
+	}
+	w->nodes[ply]++;
+	if (ply == perft_depth){
+		return;
+	}
+
+	for (int cell = 0; cell < b->cells; cell++){
+		if (b->cell[cell] != 0){
+			continue;
+		}
+		engine_play(b, cell, player);
+		if (engine_is_win(b, cell) || b->stones == b->cells){
+			if (!perft_dedupe || perft_insert(b->hash)){
+				w->nodes[ply + 1]++;
+				w->games++;
+			}
+		} else {
+			perft(w, ply + 1, 3 - player);
+		}
+		engine_undo(b, cell);
+	}
+}
+
+// Takes root moves until there are none left
+void *perft_thread(void *arg){
+	perft_worker *w = (perft_worker *) arg;
+
+	while (1){
+		unsigned int job = __sync_fetch_and_add(&perft_next_job, 1);
+		if (job >= perft_job_total){
+			return NULL;
+		}
+		int cell = perft_jobs[job];
+		engine_play(&w->board, cell, 1);
+		if (engine_is_win(&w->board, cell) || w->board.stones == w->board.cells){
+			w->nodes[1]++;
+			w->games++;
+		} else {
+			perft(w, 1, 2);
+		}
+		engine_undo(&w->board, cell);
+	}
+}
+
+unsigned long long check_games, check_x_wins, check_o_wins, check_draws, check_disagreements;
+
+// Walks the 3x3 tree with the game's own board[] and check_winner
+void check_game_logic(mnk_board *b, int player){
+	for (int i = 0; i < 9; i++){
+		if (board[i] != 0){
+			continue;
+		}
+		board[i] = player;
+		engine_play(b, i, player);
+
+		int winner = check_winner();
+		int expected = engine_is_win(b, i) ? player : (b->stones == 9 ? 3 : 0);
+		if (winner != expected){
+			check_disagreements++;
+		}
+
+		if (winner == 0){
+			check_game_logic(b, 3 - player);
+		} else {
+			check_games++;
+			check_x_wins += (winner == 1);
+			check_o_wins += (winner == 2);
+			check_draws += (winner == 3);
+		}
+
+		engine_undo(b, i);
+		board[i] = 0;
+	}
+}
+
+// Prints a count next to its reference, returns false on a mismatch
+bool report(char *name, unsigned long long count, unsigned long long reference, bool has_reference){
+	if (!has_reference){
+		printf("%-14s %14llu\n", name, count);
+		return true;
+	}
+	printf("%-14s %14llu  expected %14llu  %s\n", name, count, reference, (count == reference) ? "ok" : "MISMATCH");
+	return count == reference;
+}
+
+int main(int argc, char *argv[]){
+	int rows = (argc > 3) ? atoi(argv[1]) : 3;
+	int cols = (argc > 3) ? atoi(argv[2]) : 3;
+	int k = (argc > 3) ? atoi(argv[3]) : 3;
+	int threads = (argc > 5) ? atoi(argv[5]) : (int) sysconf(_SC_NPROCESSORS_ONLN);
+	perft_dedupe = (argc > 6) && atoi(argv[6]) != 0;
+	perft_depth = (argc > 4) ? atoi(argv[4]) : rows * cols;
+	bool known = (rows == 3 && cols == 3 && k == 3);
+	bool passed = true;
+	static perft_worker workers[MAX_PERFT_THREADS];
+	pthread_t thread_ids[MAX_PERFT_THREADS];
+
+	if (rows > MAX_ROWS || cols > MAX_COLS || k > MAX_K || perft_depth < 1 || perft_depth > rows * cols || threads < 1 || threads > MAX_PERFT_THREADS){
+		printf("usage: %s [rows cols k [depth [threads [dedupe]]]]\n", argv[0]);
+		return 1;
+	}
+	if (perft_dedupe){
+		perft_seen = calloc(PERFT_HASH_SIZE, sizeof(unsigned long long));
+	}
+
+	for (int t = 0; t < threads; t++){
+		engine_init(&workers[t].board, rows, cols, k);
+	}
+	for (int cell = 0; cell < rows * cols; cell++){
+		perft_jobs[perft_job_total++] = cell;
+	}
+	if (perft_dedupe){
+		perft_insert(workers[0].board.hash);
+	}
+
+	printf("%dx%d k=%d depth %d, %d threads%s\n", rows, cols, k, perft_depth, threads, perft_dedupe ? ", unique positions" : "");
+	unsigned int start = read_timer();
+	for (int t = 0; t < threads; t++){
+		pthread_create(&thread_ids[t], NULL, perft_thread, &workers[t]);
+	}
+
+	unsigned long long nodes[MAX_CELLS + 1] = {1}, games = 0, total = 1;
+	for (int t = 0; t < threads; t++){
+		pthread_join(thread_ids[t], NULL);
+		for (int ply = 1; ply <= perft_depth; ply++){
+			nodes[ply] += workers[t].nodes[ply];
+			total += workers[t].nodes[ply];
+		}
+		games += workers[t].games;
+	}
+	double seconds = (start - read_timer()) / (double) TIMER_HZ;
+
+	for (int ply = 0; ply <= perft_depth; ply++){
+		char name[20];
+		sprintf(name, "ply %d", ply);
+		passed &= report(name, nodes[ply], perft_dedupe ? reference_unique[ply] : reference_nodes[ply], known);
+	}
+	passed &= report("games", games, REFERENCE_GAMES, known && !perft_dedupe && perft_depth == 9);
+	printf("%llu nodes in %.3f s, %.0f nodes/s\n", total, seconds, total / seconds);
+
+	// The game's own win and stalemate checks against the engine
+	if (known){
+		mnk_board b;
+		engine_init(&b, 3, 3, 3);
+		layout_init(&game_layout, GAME_ROWS, GAME_COLS, GAME_K, BOARD_MARGIN, BOARD_MARGIN,
+			SCREEN_WIDTH - 2 * BOARD_MARGIN, SCREEN_HEIGHT - 2 * BOARD_MARGIN);
+		memset(board, 0, sizeof(board));
+		start = read_timer();
+		check_game_logic(&b, 1);
+		seconds = (start - read_timer()) / (double) TIMER_HZ;
+
+		printf("\ncheck_winner / checkforStalemate over every game:\n");
+		passed &= report("games", check_games, REFERENCE_GAMES, true);
+		passed &= report("X wins", check_x_wins, REFERENCE_X_WINS, true);
+		passed &= report("O wins", check_o_wins, REFERENCE_O_WINS, true);
+		passed &= report("draws", check_draws, REFERENCE_DRAWS, true);
+		passed &= report("disagreements", check_disagreements, 0, true);
+		printf("%.3f s, %.0f games/s\n", seconds, check_games / seconds);
+	}
+
+	printf("%s\n", passed ? "PASSED" : "FAILED");
+	return passed ? 0 : 1;
+}
@@ -0,0 +1,257 @@
+// Splash screen converter. Decodes an 8-bit PNG (grey, RGB, palette, with or
+// without alpha, not interlaced), optionally scales it to a new size, turns it
+// into RGB565 and writes it as runs of equal pixels (length, colour) that
+// never cross the end of a row, as a header for SPLASH_HEADER.
+//
+// --welcome encodes the welcome screen the game draws from lines instead of a
+// PNG. --bench times the first frame drawn the old way against decoding the
+// runs of the welcome screen or a PNG.
+//
+// Build and run on the host:
+//   gcc -O2 -o png2rle tools/png2rle.c -lz
+//   ./png2rle help.png splash.h [width height]
+//   ./png2rle --welcome splash.h
+//   ./png2rle --bench [image.png]
+//   gcc ... -I. -DSPLASH_HEADER='"splash.h"' tic_tac_toe.c
+#include <zlib.h>
+#define HOST_BUILD
+#include "../tic_tac_toe.c"
+
+// An image in RGB565
+typedef struct {
+	int width, height;
+	unsigned short *pixels;
+} rgb565_image;
+
+static unsigned int read_be32(const unsigned char *p){
+	return (unsigned int) p[0] << 24 | p[1] << 16 | p[2] << 8 | p[3];
+}
+
+static int paeth(int a, int b, int c){
+	int p = a + b - c, pa = abs(p - a), pb = abs(p - b), pc = abs(p - c);
+	return (pa <= pb && pa <= pc) ? a : (pb <= pc ? b : c);
+}
+
+static unsigned short rgb565(int r, int g, int b){
+	return (unsigned short) ((r >> 3) << 11 | (g >> 2) << 5 | (b >> 3));
+}
+
+// Reads a PNG, compositing any alpha over black. Returns false if the file
+// isn't a PNG this decoder handles.
+bool read_png(const char *path, rgb565_image *image){
+	FILE *file = fopen(path, "rb");
+	if (file == NULL){
+		perror(path);
+		return false;
+	}
+	fseek(file, 0, SEEK_END);
+	long size = ftell(file);
+	fseek(file, 0, SEEK_SET);
+	unsigned char *data = malloc(size);
+	if (fread(data, 1, size, file) != (size_t) size || size < 33 || memcmp(data, "\x89PNG\r\n\x1a\n", 8) != 0){
+		printf("%s is not a PNG\n", path);
+		fclose(file);
+		return false;
+	}
+	fclose(file);
+
+	unsigned char palette[256][3] = {{0}};
+	unsigned char *compressed = malloc(size);
+	unsigned long compressed_size = 0;
+	int width = 0, height = 0, depth = 0, colour_type = 0, interlace = 0;
+	for (long at = 8; at + 12 <= size; ){
+		unsigned int length = read_be32(data + at);
+		const unsigned char *type = data + at + 4, *body = data + at + 8;
+		if (memcmp(type, "IHDR", 4) == 0){
+			width = read_be32(body);
+			height = read_be32(body + 4);
+			depth = body[8];
+			colour_type = body[9];
+			interlace = body[12];
+		} else if (memcmp(type, "PLTE", 4) == 0){
+			memcpy(palette, body, (length <= sizeof(palette)) ? length : sizeof(palette));
+		} else if (memcmp(type, "IDAT", 4) == 0){
+			memcpy(compressed + compressed_size, body, length);
+			compressed_size += length;
+		}
+		at += 12 + length;
+	}
+
+	int channels[7] = {1, 0, 3, 1, 2, 0, 4};
+	if (depth != 8 || interlace != 0 || colour_type > 6 || channels[colour_type] == 0){
+		printf("%s: only 8-bit, non-interlaced PNGs are supported\n", path);
+		return false;
+	}
+	int bytes = channels[colour_type], stride = width * bytes;
+	unsigned long raw_size = (unsigned long) height * (stride + 1);
+	unsigned char *raw = malloc(raw_size);
+	if (uncompress(raw, &raw_size, compressed, compressed_size) != Z_OK){
+		printf("%s: corrupt image data\n", path);
+		return false;
+	}
+
+	// Undo the per-row filters in place
+	for (int y = 0; y < height; y++){
+		unsigned char *row = raw + y * (stride + 1) + 1, *above = row - stride - 1;
+		int filter = row[-1];
+		for (int i = 0; i < stride; i++){
+			int left = (i >= bytes) ? row[i - bytes] : 0;
+			int up = (y > 0) ? above[i] : 0;
+			int corner = (y > 0 && i >= bytes) ? above[i - bytes] : 0;
+			int predicted = (filter == 1) ? left : (filter == 2) ? up : (filter == 3) ? (left + up) / 2 : (filter == 4) ? paeth(left, up, corner) : 0;
+			row[i] = (unsigned char) (row[i] + predicted);
+		}
+	}
+
+	image->width = width;
+	image->height = height;
+	image->pixels = malloc(sizeof(unsigned short) * width * height);
+	for (int y = 0; y < height; y++){
+		unsigned char *row = raw + y * (stride + 1) + 1;
+		for (int x = 0; x < width; x++){
+			unsigned char *p = row + x * bytes;
+			int r, g, b, a = 255;
+			if (colour_type == 3){
+				r = palette[p[0]][0];
+				g = palette[p[0]][1];
+				b = palette[p[0]][2];
+			} else if (colour_type == 0 || colour_type == 4){
+				r = g = b = p[0];
+				a = (colour_type == 4) ? p[1] : 255;
+			} else {
+				r = p[0];
+				g = p[1];
+				b = p[2];
+				a = (colour_type == 6) ? p[3] : 255;
+			}
+			image->pixels[y * width + x] = rgb565(r * a / 255, g * a / 255, b * a / 255);
+		}
+	}
+	free(data);
+	free(compressed);
+	free(raw);
+	return true;
+}
+
+// Nearest neighbour scaling
+void scale_image(rgb565_image *image, int width, int height){
+	unsigned short *pixels = malloc(sizeof(unsigned short) * width * height);
+	for (int y = 0; y < height; y++){
+		for (int x = 0; x < width; x++){
+			pixels[y * width + x] = image->pixels[(y * image->height / height) * image->width + x * image->width / width];
+		}
+	}
+	free(image->pixels);
+	image->pixels = pixels;
+	image->width = width;
+	image->height = height;
+}
+
+// The welcome screen as the game draws it, read back from the host buffer
+void render_welcome(rgb565_image *image){
+	draw_welcome_art();
+	image->width = SCREEN_WIDTH;
+	image->height = SCREEN_HEIGHT;
+	image->pixels = malloc(sizeof(unsigned short) * SCREEN_WIDTH * SCREEN_HEIGHT);
+	for (int y = 0; y < SCREEN_HEIGHT; y++){
+		memcpy(image->pixels + y * SCREEN_WIDTH, screen.base + y * screen.pitch, SCREEN_WIDTH * sizeof(unsigned short));
+	}
+}
+
+// Encodes the image into runs, returns the number of shorts written
+int encode_runs(rgb565_image *image, unsigned short *runs){
+	int total = 0;
+	for (int y = 0; y < image->height; y++){
+		unsigned short *row = image->pixels + y * image->width;
+		for (int x = 0; x < image->width; ){
+			int length = 1;
+			while (x + length < image->width && row[x + length] == row[x]){
+				length++;
+			}
+			runs[total++] = length;
+			runs[total++] = row[x];
+			x += length;
+		}
+	}
+	return total;
+}
+
+int write_header(const char *path, const char *source, rgb565_image *image){
+	unsigned short *runs = malloc(sizeof(unsigned short) * 2 * image->width * image->height);
+	int total = encode_runs(image, runs);
+	FILE *file = fopen(path, "w");
+	if (file == NULL){
+		perror(path);
+		return 1;
+	}
+
+	fprintf(file, "// Generated by tools/png2rle from %s\n", source);
+	fprintf(file, "#define SPLASH_WIDTH %d\n#define SPLASH_HEIGHT %d\n", image->width, image->height);
+	fprintf(file, "const unsigned short splash_rle[%d] = {", total);
+	for (int i = 0; i < total; i += 2){
+		fprintf(file, "%s%d, 0x%04X,", (i % 16 == 0) ? "\n\t" : " ", runs[i], runs[i + 1]);
+	}
+	fprintf(file, "\n};\n");
+	fclose(file);
+
+	printf("%dx%d, %d runs, %d bytes (%.1f%% of %d bytes raw)\n", image->width, image->height, total / 2,
+		total * 2, 100.0 * total / (image->width * image->height), image->width * image->height * 2);
+	return 0;
+}
+
+// Time to first frame: the welcome screen drawn from lines against decoding
+// the image's runs
+int bench(rgb565_image *image, int frames){
+	unsigned short *runs = malloc(sizeof(unsigned short) * 2 * image->width * image->height);
+	int total = encode_runs(image, runs);
+
+	unsigned int start = read_timer();
+	for (int i = 0; i < frames; i++){
+		draw_welcome_art();
+	}
+	double lines = (start - read_timer()) * 1e6 / TIMER_HZ / frames;
+
+	start = read_timer();
+	for (int i = 0; i < frames; i++){
+		draw_rle_image(runs, image->width, image->height, 0, 0);
+	}
+	double decode = (start - read_timer()) * 1e6 / TIMER_HZ / frames;
+
+	printf("%dx%d image, %d runs\n", image->width, image->height, total / 2);
+	printf("fill and lines %8.1f us per frame\n", lines);
+	printf("run decode     %8.1f us per frame\n", decode);
+	return 0;
+}
+
+int main(int argc, char *argv[]){
+	rgb565_image image;
+
+	if (argc >= 2 && strcmp(argv[1], "--bench") == 0){
+		if (argc == 2){
+			render_welcome(&image);
+		} else if (!read_png(argv[2], &image)){
+			return 1;
+		}
+		if (image.width > screen.width || image.height > screen.height){
+			scale_image(&image, screen.width, image.height * screen.width / image.width);
+		}
+		return bench(&image, 1000);
+	}
+	if (argc == 3 && strcmp(argv[1], "--welcome") == 0){
+		render_welcome(&image);
+		return write_header(argv[2], "the welcome screen", &image);
+	}
+	if (argc == 3 || argc == 5){
+		if (!read_png(argv[1], &image)){
+			return 1;
+		}
+		if (argc == 5){
+			scale_image(&image, atoi(argv[3]), atoi(argv[4]));
+		}
+		return write_header(argv[2], argv[1], &image);
+	}
+	printf("usage: %s image.png output.h [width height]\n", argv[0]);
+	printf("       %s --welcome output.h\n", argv[0]);
+	printf("       %s --bench [image.png]\n", argv[0]);
+	return 1;
+}
@@ -0,0 +1,126 @@
+// Qubic engine checks and speed. Counts the positions at every depth of the
+// game tree (perft), which must be 64 * 63 * ... until a line can first be
+// finished at ply 7, checks there are 76 lines, and checks the win test
+// against scanning the cube cell by cell over random games. Then times the
+// search: nodes per second, and its games as O against random moves.
+//
+// Build and run on the host:
+//   gcc -O2 -o qubic_perft tools/qubic_perft.c && ./qubic_perft [depth [games [budget ms]]]
+#define HOST_BUILD
+#include "../tic_tac_toe.c"
+
+// Positions depth plies below b. Finished games have none, and the last ply
+// is counted from the empty cells without playing it.
+unsigned long long qubic_perft(const qubic_board *b, int depth){
+	unsigned long long empty = ~(b->stones[0] | b->stones[1]);
+	if (b->result != 0){
+		return 0;
+	}
+	if (depth == 1){
+		return __builtin_popcountll(empty);
+	}
+	unsigned long long nodes = 0;
+	for (; empty != 0; empty &= empty - 1){
+		qubic_board child = *b;
+		qubic_play(&child, __builtin_ctzll(empty));
+		nodes += qubic_perft(&child, depth - 1);
+	}
+	return nodes;
+}
+
+// Whether player has four in a row anywhere, straight from coordinates
+bool scan_win(const qubic_board *b, int player){
+	for (int dz = -1; dz <= 1; dz++) for (int dy = -1; dy <= 1; dy++) for (int dx = -1; dx <= 1; dx++){
+		if (dx == 0 && dy == 0 && dz == 0){
+			continue;
+		}
+		for (int cell = 0; cell < QUBIC_CELLS; cell++){
+			int i = 0;
+			while (i < 4){
+				int x = cell % 4 + i * dx, y = cell / 4 % 4 + i * dy, z = cell / 16 + i * dz;
+				if (x < 0 || x > 3 || y < 0 || y > 3 || z < 0 || z > 3 || !(b->stones[player - 1] >> (z * 16 + y * 4 + x) & 1)){
+					break;
+				}
+				i++;
+			}
+			if (i == 4){
+				return true;
+			}
+		}
+	}
+	return false;
+}
+
+int main(int argc, char *argv[]){
+	int max_depth = (argc > 1) ? atoi(argv[1]) : 5;
+	int games = (argc > 2) ? atoi(argv[2]) : 10;
+	unsigned int budget = (argc > 3) ? atoi(argv[3]) * (TIMER_HZ / 1000) : AI_BUDGET_TICKS;
+	qubic_board empty;
+	qubic_init(&empty);
+	bool ok = true;
+
+	int lines = 0;
+	while (lines < QUBIC_LINES && qubic_line[lines] != 0){
+		lines++;
+	}
+	ok &= lines == QUBIC_LINES;
+	printf("%d lines%s\n", lines, (lines == QUBIC_LINES) ? "" : "  MISMATCH");
+
+	unsigned long long expected = 1;
+	for (int depth = 1; depth <= max_depth; depth++){
+		expected *= QUBIC_CELLS - depth + 1;
+		unsigned int start = read_timer();
+		unsigned long long nodes = qubic_perft(&empty, depth);
+		double seconds = (double) (start - read_timer()) / TIMER_HZ;
+		bool match = depth >= 7 || nodes == expected;
+		ok &= match;
+		printf("perft %d %16llu  %8.3f s  %6.1f M/s%s\n", depth, nodes, seconds, nodes / seconds / 1e6, match ? "" : "  MISMATCH");
+	}
+
+	// The table's win test against the scan, after every move of random games
+	srand(1);
+	unsigned int positions = 0, wrong = 0;
+	for (int g = 0; g < 20000; g++){
+		qubic_board b = empty;
+		while (b.result == 0){
+			int cell;
+			do {
+				cell = rand() % QUBIC_CELLS;
+			} while ((b.stones[0] | b.stones[1]) >> cell & 1);
+			int player = b.player;
+			qubic_play(&b, cell);
+			wrong += (b.result == player) != scan_win(&b, player);
+			positions++;
+		}
+	}
+	ok &= wrong == 0;
+	printf("win test: %u positions, %u wrong\n", positions, wrong);
+
+	// The search as O against a random X
+	unsigned int results[4] = {0};
+	for (int g = 0; g < games; g++){
+		qubic_board b = empty;
+		while (b.result == 0){
+			unsigned long long free_cells = ~(b.stones[0] | b.stones[1]);
+			int cell;
+			if (b.player == 1){
+				do {
+					cell = rand() % QUBIC_CELLS;
+				} while (!(free_cells >> cell & 1));
+			} else {
+				cell = qubic_search(&b, budget);
+			}
+			qubic_play(&b, cell);
+		}
+		results[b.result]++;
+	}
+	printf("search as O, %.1f ms a move: won %u, lost %u, tied %u of %d; %.0f nodes per second\n",
+		(double) budget * 1e3 / TIMER_HZ, results[2], results[1], results[3], games,
+		qubic_stats.total_nodes * (double) TIMER_HZ / qubic_stats.total_ticks);
+
+	// Depth reached from the empty cube with a second to think
+	qubic_search(&empty, TIMER_HZ);
+	printf("empty cube, 1 s: depth %d, %u nodes\n", qubic_stats.depth, qubic_stats.nodes);
+	printf("%s\n", ok ? "PASSED" : "FAILED");
+	return ok ? 0 : 1;
+}
@@ -0,0 +1,39 @@
+// Runs the proof-number solver on gomoku (15x15, k=5) positions reached by
+// letting the alpha-beta search play itself, and reports positions per second
+// and proof tree size for every position until a forced win is proven.
+//
+// Build and run on the host:
+//   gcc -O2 -pthread -o solve_gomoku tools/solve_gomoku.c && ./solve_gomoku [seconds per position]
+#define HOST_BUILD
+#include "../tic_tac_toe.c"
+
+int main(int argc, char *argv[]){
+	double seconds = (argc > 1) ? atof(argv[1]) : 1.0;
+	mnk_board b;
+	int player = 1;
+
+	engine_init(&b, 15, 15, 5);
+	printf("%d solver threads, %d table entries (%u KB)\n", PNS_THREADS, PNS_TABLE_SIZE, (unsigned int) (sizeof(pns_table) / 1024));
+
+	while (b.stones < b.cells){
+		int move = pns_solve(&b, player, (unsigned int) (seconds * TIMER_HZ));
+		char *result = (pns_stats.result == 1) ? "win" : (pns_stats.result == 0 ? "no win" : "unknown");
+
+		printf("stones %3d  %c to move  %-7s  nodes %9u  %9u pos/s  proof tree %6u  table used %8u\n",
+			b.stones, (player == 1) ? 'X' : 'O', result, pns_stats.nodes,
+			pns_stats.positions_per_second, pns_stats.proof_size, pns_stats.table_used);
+		if (move >= 0){
+			printf("%c wins starting at row %d column %d\n", (player == 1) ? 'X' : 'O', move / b.cols, move % b.cols);
+			return 0;
+		}
+
+		move = search_best_move(&b, player, TIMER_HZ / 10);
+		engine_play(&b, move, player);
+		if (engine_is_win(&b, move)){
+			printf("%c completed a line without a proof\n", (player == 1) ? 'X' : 'O');
+			return 0;
+		}
+		player = 3 - player;
+	}
+	return 0;
+}
@@ -0,0 +1,219 @@
+// Worst case stack use of each interrupt handler, from the call graph and
+// frame sizes GCC writes with -fcallgraph-info=su. A handler's bound is its
+// own frame plus the deepest chain of direct calls below it. A function that
+// calls itself (negamax) is counted depth times; other cycles and calls
+// through function pointers aren't followed and are flagged, as are library
+// calls, whose frames GCC doesn't know.
+//
+// Build the game with the board's compiler and flags plus -fcallgraph-info=su,
+// then on the host:
+//   gcc -O2 -o stack_report tools/stack_report.c
+//   ./stack_report tic_tac_toe.ci [--depth n] [function ...]
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MAX_FUNCTIONS 2048
+#define MAX_CALLS 16384
+#define MAX_NAME 256
+#define DEFAULT_DEPTH 33 // MAX_DEPTH + 1 plies of negamax
+
+typedef struct {
+	char title[MAX_NAME]; // what edges refer to, file:name for static functions
+	int bytes; // -1 if GCC knows nothing about the frame (library functions)
+	bool dynamic; // alloca or variable length arrays
+	int first_call, call_total; // into callees, sorted by caller
+	int worst; // bound including callees, -1 until worked out
+	int next; // callee on the deepest chain, -1 for none
+	bool visiting;
+	bool cycle; // a call back into a function being worked out was cut
+	bool unknown; // a callee without a known frame was reached
+} function_info;
+
+typedef struct {
+	int caller, callee;
+} call_edge;
+
+function_info functions[MAX_FUNCTIONS];
+int function_total;
+call_edge calls[MAX_CALLS];
+int call_total;
+int recursion_depth = DEFAULT_DEPTH;
+
+// Copies the quoted value after key on the line, returns false if missing
+bool quoted(const char *line, const char *key, char *value){
+	const char *p = strstr(line, key);
+	if (p == NULL){
+		return false;
+	}
+	p += strlen(key);
+	int n = 0;
+	while (*p != '\0' && *p != '"' && n < MAX_NAME - 1){
+		value[n++] = *p++;
+	}
+	value[n] = '\0';
+	return true;
+}
+
+int find_function(const char *title){
+	for (int i = 0; i < function_total; i++){
+		if (strcmp(functions[i].title, title) == 0){
+			return i;
+		}
+	}
+	return -1;
+}
+
+// Finds a function by its plain name, static ones included
+int find_by_name(const char *name){
+	int i = find_function(name);
+	for (int j = 0; i < 0 && j < function_total; j++){
+		const char *colon = strrchr(functions[j].title, ':');
+		if (colon != NULL && strcmp(colon + 1, name) == 0){
+			i = j;
+		}
+	}
+	return i;
+}
+
+int add_function(const char *title){
+	int i = find_function(title);
+	if (i >= 0 || function_total == MAX_FUNCTIONS){
+		return i;
+	}
+	i = function_total++;
+	memset(&functions[i], 0, sizeof(function_info));
+	strcpy(functions[i].title, title);
+	functions[i].bytes = -1;
+	functions[i].worst = -1;
+	functions[i].next = -1;
+	return i;
+}
+
+int compare_calls(const void *a, const void *b){
+	return ((const call_edge *) a)->caller - ((const call_edge *) b)->caller;
+}
+
+bool read_graph(const char *path){
+	FILE *file = fopen(path, "r");
+	if (file == NULL){
+		perror(path);
+		return false;
+	}
+	char line[4096], title[MAX_NAME], label[MAX_NAME], target[MAX_NAME];
+	while (fgets(line, sizeof(line), file) != NULL){
+		if (strncmp(line, "node:", 5) == 0 && quoted(line, "title: \"", title)){
+			int i = add_function(title);
+			const char *bytes = quoted(line, "label: \"", label) ? strstr(line, " bytes (") : NULL;
+			if (i >= 0 && bytes != NULL){
+				while (bytes > line && bytes[-1] >= '0' && bytes[-1] <= '9'){
+					bytes--;
+				}
+				functions[i].bytes = atoi(bytes);
+				functions[i].dynamic = strstr(line, "bytes (dynamic") != NULL;
+			}
+		} else if (strncmp(line, "edge:", 5) == 0 && quoted(line, "sourcename: \"", title) && quoted(line, "targetname: \"", target)){
+			int caller = add_function(title), callee = add_function(target);
+			if (caller >= 0 && callee >= 0 && call_total < MAX_CALLS){
+				calls[call_total++] = (call_edge) {caller, callee};
+			}
+		}
+	}
+	fclose(file);
+
+	qsort(calls, call_total, sizeof(call_edge), compare_calls);
+	for (int i = 0; i < call_total; i++){
+		function_info *f = &functions[calls[i].caller];
+		if (f->call_total++ == 0){
+			f->first_call = i;
+		}
+	}
+	return true;
+}
+
+// Bound on the stack used by a call to f, filling in its deepest chain
+int worst_case(int f){
+	function_info *info = &functions[f];
+	if (info->worst >= 0){
+		return info->worst;
+	}
+	if (info->visiting){
+		return 0;
+	}
+	info->visiting = true;
+
+	int frame = (info->bytes > 0) ? info->bytes : 0, deepest = 0;
+	bool recursive = false;
+	for (int i = info->first_call; i < info->first_call + info->call_total; i++){
+		int callee = calls[i].callee;
+		if (callee == f){
+			recursive = true;
+			continue;
+		}
+		if (functions[callee].visiting){
+			info->cycle = true;
+			continue;
+		}
+		int below = worst_case(callee);
+		info->cycle |= functions[callee].cycle;
+		info->unknown |= functions[callee].unknown || functions[callee].bytes < 0;
+		if (below > deepest){
+			deepest = below;
+			info->next = callee;
+		}
+	}
+
+	info->visiting = false;
+	info->worst = frame * (recursive ? recursion_depth : 1) + deepest;
+	return info->worst;
+}
+
+void report(int f){
+	int total = worst_case(f);
+	function_info *info = &functions[f];
+
+	printf("%-24s %7d bytes%s%s%s\n", info->title, total, info->cycle ? "  (cycle cut)" : "",
+		info->unknown ? "  (library calls not counted)" : "", info->dynamic ? "  (dynamic frame)" : "");
+	for (int g = f; g >= 0; g = functions[g].next){
+		bool recursive = false;
+		for (int i = functions[g].first_call; i < functions[g].first_call + functions[g].call_total; i++){
+			recursive |= calls[i].callee == g;
+		}
+		printf("    %6d  %s%s\n", functions[g].bytes, functions[g].title, recursive ? " (recursive)" : "");
+	}
+}
+
+int main(int argc, char *argv[]){
+	if (argc < 2){
+		printf("usage: %s file.ci [--depth n] [function ...]\n", argv[0]);
+		return 1;
+	}
+	if (!read_graph(argv[1])){
+		return 1;
+	}
+
+	int first = 2;
+	if (argc > 3 && strcmp(argv[2], "--depth") == 0){
+		recursion_depth = atoi(argv[3]);
+		first = 4;
+	}
+	const char *handlers[] = {"__cs3_isr_irq", "keyboard_ISR", "console_ISR", "audio_ISR"};
+	const char **names = handlers;
+	int name_total = sizeof(handlers) / sizeof(handlers[0]);
+	if (argc > first){
+		names = (const char **) argv + first;
+		name_total = argc - first;
+	}
+
+	printf("%d functions, %d calls, recursion counted %d deep\n", function_total, call_total, recursion_depth);
+	for (int i = 0; i < name_total; i++){
+		int f = find_by_name(names[i]);
+		if (f < 0){
+			printf("%-24s not in the call graph\n", names[i]);
+			continue;
+		}
+		report(f);
+	}
+	return 0;
+}
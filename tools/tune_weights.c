@@ -0,0 +1,222 @@
+// Evaluation weight tuner. Every position of every finished game in a game log
+// becomes a training sample: the difference in open lines with c stones
+// between X and O for each c below k, and the game's result for X. The
+// weights are fitted Texel style, minimising the squared error between the
+// result and sigmoid(scale * evaluation), with the error and its gradient
+// summed over the positions in parallel. The weights are written as a header
+// for TUNED_WEIGHTS_HEADER.
+//
+// Build and run on the host:
+//   gcc -O2 -pthread -o tune_weights tools/tune_weights.c -lm
+//   ./build_book selfplay 20000 games.log 7 7 4
+//   ./tune_weights games.log tuned_weights.h [passes [threads]]
+//   gcc -O2 -I. -DTUNED_WEIGHTS_HEADER='"tuned_weights.h"' ...
+#include <math.h>
+#define HOST_BUILD
+#include "../tic_tac_toe.c"
+
+#define MAX_TUNE_THREADS 64
+#define DEFAULT_PASSES 300
+#define LEARNING_RATE 0.05
+
+// One training position. feature[c] is X's open lines with c stones minus O's.
+typedef struct {
+	short feature[MAX_K];
+	float result; // 1 X won, 0.5 draw, 0 O won
+} tuning_sample;
+
+// The part of the samples one thread sums over
+typedef struct {
+	unsigned long long first, last;
+	double error;
+	double gradient[MAX_K];
+} tuning_job;
+
+tuning_sample *samples;
+unsigned long long sample_total;
+int feature_total; // k, features 1 to k - 1 are used
+double weights[MAX_K];
+double scale;
+
+// Error of the samples in the job's range and its gradient with respect to
+// the log of each weight
+void *tuning_pass(void *arg){
+	tuning_job *job = (tuning_job *) arg;
+
+	job->error = 0;
+	memset(job->gradient, 0, sizeof(job->gradient));
+	for (unsigned long long i = job->first; i < job->last; i++){
+		tuning_sample *s = &samples[i];
+		double evaluation = 0;
+		for (int c = 1; c < feature_total; c++){
+			evaluation += weights[c] * s->feature[c];
+		}
+
+		double predicted = 1 / (1 + exp(-scale * evaluation));
+		double difference = s->result - predicted;
+		job->error += difference * difference;
+
+		double slope = -2 * difference * predicted * (1 - predicted) * scale;
+		for (int c = 1; c < feature_total; c++){
+			job->gradient[c] += slope * s->feature[c] * weights[c];
+		}
+	}
+	return NULL;
+}
+
+// Mean squared error over every sample, filling gradient if it isn't NULL
+double tuning_error(int threads, double *gradient){
+	tuning_job jobs[MAX_TUNE_THREADS];
+	pthread_t workers[MAX_TUNE_THREADS];
+	unsigned long long shard = (sample_total + threads - 1) / threads;
+	double error = 0;
+
+	for (int t = 0; t < threads; t++){
+		unsigned long long first = t * shard, last = first + shard;
+		jobs[t].first = (first < sample_total) ? first : sample_total;
+		jobs[t].last = (last < sample_total) ? last : sample_total;
+		pthread_create(&workers[t], NULL, tuning_pass, &jobs[t]);
+	}
+	if (gradient != NULL){
+		memset(gradient, 0, MAX_K * sizeof(double));
+	}
+	for (int t = 0; t < threads; t++){
+		pthread_join(workers[t], NULL);
+		error += jobs[t].error;
+		for (int c = 0; gradient != NULL && c < feature_total; c++){
+			gradient[c] += jobs[t].gradient[c] / sample_total;
+		}
+	}
+	return error / sample_total;
+}
+
+// Turns every position before the last move of every finished game of the
+// log's first board size into a sample
+bool load_samples(const char *path, int *rows, int *cols, int *k){
+	size_t size;
+	const unsigned char *log = map_read(path, &size);
+	if (log == NULL){
+		printf("can't read %s\n", path);
+		return false;
+	}
+
+	game_record g;
+	int length;
+	unsigned long long offset = 0, capacity = 0;
+	while (offset < size && (length = game_record_decode(log + offset, &g)) != 0){
+		offset += length;
+		capacity += g.move_total;
+	}
+	samples = malloc(capacity * sizeof(tuning_sample));
+
+	mnk_board b;
+	*rows = 0;
+	offset = 0;
+	while (offset < size && (length = game_record_decode(log + offset, &g)) != 0){
+		offset += length;
+		if (*rows == 0){
+			*rows = g.rows;
+			*cols = g.cols;
+			*k = g.k;
+			feature_total = g.k;
+		}
+		if (g.rows != *rows || g.cols != *cols || g.k != *k || g.result == 0){
+			continue;
+		}
+
+		float result = (g.result == 1) ? 1 : (g.result == 2 ? 0 : 0.5f);
+		engine_init(&b, g.rows, g.cols, g.k);
+		for (int i = 0; i < g.move_total - 1; i++){
+			engine_play(&b, g.moves[i], (i % 2 == 0) ? 1 : 2);
+			tuning_sample *s = &samples[sample_total++];
+			for (int c = 0; c < MAX_K; c++){
+				s->feature[c] = (c < g.k) ? b.open_lines[0][c] - b.open_lines[1][c] : 0;
+			}
+			s->result = result;
+		}
+	}
+	munmap((void *) log, size);
+	return sample_total > 0;
+}
+
+int main(int argc, char *argv[]){
+	if (argc < 3){
+		printf("usage: %s games.log output.h [passes [threads]]\n", argv[0]);
+		return 1;
+	}
+	int passes = (argc > 3) ? atoi(argv[3]) : DEFAULT_PASSES;
+	int threads = (argc > 4) ? atoi(argv[4]) : (int) sysconf(_SC_NPROCESSORS_ONLN);
+	if (threads < 1 || threads > MAX_TUNE_THREADS){
+		threads = 1;
+	}
+
+	int rows, cols, k;
+	unsigned int start = read_timer();
+	if (!load_samples(argv[1], &rows, &cols, &k)){
+		return 1;
+	}
+	printf("%llu positions of %dx%d k=%d games, %.2f s to load, %d threads\n",
+		sample_total, rows, cols, k, (start - read_timer()) / (double) TIMER_HZ, threads);
+
+	// Start from the engine's own weights
+	mnk_board b;
+	engine_init(&b, rows, cols, k);
+	for (int c = 0; c < k; c++){
+		weights[c] = b.shape->line_weight[c];
+	}
+
+	// Fit the sigmoid's scale to the starting weights (golden section search
+	// on its logarithm) and keep it fixed while the weights move
+	double low = -12, high = 0, ratio = (sqrt(5) - 1) / 2;
+	for (int i = 0; i < 40; i++){
+		double a = high - ratio * (high - low), c = low + ratio * (high - low);
+		scale = pow(10, a);
+		double error_a = tuning_error(threads, NULL);
+		scale = pow(10, c);
+		double error_c = tuning_error(threads, NULL);
+		if (error_a < error_c){
+			high = c;
+		} else {
+			low = a;
+		}
+	}
+	scale = pow(10, (low + high) / 2);
+	double initial_error = tuning_error(threads, NULL);
+	printf("scale %.3g, starting error %.6f\n", scale, initial_error);
+
+	// Adam on the log of each weight keeps them positive and copes with
+	// weights many orders of magnitude apart
+	double gradient[MAX_K], moment[MAX_K] = {0}, variance[MAX_K] = {0};
+	double error = initial_error;
+	start = read_timer();
+	for (int pass = 1; pass <= passes; pass++){
+		error = tuning_error(threads, gradient);
+		for (int c = 1; c < k; c++){
+			moment[c] = 0.9 * moment[c] + 0.1 * gradient[c];
+			variance[c] = 0.999 * variance[c] + 0.001 * gradient[c] * gradient[c];
+			double step = LEARNING_RATE * (moment[c] / (1 - pow(0.9, pass))) / (sqrt(variance[c] / (1 - pow(0.999, pass))) + 1e-12);
+			weights[c] *= exp(-step);
+		}
+		if (pass % 50 == 0 || pass == passes){
+			printf("pass %4d: error %.6f\n", pass, error);
+		}
+	}
+	double seconds = (start - read_timer()) / (double) TIMER_HZ;
+	printf("%.6f -> %.6f in %.2f s, %.0f positions/s\n", initial_error, error, seconds, sample_total * (double) passes / seconds);
+
+	FILE *file = fopen(argv[2], "w");
+	if (file == NULL){
+		perror(argv[2]);
+		return 1;
+	}
+	fprintf(file, "// Generated by tools/tune_weights from %llu positions of %dx%d k=%d games\n", sample_total, rows, cols, k);
+	fprintf(file, "// (error %.6f, was %.6f with the default weights)\n", error, initial_error);
+	fprintf(file, "#define TUNED_K %d\n#define TUNED_LINE_WEIGHTS {0", k);
+	for (int c = 1; c < k; c++){
+		fprintf(file, ", %ld", lround(weights[c]) > 0 ? lround(weights[c]) : 1);
+		printf("%d stones: %8d -> %8ld\n", c, b.shape->line_weight[c], lround(weights[c]));
+	}
+	fprintf(file, "}\n");
+	fclose(file);
+	return 0;
+}